@@ -0,0 +1,202 @@
+#!/bin/bash
+
+# Parameter autotuner for DynaFlow
+# Random search over the engine's runtime parameters (hybrid_accelerated
+# --list-params) against the traces in 'tests'. Reports the Pareto front of
+# throughput vs fast-path share vs engine memory, and writes the best
+# configuration per dataset as a --params file.
+#
+# Usage: ./autotune.sh [configs] [seed]
+#   configs  Random configurations to try besides the defaults (default 24)
+#   seed     Search seed, so a run can be reproduced (default 1)
+#
+# Environment: ENGINE (default ./hybrid_accelerated), TUNE_DIR (default
+# autotune_results), TUNE_REPS (runs per measurement, best Mpps kept;
+# default 1)
+
+CONFIGS=${1:-24}
+SEED=${2:-1}
+ENGINE=${ENGINE:-./hybrid_accelerated}
+TUNE_DIR=${TUNE_DIR:-autotune_results}
+TUNE_REPS=${TUNE_REPS:-1}
+
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+datasets=(
+    "tests/dataset_uniform.txt"
+    "tests/dataset_web.txt"
+    "tests/dataset_datacenter.txt"
+    "tests/dataset_ddos.txt"
+    "tests/dataset_streaming.txt"
+    "tests/dataset_iot.txt"
+    "tests/dataset_gaming.txt"
+    "tests/dataset_cdn.txt"
+    "tests/dataset_enterprise.txt"
+    "tests/dataset_pareto.txt"
+)
+
+if [ ! -x "$ENGINE" ]; then
+    echo -e "${RED}❌ $ENGINE not found (run make first)${NC}"
+    exit 1
+fi
+
+# Print a tab-separated table with aligned columns
+show_table() {
+    awk -F'\t' '{
+        printf "  %-20s", $1
+        for (i = 2; i <= NF; i++) printf " %16s", $i
+        printf "\n"
+    }' "$1"
+}
+
+mkdir -p "$TUNE_DIR/configs" "$TUNE_DIR/best"
+rm -f "$TUNE_DIR"/configs/*.params "$TUNE_DIR"/best/*.params
+
+# Configuration 000 is the built-in defaults; the rest are sampled. Sizes
+# are powers of 2, thresholds are kept ordered so every sample is valid.
+awk -v configs="$CONFIGS" -v seed="$SEED" -v dir="$TUNE_DIR/configs" '
+function pick(lo, hi) { return lo + int(rand() * (hi - lo + 1)) }
+BEGIN {
+    srand(seed)
+    printf "# defaults\n" > (dir "/cfg_000.params")
+    for (c = 1; c <= configs; c++) {
+        file = sprintf("%s/cfg_%03d.params", dir, c)
+        split("5000 10000 25000 50000 100000", aging, " ")
+        split("25 50 100 200 400 1000", burst, " ")
+        split("65536 131072 262144 524288 1048576", idle, " ")
+        split("32 64 128 256", budget, " ")
+        split("0.80 0.90 0.95 1", evict, " ")
+        fast_track = pick(40, 80)
+        ultra = pick(fast_track + 5, fast_track + 30)
+        if (ultra > 100) ultra = 100
+        cached_ultra = 0.60 + 0.35 * rand()
+        cached_fast = cached_ultra - 0.05 - 0.25 * rand()
+        cached_accel = cached_fast - 0.05 - 0.25 * rand()
+        if (cached_accel < 0) cached_accel = 0
+        printf "cache_size=%d\n", 2 ^ pick(10, 15) > file
+        printf "prediction_cache_size=%d\n", 2 ^ pick(8, 13) > file
+        printf "sketch_width=%d\n", 2 ^ pick(10, 15) > file
+        printf "sketch_depth=%d\n", pick(1, 5) > file
+        printf "aging_interval=%d\n", aging[pick(1, 5)] > file
+        printf "idle_timeout=%d\n", idle[pick(1, 5)] > file
+        printf "maint_interval=%d\n", 2 ^ pick(5, 7) > file
+        printf "maint_budget=%d\n", budget[pick(1, 4)] > file
+        printf "evict_target=%s\n", evict[pick(1, 4)] > file
+        printf "confidence_fast_track=%d\n", fast_track > file
+        printf "confidence_ultra_fast=%d\n", ultra > file
+        printf "cached_ultra_fast=%.2f\n", cached_ultra > file
+        printf "cached_fast=%.2f\n", cached_fast > file
+        printf "cached_accelerated=%.2f\n", cached_accel > file
+        printf "burst_threshold=%d\n", burst[pick(1, 6)] > file
+        close(file)
+    }
+}'
+
+RESULTS="$TUNE_DIR/results.tsv"
+printf "config\tdataset\tmpps\tfast_share\tmemory_bytes\n" > "$RESULTS"
+
+echo -e "${BLUE}🔧 Tuning $((CONFIGS + 1)) configurations x ${#datasets[@]} datasets (seed $SEED)${NC}"
+for params in "$TUNE_DIR"/configs/cfg_*.params; do
+    config=$(basename "$params" .params)
+    for dataset in "${datasets[@]}"; do
+        [ -f "$dataset" ] || continue
+        name=$(basename "$dataset" .txt)
+        best_mpps=0
+        for ((rep = 0; rep < TUNE_REPS; rep++)); do
+            output=$("$ENGINE" --prefault --params "$params" "$dataset" 2>&1)
+            mpps=$(echo "$output" | grep "Throughput:" | awk '{print $2}')
+            best_mpps=$(awk -v a="$best_mpps" -v b="${mpps:-0}" 'BEGIN {print (b > a) ? b : a}')
+        done
+        # Fast-path share counts both the fast and ultra-fast paths
+        share=$(echo "$output" | grep -E "^  (Fast|Ultra-Fast) " |
+            awk '{gsub(/[()%]/, "", $NF); s += $NF} END {printf "%.2f", s}')
+        memory=$(echo "$output" | grep "Engine Memory:" | awk '{print $3}')
+        printf "%s\t%s\t%s\t%s\t%s\n" "$config" "$name" "$best_mpps" "$share" "${memory:-0}" >> "$RESULTS"
+    done
+    echo "  $config done"
+done
+
+# Pareto front over the configurations: mean Mpps and mean fast share across
+# datasets (higher is better) vs engine memory (lower is better)
+echo ""
+echo -e "${BLUE}📈 Pareto front (all datasets)${NC}"
+{
+printf "config\tmean_mpps\tmean_fast_share\tmemory_mb\n"
+awk -F'\t' '
+NR > 1 {
+    mpps[$1] += $3; share[$1] += $4; runs[$1]++
+    if ($5 > mem[$1]) mem[$1] = $5
+}
+END {
+    for (c in runs) { mpps[c] /= runs[c]; share[c] /= runs[c] }
+    for (c in runs) {
+        dominated = 0
+        for (o in runs) {
+            if (o != c && mpps[o] >= mpps[c] && share[o] >= share[c] &&
+                mem[o] <= mem[c] && (mpps[o] > mpps[c] ||
+                share[o] > share[c] || mem[o] < mem[c])) {
+                dominated = 1
+                break
+            }
+        }
+        if (!dominated)
+            printf "%s\t%.2f\t%.2f\t%.2f\n", c, mpps[c], share[c], mem[c] / 1048576
+    }
+}' "$RESULTS" | sort -t$'\t' -k2,2nr
+} > "$TUNE_DIR/pareto.tsv"
+show_table "$TUNE_DIR/pareto.tsv"
+
+# Per dataset: restrict to that dataset's Pareto front, then ship the
+# configuration with the most fast-path packets per second (Mpps x share),
+# preferring less memory on ties
+echo ""
+echo -e "${BLUE}🏁 Best configuration per dataset${NC}"
+{
+printf "dataset\tconfig\tmpps\tfast_share\tmemory_mb\tfront_size\n"
+awk -F'\t' '
+NR > 1 {
+    n = ++count[$2]; cfg[$2, n] = $1
+    mpps[$2, n] = $3; share[$2, n] = $4; mem[$2, n] = $5
+}
+END {
+    for (d in count) {
+        best = 0; front = 0
+        for (i = 1; i <= count[d]; i++) {
+            dominated = 0
+            for (j = 1; j <= count[d]; j++) {
+                if (j != i && mpps[d, j] >= mpps[d, i] &&
+                    share[d, j] >= share[d, i] && mem[d, j] <= mem[d, i] &&
+                    (mpps[d, j] > mpps[d, i] || share[d, j] > share[d, i] ||
+                     mem[d, j] < mem[d, i])) {
+                    dominated = 1
+                    break
+                }
+            }
+            if (dominated)
+                continue
+            front++
+            score = mpps[d, i] * share[d, i]
+            if (!best || score > best_score ||
+                (score == best_score && mem[d, i] < mem[d, best])) {
+                best = i; best_score = score
+            }
+        }
+        printf "%s\t%s\t%s\t%s\t%.2f\t%d\n", d, cfg[d, best], mpps[d, best],
+               share[d, best], mem[d, best] / 1048576, front
+    }
+}' "$RESULTS" | sort
+} > "$TUNE_DIR/best.tsv"
+show_table "$TUNE_DIR/best.tsv"
+
+tail -n +2 "$TUNE_DIR/best.tsv" | while IFS=$'\t' read -r name config mpps share memory front; do
+    {
+        echo "# $name: $config, $mpps Mpps, $share% fast path, $memory MB"
+        grep -v "^#" "$TUNE_DIR/configs/$config.params"
+    } > "$TUNE_DIR/best/$name.params"
+done
+
+echo ""
+echo -e "${GREEN}✅ Results in $TUNE_DIR (load with: $ENGINE --params $TUNE_DIR/best/<dataset>.params)${NC}"
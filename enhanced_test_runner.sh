@@ -84,7 +84,7 @@ fi
 echo "🔧 Checking dataset generator..."
 if [ ! -f "multi_dataset_generator" ]; then
     echo "   Compiling multi_dataset_tester.c..."
-    gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2
+    gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2 -pthread
     if [ $? -ne 0 ]; then
         echo -e "${RED}❌ Failed to compile dataset generator${NC}"
         exit 1
@@ -1,4 +1,8 @@
+#define _GNU_SOURCE // M_PI
+
 #include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,17 +35,36 @@ typedef struct {
   double seasonality;       // Daily/weekly patterns
 } TrafficProfile;
 
+#define MAX_ACTIVE_FLOWS 10000
+#define FLOW_IDLE_PACKETS 1000 // Flows idle this many packets are retired
+
 // Dataset generation parameters
 typedef struct {
-  int num_packets;
-  int ip_range;
+  uint64_t num_packets;
+  uint64_t ip_range; // Up to 2^32
   int initial_known_size;
   DatasetType dataset_type;
   TrafficProfile profile;
   char description[256];
-  char filename[64];
+  char filename[256]; // "-" writes to stdout
+  uint32_t max_active_flows;
+  uint64_t flow_idle_packets;
 } DatasetConfig;
 
+// Packet timestamps: none (the original two-field-header format), or
+// inter-arrival gaps drawn from one of these models
+typedef enum {
+  ARRIVALS_NONE,
+  ARRIVALS_POISSON, // Exponential gaps at a constant rate
+  ARRIVALS_ONOFF,   // Heavy-tailed ON bursts at twice the rate, OFF silences
+  ARRIVALS_DIURNAL  // Rate swinging sinusoidally once over the trace
+} ArrivalModel;
+
+typedef struct {
+  ArrivalModel model;
+  double rate; // Mean packets per second
+} ArrivalConfig;
+
 // Pre-defined realistic dataset configurations
 DatasetConfig datasets[] = {
     // Dataset 0: Your current uniform random
@@ -51,7 +74,9 @@ DatasetConfig datasets[] = {
      UNIFORM_RANDOM,
      {0.1, 0.6, 0.2, 0.3, 0.4, 50, 0.1},
      "Uniform random distribution - baseline test",
-     "tests/dataset_uniform.txt"},
+     "tests/dataset_uniform.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 1: Realistic web traffic (Zipf distribution)
     {1000000,
@@ -60,7 +85,9 @@ DatasetConfig datasets[] = {
      ZIPF_DISTRIBUTION,
      {0.05, 0.8, 0.4, 0.7, 0.6, 25, 0.3},
      "Web traffic - 80/20 rule, few large flows dominate",
-     "tests/dataset_web.txt"},
+     "tests/dataset_web.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 2: Enterprise datacenter traffic
     {1500000,
@@ -69,7 +96,9 @@ DatasetConfig datasets[] = {
      DATACENTER_EAST_WEST,
      {0.15, 0.4, 0.6, 0.8, 0.9, 150, 0.4},
      "Datacenter east-west - high locality, large flows",
-     "tests/dataset_datacenter.txt"},
+     "tests/dataset_datacenter.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 3: DDoS attack simulation
     {800000,
@@ -78,7 +107,9 @@ DatasetConfig datasets[] = {
      DDOS_SIMULATION,
      {0.02, 0.95, 0.9, 0.3, 0.1, 5, 0.1},
      "DDoS simulation - many small flows from diverse sources",
-     "tests/dataset_ddos.txt"},
+     "tests/dataset_ddos.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 4: Video streaming traffic (Netflix-like)
     {2000000,
@@ -87,7 +118,9 @@ DatasetConfig datasets[] = {
      VIDEO_STREAMING,
      {0.3, 0.2, 0.3, 0.6, 0.5, 300, 0.7},
      "Video streaming - large sustained flows with seasonality",
-     "tests/dataset_streaming.txt"},
+     "tests/dataset_streaming.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 5: IoT sensor network
     {500000,
@@ -96,7 +129,9 @@ DatasetConfig datasets[] = {
      IOT_SENSOR_DATA,
      {0.01, 0.9, 0.2, 0.9, 0.4, 3, 0.5},
      "IoT sensors - many tiny flows, periodic patterns",
-     "tests/dataset_iot.txt"},
+     "tests/dataset_iot.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 6: Gaming traffic (eSports/MMO)
     {750000,
@@ -105,7 +140,9 @@ DatasetConfig datasets[] = {
      GAMING_TRAFFIC,
      {0.08, 0.7, 0.8, 0.5, 0.7, 20, 0.6},
      "Gaming traffic - low latency, bursty, synchronized events",
-     "tests/dataset_gaming.txt"},
+     "tests/dataset_gaming.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 7: CDN edge traffic
     {1200000,
@@ -114,7 +151,9 @@ DatasetConfig datasets[] = {
      CDN_EDGE_TRAFFIC,
      {0.2, 0.5, 0.5, 0.8, 0.6, 80, 0.8},
      "CDN edge - cached content, high temporal locality",
-     "tests/dataset_cdn.txt"},
+     "tests/dataset_cdn.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 8: Mixed enterprise workload
     {1100000,
@@ -123,7 +162,9 @@ DatasetConfig datasets[] = {
      ENTERPRISE_MIXED,
      {0.12, 0.6, 0.4, 0.6, 0.5, 60, 0.9},
      "Enterprise mixed - business hours pattern, diverse apps",
-     "tests/dataset_enterprise.txt"},
+     "tests/dataset_enterprise.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS},
 
     // Dataset 9: Heavy-tail Pareto distribution
     {900000,
@@ -132,173 +173,303 @@ DatasetConfig datasets[] = {
      PARETO_DISTRIBUTION,
      {0.25, 0.3, 0.7, 0.4, 0.3, 200, 0.2},
      "Pareto distribution - extreme heavy-tail, few giant flows",
-     "tests/dataset_pareto.txt"}};
+     "tests/dataset_pareto.txt",
+     MAX_ACTIVE_FLOWS,
+     FLOW_IDLE_PACKETS}};
 
 #define NUM_DATASETS (sizeof(datasets) / sizeof(datasets[0]))
+#define DEFAULT_SEED 12345
+#define SCALE_ACTIVE_FLOWS (1u << 22)
+#define SCALE_IDLE_FACTOR 8 // Scale-mode idle timeout, in active-flow counts
+#define SCALE_OUTPUT "dataset_scale.txt"
+#define CDN_POPULAR_IPS 100
+#define WRITE_BUFFER_SIZE (1 << 20) // Bytes per buffered trace write
+#define WRITE_LINE_MAX 32            // Longest line: IP, space, timestamp
+#define TICKS_PER_SECOND 1000000000ull // Timestamps are in nanoseconds
+#define DEFAULT_PACKET_RATE 1e6
+#define ONOFF_MEAN_PERIOD 0.01 // Seconds, mean ON and mean OFF period
+#define ONOFF_SHAPE 1.5        // Pareto shape of ON and OFF periods
+#define DIURNAL_DEPTH 0.8      // Peak rate is (1 + depth) x the mean
+#define ZIPF_CHECK_SAMPLES 4000000
+#define ZIPF_CHECK_RANKS 10000       // Ranks binned before the tail bin
+#define ZIPF_CHECK_MIN_EXPECTED 20.0 // Expected count per chi-square bin
+#define ZIPF_CHECK_P_MIN 0.001       // Fit rejected below this p-value
+#define ZIPF_EXACT_TERMS 1e7 // Normalizer terms summed before the tail estimate
+#define READ_BUFFER_SIZE (1 << 20)      // Bytes per analyzer read
+#define ANALYZE_DENSE_RANGE (1u << 24) // Larger IP ranges are sketched
+#define HLL_BITS 14
+#define HLL_REGISTERS (1 << HLL_BITS)
+#define CM_BITS 16
+#define CM_WIDTH (1 << CM_BITS)
+#define CM_DEPTH 4 // Rows, each indexed by its own 16 bits of the key hash
+#define TOPK_SIZE 1024
+#define TOPK_SLOTS (4 * TOPK_SIZE)
+
+// xoshiro256** generator. Every dataset draws from its own stream, seeded
+// through splitmix64 from the run seed and the dataset's index, so a seed
+// reproduces each file byte for byte whatever the thread scheduling.
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
 
-// Random number generators for different distributions
-double uniform_random() { return (double)rand() / RAND_MAX; }
+static void rng_seed(Rng *rng, uint64_t seed, uint64_t stream) {
+  uint64_t x = seed ^ splitmix64(&stream);
+  for (int i = 0; i < 4; i++) {
+    rng->s[i] = splitmix64(&x);
+  }
+}
 
-double zipf_random(double alpha, int n) {
-  static double *zipf_table = NULL;
-  static int table_size = 0;
+static inline uint64_t rotl64(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
 
-  if (zipf_table == NULL || table_size != n) {
-    if (zipf_table)
-      free(zipf_table);
-    zipf_table = (double *)malloc(n * sizeof(double));
-    table_size = n;
+static inline uint64_t rng_next(Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = rotl64(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64(s[3], 45);
+  return result;
+}
 
-    double sum = 0.0;
-    for (int i = 1; i <= n; i++) {
-      sum += 1.0 / pow(i, alpha);
-    }
+// Uniform in (0, 1): never 0 or 1, so log() and 1 / u stay finite
+static inline double uniform_random(Rng *rng) {
+  return ((double)(rng_next(rng) >> 11) + 0.5) * 0x1.0p-53;
+}
 
-    double cumulative = 0.0;
-    for (int i = 0; i < n; i++) {
-      cumulative += (1.0 / pow(i + 1, alpha)) / sum;
-      zipf_table[i] = cumulative;
-    }
+// Uniform integer in [0, n), for n up to 2^32
+static inline uint32_t random_below(Rng *rng, uint64_t n) {
+  return (uint32_t)(((rng_next(rng) >> 32) * n) >> 32);
+}
+
+// Zipf sampling by rejection-inversion (Hoermann and Derflinger, "Rejection-
+// inversion to generate variates from monotone discrete distributions",
+// 1996). Ranks 1..n with P(k) proportional to k^-exponent, for any n up to
+// 2^32 and exponent > 0, without a table. A draw inverts the integral of
+// the continuous hat h(x) = x^-exponent and accepts with probability above
+// 0.9 for the exponents used here, so it costs O(1) expected time.
+typedef struct {
+  double exponent;
+  double n;
+  double h_integral_x1; // H(1.5) - 1
+  double h_integral_n;  // H(n + 0.5)
+  double s;             // Squeeze: accept without evaluating H(k + 0.5)
+} ZipfSampler;
+
+// log1p(x) / x and expm1(x) / x, with their series near 0
+static double log1p_ratio(double x) {
+  return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x / 3.0);
+}
+
+static double expm1_ratio(double x) {
+  return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0);
+}
+
+static double zipf_h(const ZipfSampler *zipf, double x) {
+  return exp(-zipf->exponent * log(x));
+}
+
+// H(x), an antiderivative of h(x), continuous in the exponent at 1
+static double zipf_h_integral(const ZipfSampler *zipf, double x) {
+  double log_x = log(x);
+  return expm1_ratio((1.0 - zipf->exponent) * log_x) * log_x;
+}
+
+static double zipf_h_integral_inverse(const ZipfSampler *zipf, double x) {
+  double t = x * (1.0 - zipf->exponent);
+  if (t < -1.0) {
+    t = -1.0; // Rounding at the lower end
   }
+  return exp(log1p_ratio(t) * x);
+}
 
-  double r = uniform_random();
-  for (int i = 0; i < n; i++) {
-    if (r <= zipf_table[i]) {
-      return i + 1;
+static void zipf_init(ZipfSampler *zipf, double exponent, double n) {
+  zipf->exponent = exponent;
+  zipf->n = n;
+  zipf->h_integral_x1 = zipf_h_integral(zipf, 1.5) - 1.0;
+  zipf->h_integral_n = zipf_h_integral(zipf, n + 0.5);
+  zipf->s = 2.0 - zipf_h_integral_inverse(
+                      zipf, zipf_h_integral(zipf, 2.5) - zipf_h(zipf, 2.0));
+}
+
+// Rank in [1, n]
+static uint64_t zipf_sample(const ZipfSampler *zipf, Rng *rng) {
+  for (;;) {
+    double u = zipf->h_integral_n +
+               uniform_random(rng) * (zipf->h_integral_x1 - zipf->h_integral_n);
+    double x = zipf_h_integral_inverse(zipf, u);
+    double k = floor(x + 0.5);
+    if (k < 1.0) {
+      k = 1.0;
+    } else if (k > zipf->n) {
+      k = zipf->n;
+    }
+    if (k - x <= zipf->s ||
+        u >= zipf_h_integral(zipf, k + 0.5) - zipf_h(zipf, k)) {
+      return (uint64_t)k;
     }
   }
-  return n;
 }
 
-double pareto_random(double alpha, double xm) {
-  double u = uniform_random();
-  return xm / pow(u, 1.0 / alpha);
+// Everything one dataset's generator remembers between draws
+typedef struct {
+  Rng rng;
+  int has_spare; // Second Box-Muller normal
+  double spare;
+  int64_t last_ip; // DATACENTER_EAST_WEST
+  uint32_t popular_ips[CDN_POPULAR_IPS]; // CDN_EDGE_TRAFFIC
+  int popular_count;
+  uint64_t popular_update;
+  ZipfSampler zipf;
+} Generator;
+
+static void generator_init(Generator *gen, uint64_t seed, uint64_t stream) {
+  memset(gen, 0, sizeof(*gen));
+  rng_seed(&gen->rng, seed, stream);
+  gen->last_ip = -1;
 }
 
-double normal_random(double mu, double sigma) {
-  static int has_spare = 0;
-  static double spare;
+// Random number generators for different distributions
+double zipf_random(Generator *gen, double alpha, double n) {
+  if (gen->zipf.n != n || gen->zipf.exponent != alpha) {
+    zipf_init(&gen->zipf, alpha, n);
+  }
+  return (double)zipf_sample(&gen->zipf, &gen->rng);
+}
 
-  if (has_spare) {
-    has_spare = 0;
-    return spare * sigma + mu;
+// Inversion: O(1) per draw
+double pareto_random(Generator *gen, double alpha, double xm) {
+  double u = uniform_random(&gen->rng);
+  return xm / pow(u, 1.0 / alpha);
+}
+
+double normal_random(Generator *gen, double mu, double sigma) {
+  if (gen->has_spare) {
+    gen->has_spare = 0;
+    return gen->spare * sigma + mu;
   }
 
-  has_spare = 1;
-  double u = uniform_random();
-  double v = uniform_random();
-  double mag = sigma * sqrt(-2.0 * log(u));
-  spare = mag * cos(2.0 * M_PI * v);
-  return mag * sin(2.0 * M_PI * v) + mu;
+  gen->has_spare = 1;
+  double u = uniform_random(&gen->rng);
+  double v = uniform_random(&gen->rng);
+  double mag = sqrt(-2.0 * log(u));
+  gen->spare = mag * cos(2.0 * M_PI * v);
+  return mag * sin(2.0 * M_PI * v) * sigma + mu;
 }
 
 // Generate IP based on distribution type
-int generate_ip(DatasetType type, TrafficProfile *profile, int ip_range,
-                int packet_index, int total_packets) {
-  int ip;
+uint32_t generate_ip(Generator *gen, DatasetType type, TrafficProfile *profile,
+                     uint64_t key_range, uint64_t packet_index,
+                     uint64_t total_packets) {
+  Rng *rng = &gen->rng;
+  int64_t ip_range = (int64_t)key_range; // Signed, so clamps below 0 work
+  int64_t ip;
 
   switch (type) {
   case UNIFORM_RANDOM:
-    ip = rand() % ip_range;
+    ip = random_below(rng, ip_range);
     break;
 
   case ZIPF_DISTRIBUTION:
     // 80/20 rule - few IPs get most traffic
-    ip = (int)zipf_random(1.2, ip_range) - 1;
+    ip = (int64_t)zipf_random(gen, 1.2, ip_range) - 1;
     break;
 
   case PARETO_DISTRIBUTION:
     // Heavy-tail distribution
-    ip = (int)pareto_random(1.5, 1.0) % ip_range;
+    ip = (int64_t)fmod(pareto_random(gen, 1.5, 1.0), ip_range);
     break;
 
   case NORMAL_DISTRIBUTION:
     // Bell curve around middle of IP range
-    ip = (int)normal_random(ip_range / 2.0, ip_range / 6.0);
+    ip = (int64_t)normal_random(gen, ip_range / 2.0, ip_range / 6.0);
     ip = (ip < 0) ? 0 : (ip >= ip_range ? ip_range - 1 : ip);
     break;
 
   case BIMODAL_TRAFFIC:
     // Two peaks - business hours simulation
-    if (uniform_random() < 0.6) {
-      ip = (int)normal_random(ip_range * 0.3, ip_range * 0.1);
+    if (uniform_random(rng) < 0.6) {
+      ip = (int64_t)normal_random(gen, ip_range * 0.3, ip_range * 0.1);
     } else {
-      ip = (int)normal_random(ip_range * 0.7, ip_range * 0.1);
+      ip = (int64_t)normal_random(gen, ip_range * 0.7, ip_range * 0.1);
     }
     ip = (ip < 0) ? 0 : (ip >= ip_range ? ip_range - 1 : ip);
     break;
 
   case DDOS_SIMULATION:
     // Many random sources attacking few targets
-    if (uniform_random() < 0.05) {
+    if (uniform_random(rng) < 0.05) {
       // Target IPs (being attacked)
-      ip = rand() % 10;
+      ip = random_below(rng, 10);
     } else {
       // Attack sources (distributed)
-      ip = rand() % ip_range;
+      ip = random_below(rng, ip_range);
     }
     break;
 
   case IOT_SENSOR_DATA:
     // Many sensors reporting to few collectors
-    if (uniform_random() < 0.8) {
+    if (uniform_random(rng) < 0.8) {
       // Sensor IPs (many)
-      ip = 1000 + (rand() % (ip_range - 1000));
+      ip = 1000 + random_below(rng, ip_range - 1000);
     } else {
       // Collector IPs (few)
-      ip = rand() % 1000;
+      ip = random_below(rng, 1000);
     }
     break;
 
   case VIDEO_STREAMING:
     // Few content servers serving many clients
-    if (uniform_random() < profile->elephant_ratio) {
+    if (uniform_random(rng) < profile->elephant_ratio) {
       // Content servers (few, large flows)
-      ip = rand() % 100;
+      ip = random_below(rng, 100);
     } else {
       // Clients (many, receiving flows)
-      ip = 100 + (rand() % (ip_range - 100));
+      ip = 100 + random_below(rng, ip_range - 100);
     }
     break;
 
   case DATACENTER_EAST_WEST:
     // High spatial locality - nearby servers communicate
-    {
-      static int last_ip = -1;
-      if (last_ip == -1 || uniform_random() > profile->spatial_locality) {
-        last_ip = rand() % ip_range;
-      }
-      // Generate nearby IP with some probability
-      int offset = (int)normal_random(0, ip_range * 0.02);
-      ip = (last_ip + offset) % ip_range;
-      ip = (ip < 0) ? ip + ip_range : ip;
-      last_ip = ip;
+    if (gen->last_ip == -1 || uniform_random(rng) > profile->spatial_locality) {
+      gen->last_ip = random_below(rng, ip_range);
     }
+    // Generate nearby IP with some probability
+    ip = (gen->last_ip + (int64_t)normal_random(gen, 0, ip_range * 0.02)) %
+         ip_range;
+    ip = (ip < 0) ? ip + ip_range : ip;
+    gen->last_ip = ip;
     break;
 
   case CDN_EDGE_TRAFFIC:
-    // Temporal locality - popular content accessed repeatedly
-    {
-      static int popular_ips[100];
-      static int popular_count = 0;
-      static int last_update = 0;
-
-      // Update popular IPs periodically
-      if (packet_index - last_update > 10000) {
-        for (int i = 0; i < 100; i++) {
-          popular_ips[i] = rand() % ip_range;
-        }
-        popular_count = 100;
-        last_update = packet_index;
+    // Temporal locality - popular content accessed repeatedly. The popular
+    // set is refreshed every 10000 packets.
+    if (gen->popular_count == 0 ||
+        packet_index - gen->popular_update > 10000) {
+      for (int i = 0; i < CDN_POPULAR_IPS; i++) {
+        gen->popular_ips[i] = random_below(rng, ip_range);
       }
+      gen->popular_count = CDN_POPULAR_IPS;
+      gen->popular_update = packet_index;
+    }
 
-      if (uniform_random() < profile->temporal_locality) {
-        // Access popular content
-        ip = popular_ips[rand() % popular_count];
-      } else {
-        // Access random content
-        ip = rand() % ip_range;
-      }
+    if (uniform_random(rng) < profile->temporal_locality) {
+      // Access popular content
+      ip = gen->popular_ips[random_below(rng, gen->popular_count)];
+    } else {
+      // Access random content
+      ip = random_below(rng, ip_range);
     }
     break;
 
@@ -308,12 +479,12 @@ int generate_ip(DatasetType type, TrafficProfile *profile, int ip_range,
       double time_progress = (double)packet_index / total_packets;
       int session_id = (int)(time_progress * 10) % 5; // 5 game sessions
 
-      if (uniform_random() < 0.8) {
+      if (uniform_random(rng) < 0.8) {
         // Players in current active session
-        ip = session_id * 1000 + (rand() % 1000);
+        ip = session_id * 1000 + random_below(rng, 1000);
       } else {
         // Random players
-        ip = rand() % ip_range;
+        ip = random_below(rng, ip_range);
       }
     }
     break;
@@ -325,255 +496,1011 @@ int generate_ip(DatasetType type, TrafficProfile *profile, int ip_range,
       double business_hour_factor =
           0.5 + 0.5 * sin(time_progress * 2 * M_PI * profile->seasonality);
 
-      if (uniform_random() < business_hour_factor) {
+      if (uniform_random(rng) < business_hour_factor) {
         // Business applications (clustered IPs)
-        ip = (int)normal_random(ip_range * 0.3, ip_range * 0.1);
+        ip = (int64_t)normal_random(gen, ip_range * 0.3, ip_range * 0.1);
       } else {
         // Background traffic
-        ip = rand() % ip_range;
+        ip = random_below(rng, ip_range);
       }
       ip = (ip < 0) ? 0 : (ip >= ip_range ? ip_range - 1 : ip);
     }
     break;
 
   default:
-    ip = rand() % ip_range;
+    ip = random_below(rng, ip_range);
     break;
   }
 
-  return ip;
+  return (uint32_t)ip;
+}
+
+// Smallest key space that holds a model's fixed address blocks; generate_ip
+// writes IPs outside smaller ranges
+static uint64_t min_ip_range(DatasetType type) {
+  switch (type) {
+  case DDOS_SIMULATION:
+    return 10; // Attack targets
+  case IOT_SENSOR_DATA:
+    return 1001; // 1000 collectors and at least one sensor
+  case VIDEO_STREAMING:
+    return 101; // 100 content servers and at least one client
+  case GAMING_TRAFFIC:
+    return 5000; // 5 sessions of 1000 players
+  default:
+    return 1;
+  }
 }
 
 // Generate flow sizes based on traffic profile
-int generate_flow_size(TrafficProfile *profile, int ip) {
-  double r = uniform_random();
+int generate_flow_size(Generator *gen, TrafficProfile *profile) {
+  double r = uniform_random(&gen->rng);
 
   if (r < profile->elephant_ratio) {
-    // Elephant flow - large size
-    return (int)pareto_random(1.2, profile->avg_flow_size * 10);
+    // Elephant flow - large size, capped so it stays an int
+    double size = pareto_random(gen, 1.2, profile->avg_flow_size * 10);
+    return size < INT32_MAX ? (int)size : INT32_MAX;
   } else if (r < profile->elephant_ratio + profile->mice_ratio) {
     // Mice flow - small size
-    return 1 + (rand() % 5);
+    return 1 + random_below(&gen->rng, 5);
   } else {
     // Normal flow
-    return (int)normal_random(profile->avg_flow_size,
+    return (int)normal_random(gen, profile->avg_flow_size,
                               profile->avg_flow_size * 0.3);
   }
 }
 
-// Generate dataset file
-void generate_dataset(DatasetConfig *config) {
-  printf("Generating %s...\n", config->description);
+// Trace output: decimal lines formatted into a large buffer and written
+// with one fwrite per WRITE_BUFFER_SIZE bytes
+typedef struct {
+  FILE *fp;
+  char *buffer;
+  size_t used;
+  int failed;
+} TraceWriter;
+
+static void writer_flush(TraceWriter *writer) {
+  if (writer->used > 0 &&
+      fwrite(writer->buffer, 1, writer->used, writer->fp) != writer->used) {
+    writer->failed = 1;
+  }
+  writer->used = 0;
+}
 
-  FILE *fp = fopen(config->filename, "w");
-  if (!fp) {
-    perror("Error creating dataset file");
-    return;
+// Append value and the terminator; the caller leaves room for both
+static inline void writer_field(TraceWriter *writer, uint64_t value,
+                                char terminator) {
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  char *out = writer->buffer + writer->used;
+  for (int i = 0; i < n; i++) {
+    out[i] = digits[n - 1 - i];
   }
+  out[n] = terminator;
+  writer->used += (size_t)n + 1;
+}
 
-  // Write header
-  fprintf(fp, "%d %d %d\n", config->initial_known_size, config->num_packets,
-          config->ip_range);
+static inline void writer_line(TraceWriter *writer, uint32_t value) {
+  if (writer->used > WRITE_BUFFER_SIZE - WRITE_LINE_MAX) {
+    writer_flush(writer);
+  }
+  writer_field(writer, value, '\n');
+}
 
-  // Generate and write known flows
-  int *known_flows = (int *)malloc(config->initial_known_size * sizeof(int));
+static inline void writer_timed_line(TraceWriter *writer, uint32_t ip,
+                                     uint64_t ticks) {
+  if (writer->used > WRITE_BUFFER_SIZE - WRITE_LINE_MAX) {
+    writer_flush(writer);
+  }
+  writer_field(writer, ip, ' ');
+  writer_field(writer, ticks, '\n');
+}
 
-  for (int i = 0; i < config->initial_known_size; i++) {
-    known_flows[i] =
-        generate_ip(config->dataset_type, &config->profile, config->ip_range, i,
-                    config->initial_known_size);
-    fprintf(fp, "%d\n", known_flows[i]);
+// Arrival times for one trace. The clock draws from its own PRNG stream, so
+// a timestamped trace carries the same IPs as the untimestamped one.
+typedef struct {
+  Rng rng;
+  ArrivalModel model;
+  double rate;
+  double now;    // Seconds since the first packet
+  double on_end; // ARRIVALS_ONOFF: end of the current ON period
+  double period; // ARRIVALS_DIURNAL: the trace's expected duration
+} PacketClock;
+
+// Pareto period with mean ONOFF_MEAN_PERIOD
+static double onoff_period(Rng *rng) {
+  double xm = ONOFF_MEAN_PERIOD * (ONOFF_SHAPE - 1.0) / ONOFF_SHAPE;
+  return xm / pow(uniform_random(rng), 1.0 / ONOFF_SHAPE);
+}
+
+static void packet_clock_init(PacketClock *clock, const ArrivalConfig *arrivals,
+                              uint64_t seed, uint64_t stream,
+                              uint64_t num_packets) {
+  rng_seed(&clock->rng, seed, stream | 1ull << 63);
+  clock->model = arrivals->model;
+  clock->rate = arrivals->rate;
+  clock->now = 0.0;
+  clock->on_end = onoff_period(&clock->rng);
+  clock->period = (double)num_packets / arrivals->rate;
+}
+
+// Timestamp of the next packet, in TICKS_PER_SECOND units
+static inline uint64_t packet_clock_next(PacketClock *clock) {
+  double gap = -log(uniform_random(&clock->rng)); // Exponential, mean 1
+  switch (clock->model) {
+  case ARRIVALS_ONOFF:
+    // Equal mean ON and OFF periods, so ON carries twice the mean rate. A
+    // gap running past the ON period resumes in the next one; exponential
+    // gaps are memoryless, so that is the same as drawing a fresh gap.
+    clock->now += gap / (2.0 * clock->rate);
+    while (clock->now > clock->on_end) {
+      double off = onoff_period(&clock->rng);
+      clock->now += off;
+      clock->on_end += off + onoff_period(&clock->rng);
+    }
+    break;
+  case ARRIVALS_DIURNAL:
+    // Rate at the current time; it changes slowly against one gap
+    clock->now +=
+        gap / (clock->rate * (1.0 + DIURNAL_DEPTH *
+                                        sin(2.0 * M_PI * clock->now /
+                                            clock->period)));
+    break;
+  default:
+    clock->now += gap / clock->rate;
+    break;
   }
+  return (uint64_t)(clock->now * TICKS_PER_SECOND);
+}
 
-  // Track flow states for realistic flow generation
-  typedef struct {
-    int ip;
-    int remaining_packets;
-    int last_seen;
-  } ActiveFlow;
+static inline void write_packet(TraceWriter *writer, PacketClock *clock,
+                                uint32_t ip) {
+  if (clock->model == ARRIVALS_NONE) {
+    writer_line(writer, ip);
+  } else {
+    writer_timed_line(writer, ip, packet_clock_next(clock));
+  }
+}
+
+// Flow in progress while a trace is generated
+typedef struct {
+  uint32_t ip;
+  int32_t remaining_packets;
+  uint64_t last_seen;
+  uint32_t older; // Neighbours in last_seen order, FLOW_NONE at the ends
+  uint32_t newer;
+} ActiveFlow;
+
+#define FLOW_NONE UINT32_MAX
+
+// Active flows: a dense array, so a uniformly random flow is one index, and
+// a list through it in last_seen order, so a continued flow moves to the
+// newest end and idle flows are retired from the oldest end. Every
+// operation is O(1); removal moves the last flow into the hole.
+typedef struct {
+  ActiveFlow *flows;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t oldest;
+  uint32_t newest;
+} FlowTable;
+
+static int flow_table_init(FlowTable *table, uint32_t capacity) {
+  table->flows = malloc((size_t)capacity * sizeof(ActiveFlow));
+  table->count = 0;
+  table->capacity = capacity;
+  table->oldest = table->newest = FLOW_NONE;
+  return table->flows ? 0 : -1;
+}
+
+static inline void flow_table_unlink(FlowTable *table, uint32_t index) {
+  ActiveFlow *flow = &table->flows[index];
+  if (flow->older == FLOW_NONE) {
+    table->oldest = flow->newer;
+  } else {
+    table->flows[flow->older].newer = flow->newer;
+  }
+  if (flow->newer == FLOW_NONE) {
+    table->newest = flow->older;
+  } else {
+    table->flows[flow->newer].older = flow->older;
+  }
+}
+
+static inline void flow_table_link_newest(FlowTable *table, uint32_t index) {
+  ActiveFlow *flow = &table->flows[index];
+  flow->older = table->newest;
+  flow->newer = FLOW_NONE;
+  if (table->newest == FLOW_NONE) {
+    table->oldest = index;
+  } else {
+    table->flows[table->newest].newer = index;
+  }
+  table->newest = index;
+}
 
-  ActiveFlow *active_flows = (ActiveFlow *)calloc(10000, sizeof(ActiveFlow));
-  int active_flow_count = 0;
+static inline void flow_table_add(FlowTable *table, uint32_t ip,
+                                  int32_t packets, uint64_t now) {
+  uint32_t index = table->count++;
+  table->flows[index] = (ActiveFlow){ip, packets, now, FLOW_NONE, FLOW_NONE};
+  flow_table_link_newest(table, index);
+}
+
+static inline void flow_table_touch(FlowTable *table, uint32_t index,
+                                    uint64_t now) {
+  table->flows[index].last_seen = now;
+  if (table->newest != index) {
+    flow_table_unlink(table, index);
+    flow_table_link_newest(table, index);
+  }
+}
+
+static inline void flow_table_remove(FlowTable *table, uint32_t index) {
+  flow_table_unlink(table, index);
+  uint32_t last = --table->count;
+  if (index == last) {
+    return;
+  }
+  // Move the last flow into the hole and repoint its neighbours
+  ActiveFlow *flow = &table->flows[index];
+  *flow = table->flows[last];
+  if (flow->older == FLOW_NONE) {
+    table->oldest = index;
+  } else {
+    table->flows[flow->older].newer = index;
+  }
+  if (flow->newer == FLOW_NONE) {
+    table->newest = index;
+  } else {
+    table->flows[flow->newer].older = index;
+  }
+}
+
+// Retire flows idle for more than idle_packets; amortized O(1) per packet
+static inline void flow_table_expire(FlowTable *table, uint64_t now,
+                                     uint64_t idle_packets) {
+  while (table->oldest != FLOW_NONE &&
+         now - table->flows[table->oldest].last_seen > idle_packets) {
+    flow_table_remove(table, table->oldest);
+  }
+}
+
+// Generate dataset file from the given PRNG stream, with timestamps unless
+// arrivals->model is ARRIVALS_NONE. Memory is the write buffer plus the
+// active-flow table, whatever the trace length. Returns 0, or -1 with a
+// message on stderr.
+int generate_dataset(DatasetConfig *config, const ArrivalConfig *arrivals,
+                     uint64_t seed, uint64_t stream) {
+  int to_stdout = strcmp(config->filename, "-") == 0;
+  FILE *fp = to_stdout ? stdout : fopen(config->filename, "w");
+  if (!fp) {
+    perror(config->filename);
+    return -1;
+  }
+  TraceWriter writer = {fp, malloc(WRITE_BUFFER_SIZE), 0, 0};
+  FlowTable active;
+  if (flow_table_init(&active, config->max_active_flows) != 0 || !writer.buffer) {
+    fprintf(stderr, "%s: out of memory\n", config->filename);
+    free(writer.buffer);
+    free(active.flows);
+    if (!to_stdout) {
+      fclose(fp);
+    }
+    return -1;
+  }
+  Generator gen;
+  generator_init(&gen, seed, stream);
+  Rng *rng = &gen.rng;
+  PacketClock clock;
+  packet_clock_init(&clock, arrivals, seed, stream, config->num_packets);
+
+  // Write header; timestamped traces add the timestamp unit
+  fprintf(fp, "%d %llu %llu", config->initial_known_size,
+          (unsigned long long)config->num_packets,
+          (unsigned long long)config->ip_range);
+  if (arrivals->model != ARRIVALS_NONE) {
+    fprintf(fp, " %llu", (unsigned long long)TICKS_PER_SECOND);
+  }
+  fputc('\n', fp);
+
+  // Generate and write known flows
+  for (int i = 0; i < config->initial_known_size; i++) {
+    writer_line(&writer,
+                generate_ip(&gen, config->dataset_type, &config->profile,
+                            config->ip_range, i, config->initial_known_size));
+  }
 
   // Generate packets
-  for (int i = 0; i < config->num_packets; i++) {
-    int ip;
+  for (uint64_t i = 0; i < config->num_packets; i++) {
+    uint32_t ip;
 
     // Check if we should continue an existing flow or start new one
-    if (active_flow_count > 0 &&
-        uniform_random() < config->profile.temporal_locality) {
+    if (active.count > 0 &&
+        uniform_random(rng) < config->profile.temporal_locality) {
       // Continue existing flow
-      int flow_idx = rand() % active_flow_count;
-      ip = active_flows[flow_idx].ip;
-      active_flows[flow_idx].remaining_packets--;
-      active_flows[flow_idx].last_seen = i;
+      uint32_t flow_idx = random_below(rng, active.count);
+      ip = active.flows[flow_idx].ip;
 
       // Remove finished flow
-      if (active_flows[flow_idx].remaining_packets <= 0) {
-        active_flows[flow_idx] = active_flows[active_flow_count - 1];
-        active_flow_count--;
+      if (--active.flows[flow_idx].remaining_packets <= 0) {
+        flow_table_remove(&active, flow_idx);
+      } else {
+        flow_table_touch(&active, flow_idx, i);
       }
     } else {
       // Start new flow
-      ip = generate_ip(config->dataset_type, &config->profile, config->ip_range,
-                       i, config->num_packets);
+      ip = generate_ip(&gen, config->dataset_type, &config->profile,
+                       config->ip_range, i, config->num_packets);
 
       // Add to active flows if space available
-      if (active_flow_count < 10000) {
-        active_flows[active_flow_count].ip = ip;
-        active_flows[active_flow_count].remaining_packets =
-            generate_flow_size(&config->profile, ip);
-        active_flows[active_flow_count].last_seen = i;
-        active_flow_count++;
+      if (active.count < active.capacity) {
+        flow_table_add(&active, ip, generate_flow_size(&gen, &config->profile),
+                       i);
       }
     }
 
     // Add burst behavior
-    if (uniform_random() < config->profile.burst_intensity * 0.001) {
+    if (uniform_random(rng) < config->profile.burst_intensity * 0.001) {
       // Generate burst of same IP
-      int burst_size = 5 + (rand() % 20);
-      for (int b = 0; b < burst_size && i + b < config->num_packets; b++) {
-        fprintf(fp, "%d\n", ip);
+      uint64_t burst_size = 5 + random_below(rng, 20);
+      for (uint64_t b = 0; b < burst_size && i + b < config->num_packets;
+           b++) {
+        write_packet(&writer, &clock, ip);
       }
       i += burst_size - 1; // Skip ahead
     } else {
-      fprintf(fp, "%d\n", ip);
+      write_packet(&writer, &clock, ip);
     }
 
-    // Age out old flows
-    if (i % 1000 == 0) {
-      for (int j = active_flow_count - 1; j >= 0; j--) {
-        if (i - active_flows[j].last_seen > 1000) {
-          active_flows[j] = active_flows[active_flow_count - 1];
-          active_flow_count--;
-        }
-      }
+    flow_table_expire(&active, i, config->flow_idle_packets);
+  }
+
+  writer_flush(&writer);
+  int failed = writer.failed;
+  if (to_stdout ? fflush(fp) != 0 : fclose(fp) != 0) {
+    failed = 1;
+  }
+  if (failed) {
+    fprintf(stderr, "Error writing %s\n", config->filename);
+  }
+  free(writer.buffer);
+  free(active.flows);
+  return failed ? -1 : 0;
+}
+
+// One dataset per thread; results are printed in order after the join
+typedef struct {
+  DatasetConfig *config;
+  const ArrivalConfig *arrivals;
+  uint64_t seed;
+  uint64_t stream;
+  int status;
+  double seconds;
+  pthread_t thread;
+} GenerateJob;
+
+static double monotonic_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *generate_job(void *arg) {
+  GenerateJob *job = arg;
+  double start = monotonic_seconds();
+  job->status = generate_dataset(job->config, job->arrivals, job->seed,
+                                 job->stream);
+  job->seconds = monotonic_seconds() - start;
+  return NULL;
+}
+
+// Generate every dataset in parallel. Returns 0, or -1 if any failed.
+int generate_all_datasets(const ArrivalConfig *arrivals, uint64_t seed) {
+  GenerateJob jobs[NUM_DATASETS];
+  double start = monotonic_seconds();
+  for (size_t i = 0; i < NUM_DATASETS; i++) {
+    jobs[i].config = &datasets[i];
+    jobs[i].arrivals = arrivals;
+    jobs[i].seed = seed;
+    jobs[i].stream = i;
+    jobs[i].status = -1;
+    if (pthread_create(&jobs[i].thread, NULL, generate_job, &jobs[i]) != 0) {
+      generate_job(&jobs[i]); // Run it on this thread instead
+      jobs[i].thread = pthread_self();
     }
   }
 
-  free(known_flows);
-  free(active_flows);
-  fclose(fp);
+  int status = 0;
+  for (size_t i = 0; i < NUM_DATASETS; i++) {
+    if (!pthread_equal(jobs[i].thread, pthread_self())) {
+      pthread_join(jobs[i].thread, NULL);
+    }
+    if (jobs[i].status == 0) {
+      printf("Generated %-30s %8llu packets in %.2f s - %s\n",
+             datasets[i].filename,
+             (unsigned long long)datasets[i].num_packets, jobs[i].seconds,
+             datasets[i].description);
+    } else {
+      status = -1;
+    }
+  }
+  printf("Generated %d datasets in %.2f s (seed %llu)\n", (int)NUM_DATASETS,
+         monotonic_seconds() - start, (unsigned long long)seed);
+  return status;
+}
+
+// Sum of k^-exponent for k = 1..n: exact for the first ZIPF_EXACT_TERMS
+// terms, Euler-Maclaurin beyond them
+static double zipf_normalizer(double exponent, double n) {
+  double exact = n < ZIPF_EXACT_TERMS ? n : ZIPF_EXACT_TERMS;
+  double sum = 0.0;
+  for (double k = exact; k >= 1.0; k--) {
+    sum += pow(k, -exponent); // Smallest terms first
+  }
+  if (n > exact) {
+    double m = exact + 1.0;
+    double integral = exponent == 1.0 ? log(n / m)
+                                      : (pow(n, 1.0 - exponent) -
+                                         pow(m, 1.0 - exponent)) /
+                                            (1.0 - exponent);
+    sum += integral + 0.5 * (pow(m, -exponent) + pow(n, -exponent)) +
+           exponent / 12.0 *
+               (pow(m, -exponent - 1.0) - pow(n, -exponent - 1.0));
+  }
+  return sum;
+}
 
-  printf("Generated %s successfully!\n", config->filename);
+// Upper tail of the chi-square distribution (Wilson-Hilferty)
+static double chi_square_p_value(double chi2, int dof) {
+  double v = 2.0 / (9.0 * dof);
+  double z = (cbrt(chi2 / dof) - (1.0 - v)) / sqrt(v);
+  return 0.5 * erfc(z / sqrt(2.0));
 }
 
-// Calculate traffic concentration (what % of traffic is from top 10% of IPs)
-double calculate_concentration(int *ip_counts, int ip_range,
-                               int total_packets) {
-  // Sort IP counts
-  int *sorted_counts = (int *)malloc(ip_range * sizeof(int));
-  memcpy(sorted_counts, ip_counts, ip_range * sizeof(int));
+// Chi-square goodness of fit of zipf_sample() against the exact Zipf
+// probabilities (those the generator's cumulative table used to hold).
+// Leading ranks are binned until each bin expects ZIPF_CHECK_MIN_EXPECTED
+// draws; ranks past ZIPF_CHECK_RANKS share one tail bin. Returns 0 if the
+// fit holds.
+static int check_zipf_case(double exponent, double n, uint64_t seed,
+                           uint64_t stream) {
+  ZipfSampler zipf;
+  zipf_init(&zipf, exponent, n);
+  Rng rng;
+  rng_seed(&rng, seed, stream);
+  int ranks = n < ZIPF_CHECK_RANKS ? (int)n : ZIPF_CHECK_RANKS;
+  uint64_t *counts = calloc((size_t)ranks + 1, sizeof(uint64_t));
+  if (!counts) {
+    return -1;
+  }
 
-  // Simple bubble sort (good enough for analysis)
-  for (int i = 0; i < ip_range - 1; i++) {
-    for (int j = 0; j < ip_range - i - 1; j++) {
-      if (sorted_counts[j] < sorted_counts[j + 1]) {
-        int temp = sorted_counts[j];
-        sorted_counts[j] = sorted_counts[j + 1];
-        sorted_counts[j + 1] = temp;
+  double start = monotonic_seconds();
+  for (int i = 0; i < ZIPF_CHECK_SAMPLES; i++) {
+    uint64_t k = zipf_sample(&zipf, &rng);
+    counts[k <= (uint64_t)ranks ? k - 1 : (uint64_t)ranks]++;
+  }
+  double ns_per_draw =
+      (monotonic_seconds() - start) * 1e9 / ZIPF_CHECK_SAMPLES;
+
+  double normalizer = zipf_normalizer(exponent, n);
+  double chi2 = 0.0;
+  double expected = 0.0;
+  double observed = 0.0;
+  double cumulative = 0.0;
+  int bins = 0;
+  for (int k = 1; k <= ranks; k++) {
+    double p = pow(k, -exponent) / normalizer;
+    cumulative += p;
+    expected += p * ZIPF_CHECK_SAMPLES;
+    observed += (double)counts[k - 1];
+    if (expected >= ZIPF_CHECK_MIN_EXPECTED) {
+      chi2 += (observed - expected) * (observed - expected) / expected;
+      bins++;
+      expected = observed = 0.0;
+    }
+  }
+  double tail = 1.0 - cumulative;
+  expected += (tail > 0.0 ? tail : 0.0) * ZIPF_CHECK_SAMPLES;
+  observed += (double)counts[ranks];
+  if (expected > 0.0) {
+    chi2 += (observed - expected) * (observed - expected) / expected;
+    bins++;
+  }
+  free(counts);
+
+  double p_value = chi_square_p_value(chi2, bins - 1);
+  int pass = p_value >= ZIPF_CHECK_P_MIN;
+  printf("  exponent %.2f, n %-10.0f chi2 %9.1f on %5d dof, p %.3f, "
+         "%5.1f ns/draw  %s\n",
+         exponent, n, chi2, bins - 1, p_value, ns_per_draw,
+         pass ? "PASS" : "FAIL");
+  return pass ? 0 : -1;
+}
+
+// Zipf sampler against the exact distribution: the web trace's parameters,
+// the exponent-1 boundary, a flatter law, and the full 32-bit key space
+int check_zipf(uint64_t seed) {
+  static const double cases[][2] = {
+      {1.2, 50000}, {1.0, 1000000}, {0.8, 1000}, {1.2, 4294967296.0}};
+  int status = 0;
+  printf("Zipf goodness of fit, %d draws per case (seed %llu):\n",
+         ZIPF_CHECK_SAMPLES, (unsigned long long)seed);
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    if (check_zipf_case(cases[i][0], cases[i][1], seed, i) != 0) {
+      status = -1;
+    }
+  }
+  return status;
+}
+
+// Trace input for the analyzer: READ_BUFFER_SIZE bytes per fread, parsed
+// in place, so memory stays fixed whatever the trace length
+typedef struct {
+  FILE *fp;
+  char *buffer;
+  size_t used;
+  size_t pos;
+  int eof;
+} TraceReader;
+
+// Next unsigned decimal, parsed byte by byte across buffer refills
+static int reader_next_slow(TraceReader *reader, uint64_t max_value,
+                            uint64_t *value) {
+  uint64_t v = 0;
+  int digits = 0;
+  for (;;) {
+    if (reader->pos == reader->used) {
+      if (reader->eof) {
+        break;
+      }
+      reader->used = fread(reader->buffer, 1, READ_BUFFER_SIZE, reader->fp);
+      reader->pos = 0;
+      if (reader->used < READ_BUFFER_SIZE) {
+        reader->eof = 1;
       }
+      continue;
     }
+    char c = reader->buffer[reader->pos];
+    if (c >= '0' && c <= '9') {
+      v = v * 10 + (uint64_t)(c - '0');
+      if (v > max_value) {
+        return -1;
+      }
+      digits++;
+    } else if (digits > 0) {
+      break; // Separator after the number; left for the next call
+    } else if (c == '-') {
+      return -1;
+    }
+    reader->pos++;
   }
+  *value = v;
+  return digits > 0 ? 0 : -1;
+}
 
-  // Calculate top 10% traffic
-  int top_10_percent = ip_range / 10;
-  int top_traffic = 0;
-  for (int i = 0; i < top_10_percent; i++) {
-    top_traffic += sorted_counts[i];
+// Next unsigned decimal in the file, up to max_value. Returns 0, or -1 at
+// end of file or on a malformed number.
+static inline int reader_next(TraceReader *reader, uint64_t max_value,
+                              uint64_t *value) {
+  // Fast path: one separator and a number of up to 19 digits lie wholly
+  // inside the buffer
+  if (reader->used - reader->pos > 24) {
+    const char *p = reader->buffer + reader->pos;
+    p += *p == '\n' || *p == ' ';
+    const char *digits = p;
+    uint64_t v = 0;
+    while ((unsigned)(*p - '0') < 10 && p - digits < 19) {
+      v = v * 10 + (uint64_t)(*p++ - '0');
+    }
+    if (p > digits && p - digits < 19) {
+      reader->pos = (size_t)(p - reader->buffer);
+      *value = v;
+      return v <= max_value ? 0 : -1;
+    }
   }
+  return reader_next_slow(reader, max_value, value);
+}
 
-  free(sorted_counts);
-  return 100.0 * top_traffic / total_packets;
+// Whether another number follows on the current line, as far as the
+// buffer shows
+static int reader_line_continues(const TraceReader *reader) {
+  size_t pos = reader->pos;
+  while (pos < reader->used &&
+         (reader->buffer[pos] == ' ' || reader->buffer[pos] == '\t')) {
+    pos++;
+  }
+  return pos < reader->used && reader->buffer[pos] >= '0' &&
+         reader->buffer[pos] <= '9';
 }
 
-// Dataset analysis function
-void analyze_dataset(const char *filename) {
-  FILE *fp = fopen(filename, "r");
-  if (!fp) {
-    printf("Cannot analyze %s - file not found\n", filename);
-    return;
+static inline uint64_t mix64(uint64_t x) {
+  return splitmix64(&x);
+}
+
+// HyperLogLog distinct-count estimate over HLL_REGISTERS registers
+// (Flajolet et al. 2007, with linear counting for small cardinalities)
+typedef struct {
+  uint8_t registers[HLL_REGISTERS];
+} HyperLogLog;
+
+static inline void hll_add(HyperLogLog *hll, uint64_t hash) {
+  uint32_t index = (uint32_t)(hash >> (64 - HLL_BITS));
+  uint64_t rest = hash << HLL_BITS;
+  uint8_t rank = rest ? (uint8_t)(__builtin_clzll(rest) + 1)
+                      : (uint8_t)(64 - HLL_BITS + 1);
+  if (rank > hll->registers[index]) {
+    hll->registers[index] = rank;
+  }
+}
+
+static double hll_estimate(const HyperLogLog *hll) {
+  double m = HLL_REGISTERS;
+  double sum = 0.0;
+  int zeros = 0;
+  for (int i = 0; i < HLL_REGISTERS; i++) {
+    sum += ldexp(1.0, -hll->registers[i]);
+    zeros += hll->registers[i] == 0;
+  }
+  double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * log(m / zeros);
+  }
+  return estimate;
+}
+
+// Heavy hitters: a count-min sketch estimates every key's count, and a
+// min-heap keeps the TOPK_SIZE keys with the largest estimates, found
+// through a small open-addressed index
+typedef struct {
+  uint32_t key;
+  uint32_t count;
+} HeavyHitter;
+
+typedef struct {
+  uint32_t cm[CM_DEPTH][CM_WIDTH];
+  HeavyHitter heap[TOPK_SIZE];
+  int heap_size;
+  int32_t slot_heap[TOPK_SLOTS]; // Heap position of each indexed key, -1 empty
+  uint32_t slot_key[TOPK_SLOTS];
+} HeavyHitters;
+
+static int topk_slot(const HeavyHitters *hh, uint32_t key) {
+  uint32_t slot = (uint32_t)mix64(key) & (TOPK_SLOTS - 1);
+  while (hh->slot_heap[slot] >= 0 && hh->slot_key[slot] != key) {
+    slot = (slot + 1) & (TOPK_SLOTS - 1);
+  }
+  return (int)slot;
+}
+
+static void topk_unindex(HeavyHitters *hh, uint32_t key) {
+  // Backward-shift deletion keeps every probe chain unbroken
+  uint32_t hole = (uint32_t)topk_slot(hh, key);
+  hh->slot_heap[hole] = -1;
+  for (uint32_t next = (hole + 1) & (TOPK_SLOTS - 1);
+       hh->slot_heap[next] >= 0; next = (next + 1) & (TOPK_SLOTS - 1)) {
+    uint32_t home = (uint32_t)mix64(hh->slot_key[next]) & (TOPK_SLOTS - 1);
+    if (((next - home) & (TOPK_SLOTS - 1)) >=
+        ((next - hole) & (TOPK_SLOTS - 1))) {
+      hh->slot_key[hole] = hh->slot_key[next];
+      hh->slot_heap[hole] = hh->slot_heap[next];
+      hh->slot_heap[next] = -1;
+      hole = next;
+    }
   }
+}
 
-  int initial_known, num_packets, ip_range;
-  fscanf(fp, "%d %d %d", &initial_known, &num_packets, &ip_range);
+static void topk_place(HeavyHitters *hh, int pos, HeavyHitter item) {
+  hh->heap[pos] = item;
+  int slot = topk_slot(hh, item.key);
+  hh->slot_key[slot] = item.key;
+  hh->slot_heap[slot] = pos;
+}
+
+static void topk_sift_down(HeavyHitters *hh, int pos) {
+  HeavyHitter item = hh->heap[pos];
+  int start = pos;
+  for (;;) {
+    int child = 2 * pos + 1;
+    if (child >= hh->heap_size) {
+      break;
+    }
+    if (child + 1 < hh->heap_size &&
+        hh->heap[child + 1].count < hh->heap[child].count) {
+      child++;
+    }
+    if (hh->heap[child].count >= item.count) {
+      break;
+    }
+    topk_place(hh, pos, hh->heap[child]);
+    pos = child;
+  }
+  if (pos != start) {
+    topk_place(hh, pos, item);
+  }
+}
 
-  // Skip known flows
-  for (int i = 0; i < initial_known; i++) {
-    int tmp;
-    fscanf(fp, "%d", &tmp);
+static void topk_sift_up(HeavyHitters *hh, int pos) {
+  HeavyHitter item = hh->heap[pos];
+  while (pos > 0 && hh->heap[(pos - 1) / 2].count > item.count) {
+    topk_place(hh, pos, hh->heap[(pos - 1) / 2]);
+    pos = (pos - 1) / 2;
   }
+  topk_place(hh, pos, item);
+}
 
-  // Analyze packet distribution
-  int *ip_counts = (int *)calloc(ip_range, sizeof(int));
-  int total_flows = 0;
+static void heavy_hitters_init(HeavyHitters *hh) {
+  memset(hh->cm, 0, sizeof(hh->cm));
+  hh->heap_size = 0;
+  memset(hh->slot_heap, 0xff, sizeof(hh->slot_heap));
+}
 
-  int prev_ip = -1;
-  int current_flow_size = 0;
+static inline void heavy_hitters_add(HeavyHitters *hh, uint32_t key,
+                                     uint64_t hash) {
+  uint32_t estimate = UINT32_MAX;
+  for (int d = 0; d < CM_DEPTH; d++) {
+    uint32_t *cell = &hh->cm[d][(hash >> (d * CM_BITS)) & (CM_WIDTH - 1)];
+    if (*cell < UINT32_MAX) {
+      ++*cell;
+    }
+    if (*cell < estimate) {
+      estimate = *cell;
+    }
+  }
 
-  for (int i = 0; i < num_packets; i++) {
-    int ip;
-    fscanf(fp, "%d", &ip);
-    ip_counts[ip]++;
+  // A tracked key's estimate grows by at least one per packet, so a key
+  // estimated at or below the heap minimum cannot be in a full heap
+  if (hh->heap_size == TOPK_SIZE && estimate <= hh->heap[0].count) {
+    return;
+  }
+  int slot = topk_slot(hh, key);
+  int pos = hh->slot_heap[slot];
+  if (pos >= 0) {
+    hh->heap[pos].count = estimate; // Estimates only grow: sift toward leaves
+    topk_sift_down(hh, pos);
+  } else if (hh->heap_size < TOPK_SIZE) {
+    hh->heap[hh->heap_size] = (HeavyHitter){key, estimate};
+    topk_sift_up(hh, hh->heap_size++);
+  } else if (estimate > hh->heap[0].count) {
+    topk_unindex(hh, hh->heap[0].key);
+    topk_place(hh, 0, (HeavyHitter){key, estimate});
+    topk_sift_down(hh, 0);
+  }
+}
 
-    if (ip == prev_ip) {
-      current_flow_size++;
+static int compare_counts_desc(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x < y) - (x > y);
+}
+
+// Sum of the k largest counts by quickselect: expected O(n), reorders counts
+static uint64_t top_k_sum(uint32_t *counts, size_t n, size_t k) {
+  size_t lo = 0;
+  size_t hi = n;
+  uint64_t sum = 0;
+  while (k > 0 && hi - lo > k) {
+    uint32_t pivot = counts[lo + (hi - lo) / 2];
+    // Three-way partition of [lo, hi) into > pivot, == pivot, < pivot
+    size_t gt = lo;
+    size_t i = lo;
+    size_t lt = hi;
+    while (i < lt) {
+      uint32_t c = counts[i];
+      if (c > pivot) {
+        counts[i++] = counts[gt];
+        counts[gt++] = c;
+      } else if (c < pivot) {
+        counts[i] = counts[--lt];
+        counts[lt] = c;
+      } else {
+        i++;
+      }
+    }
+    size_t above = gt - lo;
+    size_t equal = lt - gt;
+    if (k <= above) {
+      hi = gt;
+    } else if (k <= above + equal) {
+      for (size_t j = lo; j < gt; j++) {
+        sum += counts[j];
+      }
+      return sum + (uint64_t)pivot * (k - above);
     } else {
-      if (prev_ip != -1) {
-        total_flows++;
+      for (size_t j = lo; j < lt; j++) {
+        sum += counts[j];
       }
-      current_flow_size = 1;
-      prev_ip = ip;
+      k -= above + equal;
+      lo = lt;
     }
   }
+  for (size_t j = lo; j < lo + k && j < hi; j++) {
+    sum += counts[j];
+  }
+  return sum;
+}
 
-  // Calculate statistics
-  int unique_ips = 0;
-  int max_count = 0;
-  double mean_count = 0;
+// Traffic concentration: share of packets from the top 10% of the IP range.
+// Exact from dense counts (which it reorders).
+double calculate_concentration(uint32_t *ip_counts, size_t ip_range,
+                               uint64_t total_packets) {
+  if (total_packets == 0) {
+    return 0.0;
+  }
+  return 100.0 * (double)top_k_sum(ip_counts, ip_range, ip_range / 10) /
+         (double)total_packets;
+}
+
+// Dataset analysis in one streaming pass. Ranges up to ANALYZE_DENSE_RANGE
+// keep an exact counter per IP; larger ones use bounded-memory sketches:
+// HyperLogLog for unique IPs, count-min with a top-k heap for heavy hitters,
+// and an entropy estimate that takes the heavy hitters exactly and spreads
+// the remaining packets evenly over the remaining unique IPs. Returns 0, or
+// -1 with a message.
+int analyze_dataset(const char *filename) {
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) {
+    printf("Cannot analyze %s - file not found\n", filename);
+    return -1;
+  }
+  TraceReader reader = {fp, malloc(READ_BUFFER_SIZE), 0, 0, 0};
+  uint64_t initial_known = 0, num_packets = 0, ip_range = 0, value;
+  uint64_t ticks_per_second = 0;
+  int ok = reader.buffer &&
+           reader_next(&reader, UINT32_MAX, &initial_known) == 0 &&
+           reader_next(&reader, UINT64_MAX / 10, &num_packets) == 0 &&
+           reader_next(&reader, (uint64_t)UINT32_MAX + 1, &ip_range) == 0 &&
+           ip_range > 0;
+  if (ok && reader_line_continues(&reader)) {
+    ok = reader_next(&reader, UINT64_MAX / 10, &ticks_per_second) == 0 &&
+         ticks_per_second > 0;
+  }
+  for (uint64_t i = 0; ok && i < initial_known; i++) {
+    ok = reader_next(&reader, UINT32_MAX, &value) == 0; // Known flows
+  }
 
-  for (int i = 0; i < ip_range; i++) {
-    if (ip_counts[i] > 0) {
-      unique_ips++;
-      mean_count += ip_counts[i];
-      if (ip_counts[i] > max_count) {
-        max_count = ip_counts[i];
+  int dense = ok && ip_range <= ANALYZE_DENSE_RANGE;
+  uint32_t *ip_counts = dense ? calloc(ip_range, sizeof(uint32_t)) : NULL;
+  HyperLogLog *hll = dense ? NULL : calloc(1, sizeof(HyperLogLog));
+  HeavyHitters *hh = dense ? NULL : malloc(sizeof(HeavyHitters));
+  if (ok && (dense ? !ip_counts : !hll || !hh)) {
+    printf("Cannot analyze %s - out of memory\n", filename);
+    ok = 0;
+  } else if (!dense && hh) {
+    heavy_hitters_init(hh);
+  }
+
+  double start = monotonic_seconds();
+  uint64_t packets = 0;
+  uint64_t first_tick = 0, last_tick = 0, tick = 0;
+  while (ok && packets < num_packets) {
+    ok = reader_next(&reader, ip_range - 1, &value) == 0;
+    if (ok && ticks_per_second) {
+      ok = reader_next(&reader, UINT64_MAX / 10, &tick) == 0;
+      if (packets == 0) {
+        first_tick = tick;
       }
+      last_tick = tick > last_tick ? tick : last_tick;
+    }
+    if (!ok) {
+      break;
+    }
+    if (dense) {
+      ip_counts[value]++;
+    } else {
+      uint64_t hash = mix64(value);
+      hll_add(hll, hash);
+      heavy_hitters_add(hh, (uint32_t)value, hash);
+    }
+    packets++;
+  }
+  double seconds = monotonic_seconds() - start;
+  free(reader.buffer);
+  fclose(fp);
+  if (!ok || packets == 0) {
+    if (packets < num_packets) {
+      printf("Cannot analyze %s - truncated or malformed trace\n", filename);
     }
+    free(ip_counts);
+    free(hll);
+    free(hh);
+    return ok ? 0 : -1;
   }
-  mean_count /= unique_ips;
 
-  // Calculate entropy
+  double unique_ips = 0.0;
+  uint64_t max_count = 0;
   double entropy = 0.0;
-  for (int i = 0; i < ip_range; i++) {
-    if (ip_counts[i] > 0) {
-      double p = (double)ip_counts[i] / num_packets;
+  double concentration;
+  int concentration_bound = 0;
+  size_t top_decile = (size_t)(ip_range / 10);
+  if (dense) {
+    uint64_t unique = 0;
+    for (uint64_t i = 0; i < ip_range; i++) {
+      uint32_t count = ip_counts[i];
+      if (count > 0) {
+        unique++;
+        if (count > max_count) {
+          max_count = count;
+        }
+        double p = (double)count / packets;
+        entropy -= p * log2(p);
+      }
+    }
+    unique_ips = (double)unique;
+    concentration = calculate_concentration(ip_counts, ip_range, packets);
+  } else {
+    unique_ips = hll_estimate(hll);
+    uint32_t *counts = malloc(TOPK_SIZE * sizeof(uint32_t));
+    int k = 0;
+    for (int i = 0; counts && i < hh->heap_size; i++) {
+      counts[k++] = hh->heap[i].count;
+    }
+    qsort(counts, (size_t)k, sizeof(uint32_t), compare_counts_desc);
+    // Count-min overestimates: cap the running sum at the packet count
+    uint64_t heavy = 0;
+    uint64_t decile = 0;
+    int counted = 0;
+    while (counted < k && heavy < packets) {
+      uint64_t count = packets - heavy;
+      if (counts[counted] < count) {
+        count = counts[counted];
+      }
+      double p = (double)count / packets;
       entropy -= p * log2(p);
+      heavy += count;
+      if ((size_t)++counted <= top_decile) {
+        decile = heavy;
+      }
+    }
+    max_count = k > 0 ? counts[0] : 0;
+    double tail_ips = unique_ips - counted;
+    if (packets > heavy && tail_ips >= 1.0) {
+      double tail = (double)(packets - heavy) / packets;
+      entropy -= tail * log2(tail / tail_ips);
     }
+    if (top_decile >= unique_ips) {
+      concentration = 100.0; // Every IP seen is in the top decile
+    } else {
+      concentration = 100.0 * decile / packets;
+      concentration_bound = top_decile > (size_t)counted; // Top k known only
+    }
+    free(counts);
   }
 
   printf("\n📊 Dataset Analysis for %s:\n", filename);
-  printf("  Total packets: %d\n", num_packets);
-  printf("  Unique IPs: %d / %d (%.1f%%)\n", unique_ips, ip_range,
-         100.0 * unique_ips / ip_range);
-  printf("  Max packets per IP: %d\n", max_count);
-  printf("  Mean packets per IP: %.1f\n", mean_count);
-  printf("  Shannon entropy: %.3f bits\n", entropy);
-  printf("  Traffic concentration: %.3f%% (top 10%% IPs)\n",
-         calculate_concentration(ip_counts, ip_range, num_packets));
+  printf("  Total packets: %llu (%.0f Mpkt/s)\n", (unsigned long long)packets,
+         packets / (seconds > 0.0 ? seconds : 1e-9) / 1e6);
+  printf("  Unique IPs: %s%.0f / %llu (%.1f%%)\n", dense ? "" : "~", unique_ips,
+         (unsigned long long)ip_range, 100.0 * unique_ips / ip_range);
+  printf("  Max packets per IP: %s%llu\n", dense ? "" : "~",
+         (unsigned long long)max_count);
+  printf("  Mean packets per IP: %.1f\n", packets / unique_ips);
+  printf("  Shannon entropy: %s%.3f bits\n", dense ? "" : "~", entropy);
+  printf("  Traffic concentration: %s%.3f%% (top 10%% IPs)\n",
+         concentration_bound ? ">=" : "", concentration);
+  if (ticks_per_second) {
+    double span = (double)(last_tick - first_tick) / ticks_per_second;
+    printf("  Packet-time span: %.3f s (%.3f Mpkt/s offered)\n", span,
+           span > 0.0 ? packets / span / 1e6 : 0.0);
+  }
 
   free(ip_counts);
-  fclose(fp);
+  free(hll);
+  free(hh);
+  return 0;
 }
 
 // Test runner for multiple datasets
-void run_dataset_tests() {
+int run_dataset_tests(const ArrivalConfig *arrivals, uint64_t seed) {
   printf("🧪 === MULTI-DATASET TESTING FRAMEWORK === 🧪\n\n");
 
-  // Generate all datasets
+  // Generate all datasets, one thread each
   printf("📁 Generating realistic network traffic datasets...\n\n");
-  for (int i = 0; i < NUM_DATASETS; i++) {
-    generate_dataset(&datasets[i]);
+  if (generate_all_datasets(arrivals, seed) != 0) {
+    return -1;
   }
 
   printf("\n📊 Analyzing generated datasets...\n");
@@ -608,10 +1535,162 @@ void run_dataset_tests() {
   }
   printf(
       "└─────────────────────────────────────────────────────────────────┘\n");
+  return 0;
 }
 
-int main() {
-  srand(time(NULL));
-  run_dataset_tests();
+// Scale mode: one trace of any length over up to the full 32-bit key space,
+// drawn with dataset profile's traffic model. Progress goes to stderr so the
+// trace itself can go to stdout.
+int generate_scale_trace(DatasetConfig *config, const ArrivalConfig *arrivals,
+                         uint64_t seed, uint64_t stream) {
+  double start = monotonic_seconds();
+  if (generate_dataset(config, arrivals, seed, stream) != 0) {
+    return -1;
+  }
+  double seconds = monotonic_seconds() - start;
+  fprintf(stderr,
+          "Generated %s: %llu packets over %llu IPs, up to %u active flows, "
+          "in %.1f s (%.1f Mpkt/s)\n",
+          config->filename, (unsigned long long)config->num_packets,
+          (unsigned long long)config->ip_range, config->max_active_flows,
+          seconds, config->num_packets / (seconds > 0.0 ? seconds : 1e-9) / 1e6);
   return 0;
 }
+
+static void print_usage(const char *program) {
+  printf("Usage: %s [--seed <n>] [--timestamps <model>] [--rate <pps>]\n"
+         "          [--check-zipf] [--analyze <trace>...]\n"
+         "       %s --scale <packets> [--dataset <n>] [--ip-range <n>]\n"
+         "          [--active-flows <n>] [--flow-idle <packets>] [--known <n>]\n"
+         "          [--timestamps <model>] [--rate <pps>] [--output <path>]\n\n",
+         program, program);
+  printf("  --seed <n>          PRNG seed; the same seed regenerates every "
+         "dataset\n                      byte for byte (default: %llu)\n",
+         (unsigned long long)DEFAULT_SEED);
+  printf("  --timestamps <model> Add nanosecond packet timestamps with poisson, "
+         "onoff\n                      (Pareto ON/OFF bursts) or diurnal "
+         "(sinusoidal rate)\n                      inter-arrival times "
+         "(default: none)\n");
+  printf("  --rate <pps>        Mean packets per second of the timestamps "
+         "(default: %.0f)\n",
+         DEFAULT_PACKET_RATE);
+  printf("  --check-zipf        Test the Zipf sampler's fit to the exact "
+         "distribution\n                      instead of generating\n");
+  printf("  --analyze           Analyze existing traces in one streaming pass "
+         "instead\n                      of generating\n");
+  printf("  --scale <packets>   Stream one trace of this many packets instead "
+         "of the\n                      suite\n");
+  printf("  --dataset <n>       Suite dataset whose traffic profile it uses "
+         "(default: 1)\n");
+  printf("  --ip-range <n>      Key space, up to 4294967296 (the default); "
+         "the IoT,\n                      video, gaming and DDoS profiles "
+         "need a minimum\n");
+  printf("  --active-flows <n>  Concurrent flows tracked (default: %u)\n",
+         SCALE_ACTIVE_FLOWS);
+  printf("  --flow-idle <n>     Packets before an idle flow is retired "
+         "(default: %d x\n                      active flows)\n",
+         SCALE_IDLE_FACTOR);
+  printf("  --known <n>         Known flows in the header (default: the "
+         "dataset's)\n");
+  printf("  --output <path>     Trace file, or - for stdout (default: %s)\n",
+         SCALE_OUTPUT);
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t seed = DEFAULT_SEED;
+  int zipf_check = 0;
+  int analyze_from = 0;
+  uint64_t scale_packets = 0;
+  uint64_t scale_dataset = 1;
+  uint64_t scale_range = 1ull << 32;
+  uint64_t scale_active = SCALE_ACTIVE_FLOWS;
+  uint64_t scale_idle = 0;
+  long long scale_known = -1;
+  const char *scale_output = SCALE_OUTPUT;
+  ArrivalConfig arrivals = {ARRIVALS_NONE, DEFAULT_PACKET_RATE};
+  for (int i = 1; i < argc && !analyze_from; i++) {
+    int has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--timestamps") == 0 && has_value &&
+               (strcmp(argv[i + 1], "none") == 0 ||
+                strcmp(argv[i + 1], "poisson") == 0 ||
+                strcmp(argv[i + 1], "onoff") == 0 ||
+                strcmp(argv[i + 1], "diurnal") == 0)) {
+      const char *model = argv[++i];
+      arrivals.model = strcmp(model, "poisson") == 0  ? ARRIVALS_POISSON
+                       : strcmp(model, "onoff") == 0  ? ARRIVALS_ONOFF
+                       : strcmp(model, "diurnal") == 0 ? ARRIVALS_DIURNAL
+                                                       : ARRIVALS_NONE;
+    } else if (strcmp(argv[i], "--rate") == 0 && has_value) {
+      arrivals.rate = strtod(argv[++i], NULL);
+    } else if (strcmp(argv[i], "--check-zipf") == 0) {
+      zipf_check = 1;
+    } else if (strcmp(argv[i], "--analyze") == 0 && has_value) {
+      analyze_from = i + 1;
+    } else if (strcmp(argv[i], "--scale") == 0 && has_value) {
+      scale_packets = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--dataset") == 0 && has_value) {
+      scale_dataset = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--ip-range") == 0 && has_value) {
+      scale_range = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--active-flows") == 0 && has_value) {
+      scale_active = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--flow-idle") == 0 && has_value) {
+      scale_idle = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--known") == 0 && has_value) {
+      scale_known = strtoll(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+      scale_output = argv[++i];
+    } else {
+      print_usage(argv[0]);
+      return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0
+                 ? 0
+                 : 1;
+    }
+  }
+  if (analyze_from) {
+    int status = 0;
+    for (int i = analyze_from; i < argc; i++) {
+      if (analyze_dataset(argv[i]) != 0) {
+        status = 1;
+      }
+    }
+    return status;
+  }
+  if (zipf_check) {
+    return check_zipf(seed) == 0 ? 0 : 1;
+  }
+  if (!(arrivals.rate > 0.0)) {
+    fprintf(stderr, "Invalid packet rate\n");
+    return 1;
+  }
+  if (scale_packets > 0) {
+    if (scale_dataset >= NUM_DATASETS || scale_range == 0 ||
+        scale_range > 1ull << 32 || scale_active == 0 ||
+        scale_active >= FLOW_NONE || scale_known > INT32_MAX ||
+        strlen(scale_output) >= sizeof(datasets[0].filename)) {
+      fprintf(stderr, "Invalid scale-mode option\n");
+      return 1;
+    }
+    uint64_t min_range = min_ip_range(datasets[scale_dataset].dataset_type);
+    if (scale_range < min_range) {
+      fprintf(stderr, "Dataset %llu needs an IP range of at least %llu\n",
+              (unsigned long long)scale_dataset,
+              (unsigned long long)min_range);
+      return 1;
+    }
+    DatasetConfig config = datasets[scale_dataset];
+    config.num_packets = scale_packets;
+    config.ip_range = scale_range;
+    config.max_active_flows = (uint32_t)scale_active;
+    config.flow_idle_packets =
+        scale_idle ? scale_idle : SCALE_IDLE_FACTOR * scale_active;
+    if (scale_known >= 0) {
+      config.initial_known_size = (int)scale_known;
+    }
+    strcpy(config.filename, scale_output);
+    return generate_scale_trace(&config, &arrivals, seed, scale_dataset) == 0 ? 0 : 1;
+  }
+  return run_dataset_tests(&arrivals, seed) == 0 ? 0 : 1;
+}
@@ -61,7 +61,7 @@ echo -e "${PURPLE}Step 2: Compiling components...${NC}"
 
 # Compile dataset generator
 echo "🔧 Compiling dataset generator..."
-gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2
+gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2 -pthread
 if [ $? -ne 0 ]; then
     echo -e "${RED}❌ Failed to compile dataset generator${NC}"
     exit 1
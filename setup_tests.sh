@@ -34,7 +34,7 @@ echo ""
 echo "🔨 Compiling dataset generator..."
 
 # Compile the dataset generator
-gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2
+gcc -o multi_dataset_generator multi_dataset_tester.c -lm -O2 -pthread
 if [ $? -ne 0 ]; then
     echo -e "${RED}❌ Failed to compile dataset generator${NC}"
     exit 1
@@ -0,0 +1,69 @@
+#ifndef DYNAFLOW_ACCELERATED_ENGINE_H
+#define DYNAFLOW_ACCELERATED_ENGINE_H
+
+// In-process interface to the ML-driven engine in hybrid_accelerated.c, for
+// drivers that run it next to other engines (dynaflow_bench). Building
+// hybrid_accelerated.c with -DDYNAFLOW_ENGINE_LIBRARY leaves out its main().
+//
+// The engine is a single global instance: open it on a trace's known flows,
+// run packets through it, read its counters and close it before opening it
+// again. Parameters set with accelerated_set_param() persist across opens.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "slow_path.h"
+
+typedef struct {
+  const char *pipeline;     // Pipeline variant name, NULL for "full"
+  const char *model_file;   // Start from a trained model, or NULL
+  int stumps;               // Route on model_file's stump ensemble
+  const char *shadow_spec;  // Shadow model (see --shadow), or NULL
+  uint32_t shadow_interval; // Shadow-score 1 in this many packets
+  int online_training;
+  int direct_index; // Direct-indexed lookup when the key range allows it
+  int arena;        // Carve engine memory from one up-front arena
+  int prefault;     // Touch every arena page before the first packet
+  int verbose;      // Print setup details on stdout
+  // Calibrated slow-path workload (slow_path.h), NULL for the legacy loop
+  SlowPathWorkload *slow_path;
+  // Inspection threads the slow path is offloaded to, 0 to run it inline.
+  // Packets of a flow awaiting a verdict are held, or with offload_pass
+  // pass on the fast path provisionally.
+  int offload_workers;
+  int offload_pass;
+} AcceleratedOptions;
+
+typedef struct {
+  uint64_t packets;
+  uint64_t fast_packets; // Fast and ultra-fast paths
+  uint64_t slow_packets; // Slow and deep-analysis paths
+  uint64_t flows_created;
+  size_t memory_bytes; // Engine memory reserved by accelerated_open()
+} AcceleratedCounts;
+
+void accelerated_default_options(AcceleratedOptions *options);
+
+// Override a tunable parameter ("name=value", see --list-params). Returns 0,
+// or -1 with a message on stderr.
+int accelerated_set_param(const char *assignment);
+
+// Apply a --params file of name=value lines. Returns 0, or -1 as above.
+int accelerated_load_params(const char *path);
+
+// Build a fresh engine for a trace with the given key range, pre-populated
+// with its known flows. Returns 0, or -1 with a message on stderr.
+int accelerated_open(const AcceleratedOptions *options, const int *known,
+                     int known_count, int num_packets, int ip_range);
+
+// Returns once every offloaded inspection of the run has been applied. times
+// holds each packet's time in microseconds (Trace.times), or is NULL to run
+// at the nominal one packet per microsecond.
+void accelerated_run(const int *packets, const uint64_t *times, int count);
+
+// Path counters need STATS_LEVEL >= 1 and a pipeline that keeps counters
+void accelerated_counts(AcceleratedCounts *counts);
+
+void accelerated_close(void);
+
+#endif // DYNAFLOW_ACCELERATED_ENGINE_H
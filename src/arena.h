@@ -0,0 +1,159 @@
+#ifndef DYNAFLOW_ARENA_H
+#define DYNAFLOW_ARENA_H
+
+// Single up-front memory arena for the engine's long-lived structures.
+//
+// All tables are carved out of one mapping so random accesses stay within a
+// handful of 2 MB pages instead of thousands of 4 KB ones. The mapping is
+// tried with MAP_HUGETLB first, then as a normal mapping with a
+// transparent-huge-page madvise, and finally falls back to calloc.
+//
+// Requires _GNU_SOURCE (or _DEFAULT_SOURCE) before the first system include.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define ARENA_HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define ARENA_SMALL_PAGE_SIZE 4096UL
+#define ARENA_ALIGN 64 // Cache-line alignment for every allocation
+
+typedef enum {
+  ARENA_BACKING_NONE = 0, // Arena disabled, engine uses calloc
+  ARENA_BACKING_HUGETLB = 1,
+  ARENA_BACKING_THP = 2,  // Regular mapping + MADV_HUGEPAGE
+  ARENA_BACKING_HEAP = 3, // mmap failed, one calloc block
+  ARENA_BACKING_COUNT = 4 // Sizing pass: tallies allocations, serves none
+} ArenaBacking;
+
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+  size_t exhausted; // Allocations refused for lack of room
+  ArenaBacking backing;
+} Arena;
+
+static inline const char *arena_backing_name(ArenaBacking backing) {
+  switch (backing) {
+  case ARENA_BACKING_HUGETLB:
+    return "hugetlb (2 MB pages)";
+  case ARENA_BACKING_THP:
+    return "transparent huge pages (madvise)";
+  case ARENA_BACKING_HEAP:
+    return "heap (no huge pages)";
+  case ARENA_BACKING_COUNT:
+    return "counting";
+  default:
+    return "disabled";
+  }
+}
+
+static inline size_t arena_round_up(size_t value, size_t align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+// Touch every page so page faults happen here rather than in the timed loop
+static inline void arena_prefault(Arena *arena) {
+  size_t step = arena->backing == ARENA_BACKING_HUGETLB ? ARENA_HUGE_PAGE_SIZE
+                                                        : ARENA_SMALL_PAGE_SIZE;
+  volatile uint8_t *p = arena->base;
+  for (size_t off = 0; off < arena->size; off += step) {
+    p[off] = 0;
+  }
+}
+
+// Returns 0 on success, -1 if no backing could be obtained
+static inline int arena_init(Arena *arena, size_t bytes, int prefault) {
+  memset(arena, 0, sizeof(Arena));
+  size_t size = arena_round_up(bytes, ARENA_HUGE_PAGE_SIZE);
+
+  void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mem != MAP_FAILED) {
+    arena->backing = ARENA_BACKING_HUGETLB;
+  }
+#endif
+
+  if (mem == MAP_FAILED) {
+    // Over-allocate so the usable region can start on a 2 MB boundary,
+    // which lets khugepaged back it with huge pages
+    size_t padded = size + ARENA_HUGE_PAGE_SIZE;
+    uint8_t *raw = (uint8_t *)mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED) {
+      uint8_t *aligned = (uint8_t *)arena_round_up((uintptr_t)raw,
+                                                   ARENA_HUGE_PAGE_SIZE);
+      size_t head = (size_t)(aligned - raw);
+      if (head > 0)
+        munmap(raw, head);
+      size_t tail = padded - head - size;
+      if (tail > 0)
+        munmap(aligned + size, tail);
+      mem = aligned;
+      arena->backing = ARENA_BACKING_THP;
+#ifdef MADV_HUGEPAGE
+      madvise(mem, size, MADV_HUGEPAGE);
+#endif
+    }
+  }
+
+  if (mem == MAP_FAILED) {
+    mem = calloc(1, size);
+    if (!mem)
+      return -1;
+    arena->backing = ARENA_BACKING_HEAP;
+  }
+
+  arena->base = (uint8_t *)mem;
+  arena->size = size;
+  if (prefault)
+    arena_prefault(arena);
+  return 0;
+}
+
+// Arena that hands out nothing but adds up what a sequence of arena_alloc
+// calls would take, alignment included, in used
+static inline void arena_init_counting(Arena *arena) {
+  memset(arena, 0, sizeof(Arena));
+  arena->backing = ARENA_BACKING_COUNT;
+}
+
+// Zeroed, cache-line aligned; NULL once the arena is exhausted, and always
+// NULL from a counting arena
+static inline void *arena_alloc(Arena *arena, size_t bytes) {
+  size_t offset = arena_round_up(arena->used, ARENA_ALIGN);
+  if (!arena->base) {
+    if (arena->backing == ARENA_BACKING_COUNT)
+      arena->used = offset + bytes;
+    return NULL;
+  }
+  if (offset + bytes > arena->size) {
+    arena->exhausted++;
+    return NULL;
+  }
+  arena->used = offset + bytes;
+  return arena->base + offset;
+}
+
+static inline int arena_owns(const Arena *arena, const void *ptr) {
+  const uint8_t *p = (const uint8_t *)ptr;
+  return arena->base && p >= arena->base && p < arena->base + arena->size;
+}
+
+static inline void arena_destroy(Arena *arena) {
+  if (!arena->base)
+    return;
+  if (arena->backing == ARENA_BACKING_HEAP) {
+    free(arena->base);
+  } else {
+    munmap(arena->base, arena->size);
+  }
+  memset(arena, 0, sizeof(Arena));
+}
+
+#endif // DYNAFLOW_ARENA_H
@@ -0,0 +1,183 @@
+#ifndef DYNAFLOW_BASELINE_ENGINES_H
+#define DYNAFLOW_BASELINE_ENGINES_H
+
+// Packet loops of the baseline engines, shared by their own programs
+// (traditional, hybrid_immediate, hybrid_feedback) and the benchmark driver
+// (dynaflow_bench). Each loop takes the known-flow set, the slow-path
+// workload and a packet array and returns the number of packets that took
+// the slow path.
+
+#include "flow_lookup.h"
+#include "slow_path.h"
+
+#define FEEDBACK_INTERVAL 50000  // Default packets per feedback window
+#define SLOW_PATH_THRESHOLD 0.05 // Default slow-path share that triggers it
+
+// Simulated "expensive" operation (the legacy slow path)
+static inline void deep_inspection(int ip) {
+  int count = 0;
+  for (int i = 1; i <= ip; i++) {
+    if (ip % i == 0) {
+      count++;
+    }
+  }
+}
+
+// Simulated "fast" operation
+static inline void fast_path_action(int ip) {
+  volatile int result = ip * 2;
+  (void)result;
+}
+
+static inline void slow_path_inspect(SlowPathWorkload *workload, int ip) {
+  if (workload->kind == SLOW_PATH_LEGACY) {
+    deep_inspection(ip);
+  } else {
+    slow_path_run(workload, (uint32_t)ip);
+  }
+}
+
+// Traditional: a static set of known flows; unknown flows always go slow
+static inline long long traditional_process(const FlowSet *known_flows,
+                                            SlowPathWorkload *workload,
+                                            const int *packets,
+                                            int num_packets) {
+  long long slow_path_count = 0;
+  for (int i = 0; i < num_packets; i++) {
+    int ip = packets[i];
+    if (flowset_contains(known_flows, ip)) {
+      fast_path_action(ip);
+    } else {
+      slow_path_inspect(workload, ip);
+      slow_path_count++;
+    }
+  }
+  return slow_path_count;
+}
+
+// Immediate learning: a flow is known from its first slow-path packet on
+static inline long long immediate_process(FlowSet *known_flows,
+                                          int *known_count,
+                                          SlowPathWorkload *workload,
+                                          const int *packets,
+                                          int num_packets) {
+  long long slow_path_count = 0;
+  for (int i = 0; i < num_packets; i++) {
+    int ip = packets[i];
+    if (flowset_contains(known_flows, ip)) {
+      fast_path_action(ip);
+    } else {
+      slow_path_inspect(workload, ip);
+      slow_path_count++;
+      *known_count += flowset_insert(known_flows, ip);
+    }
+  }
+  return slow_path_count;
+}
+
+// Feedback learning state: the distinct IPs that missed in the current
+// window, deduplicated by a hash set whose slots are tagged with the window
+// number, so starting a new window clears nothing
+typedef struct {
+  int window;       // Packets per feedback window
+  double threshold; // Learn when more than this share of a window went slow
+  int *missed;      // Distinct missed IPs of the current window
+  int missed_count;
+  uint64_t *seen; // (window number << 32) | IP, 0 = empty
+  uint32_t seen_mask;
+  uint32_t generation;
+  long long windows;         // Complete windows processed
+  long long learned_windows; // Windows that crossed the threshold
+} FeedbackState;
+
+// Returns 0, or -1 with a message on stderr
+static inline int feedback_init(FeedbackState *state, int window,
+                                double threshold) {
+  memset(state, 0, sizeof(*state));
+  if (window < 1 || threshold < 0.0 || threshold >= 1.0) {
+    fprintf(stderr, "Feedback window must be positive and threshold in "
+                    "[0, 1)\n");
+    return -1;
+  }
+  state->window = window;
+  state->threshold = threshold;
+  uint32_t slots = next_pow2((uint32_t)window * 2);
+  state->missed = malloc((size_t)window * sizeof(int));
+  state->seen = calloc(slots, sizeof(uint64_t));
+  state->seen_mask = slots - 1;
+  state->generation = 1;
+  if (!state->missed || !state->seen) {
+    fprintf(stderr, "Failed to allocate the feedback window\n");
+    free(state->missed);
+    free(state->seen);
+    return -1;
+  }
+  return 0;
+}
+
+static inline void feedback_free(FeedbackState *state) {
+  free(state->missed);
+  free(state->seen);
+  state->missed = NULL;
+  state->seen = NULL;
+}
+
+// Remember a missed IP once per window
+static inline void feedback_note_miss(FeedbackState *state, int ip) {
+  uint64_t tagged = (uint64_t)state->generation << 32 | (uint32_t)ip;
+  uint32_t slot = flowset_hash((uint32_t)ip) & state->seen_mask;
+  while ((state->seen[slot] >> 32) == state->generation) {
+    if (state->seen[slot] == tagged) {
+      return;
+    }
+    slot = (slot + 1) & state->seen_mask;
+  }
+  state->seen[slot] = tagged;
+  state->missed[state->missed_count++] = ip;
+}
+
+// Feedback: when a window of state->window packets sent more than
+// state->threshold of them to the slow path, learn the distinct flows that
+// missed in that window. A trailing partial window never triggers learning.
+static inline long long feedback_process(FlowSet *known_flows,
+                                         int *known_count,
+                                         FeedbackState *state,
+                                         SlowPathWorkload *workload,
+                                         const int *packets,
+                                         int num_packets) {
+  long long slow_path_count = 0;
+  int window_slow_count = 0; // Slow path count for current window
+  int window_fill = 0;       // Packets seen in current window
+  for (int i = 0; i < num_packets; i++) {
+    int ip = packets[i];
+    if (flowset_contains(known_flows, ip)) {
+      fast_path_action(ip);
+    } else {
+      slow_path_inspect(workload, ip);
+      slow_path_count++;
+      window_slow_count++;
+      feedback_note_miss(state, ip);
+    }
+
+    if (++window_fill == state->window) {
+      double slow_ratio = (double)window_slow_count / state->window;
+      if (slow_ratio > state->threshold) {
+        for (int j = 0; j < state->missed_count; j++) {
+          *known_count += flowset_insert(known_flows, state->missed[j]);
+        }
+        state->learned_windows++;
+      }
+      state->windows++;
+      state->missed_count = 0;
+      if (++state->generation == 0) { // Tags wrapped: clear them once
+        memset(state->seen, 0, (state->seen_mask + 1) * sizeof(uint64_t));
+        state->generation = 1;
+      }
+      window_slow_count = 0;
+      window_fill = 0;
+    }
+  }
+  return slow_path_count;
+}
+
+#endif // DYNAFLOW_BASELINE_ENGINES_H
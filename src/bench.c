@@ -0,0 +1,459 @@
+// dynaflow_bench: run every engine in one process on traces loaded once.
+//
+// Each engine sits behind the same setup / run / counts / teardown interface.
+// Per dataset and engine the driver does a number of untimed warm-up runs,
+// then K timed repetitions, each on freshly built state. Only run() is
+// timed, in process CPU time like the engine programs' clock(). Mpps and
+// slow-path counts are reported as mean, sample standard deviation and a
+// Student-t 95% confidence interval, on stdout and as one tab-separated
+// results file per invocation.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "accelerated_engine.h"
+#include "baseline_engines.h"
+#include "trace.h"
+
+#define BENCH_DEFAULT_REPS 5
+#define BENCH_DEFAULT_WARMUP 1
+#define BENCH_MAX_REPS 1000
+#define BENCH_RESULTS_DIR "bench_results"
+
+typedef struct {
+  long long fast_packets;
+  long long slow_packets;
+} BenchCounts;
+
+// setup() builds fresh state for a trace and is not timed; run() pushes every
+// packet through it; counts() reads the outcome before teardown()
+typedef struct {
+  const char *name;
+  int (*setup)(const Trace *trace);
+  void (*run)(const Trace *trace);
+  BenchCounts (*counts)(const Trace *trace);
+  void (*teardown)(void);
+} BenchEngine;
+
+typedef struct {
+  double mean;
+  double stddev;
+  double ci95; // Half-width of the 95% confidence interval of the mean
+} BenchSummary;
+
+// Baseline state
+static LookupBackend g_backend = LOOKUP_HASH;
+static FlowSet g_known_flows;
+static int g_known_count;
+static long long g_slow_path_count;
+static FeedbackState g_feedback;
+static int g_feedback_window = FEEDBACK_INTERVAL;
+static double g_feedback_threshold = SLOW_PATH_THRESHOLD;
+
+// hybrid_accelerated options
+static AcceleratedOptions g_accelerated;
+
+// Slow-path workload of every engine, calibrated once per invocation
+static SlowPathWorkload g_workload;
+
+static int baseline_setup(const Trace *trace, int capacity) {
+  flowset_init(&g_known_flows, g_backend, capacity, trace->ip_range);
+  for (int i = 0; i < trace->known_count; i++) {
+    flowset_insert(&g_known_flows, trace->known[i]);
+  }
+  g_known_count = trace->known_count;
+  g_slow_path_count = 0;
+  return 0;
+}
+
+// Same set sizing as the baseline programs
+static int traditional_setup(const Trace *trace) {
+  return baseline_setup(trace, trace->known_count);
+}
+
+static int learning_setup(const Trace *trace) {
+  return baseline_setup(trace, trace->known_count * 2);
+}
+
+static int feedback_setup(const Trace *trace) {
+  if (feedback_init(&g_feedback, g_feedback_window, g_feedback_threshold) !=
+      0) {
+    return -1;
+  }
+  return learning_setup(trace);
+}
+
+static void traditional_run(const Trace *trace) {
+  g_slow_path_count =
+      traditional_process(&g_known_flows, &g_workload, trace->packets,
+                          trace->packet_count);
+}
+
+static void immediate_run(const Trace *trace) {
+  g_slow_path_count =
+      immediate_process(&g_known_flows, &g_known_count, &g_workload,
+                        trace->packets, trace->packet_count);
+}
+
+static void feedback_run(const Trace *trace) {
+  g_slow_path_count =
+      feedback_process(&g_known_flows, &g_known_count, &g_feedback,
+                       &g_workload, trace->packets, trace->packet_count);
+}
+
+static BenchCounts baseline_counts(const Trace *trace) {
+  BenchCounts counts;
+  counts.slow_packets = g_slow_path_count;
+  counts.fast_packets = trace->packet_count - g_slow_path_count;
+  return counts;
+}
+
+static void baseline_teardown(void) { flowset_free(&g_known_flows); }
+
+static void feedback_teardown(void) {
+  feedback_free(&g_feedback);
+  baseline_teardown();
+}
+
+static int accelerated_setup(const Trace *trace) {
+  return accelerated_open(&g_accelerated, trace->known, trace->known_count,
+                          trace->packet_count, trace->ip_range);
+}
+
+static void accelerated_bench_run(const Trace *trace) {
+  accelerated_run(trace->packets, trace->times, trace->packet_count);
+}
+
+static BenchCounts accelerated_bench_counts(const Trace *trace) {
+  (void)trace;
+  AcceleratedCounts engine;
+  accelerated_counts(&engine);
+  BenchCounts counts;
+  counts.fast_packets = (long long)engine.fast_packets;
+  counts.slow_packets = (long long)engine.slow_packets;
+  return counts;
+}
+
+static const BenchEngine bench_engines[] = {
+    {"traditional", traditional_setup, traditional_run, baseline_counts,
+     baseline_teardown},
+    {"hybrid_immediate", learning_setup, immediate_run, baseline_counts,
+     baseline_teardown},
+    {"hybrid_feedback", feedback_setup, feedback_run, baseline_counts,
+     feedback_teardown},
+    {"hybrid_accelerated", accelerated_setup, accelerated_bench_run,
+     accelerated_bench_counts, accelerated_close}};
+
+#define BENCH_ENGINE_COUNT                                                     \
+  (int)(sizeof(bench_engines) / sizeof(bench_engines[0]))
+
+static double cpu_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Two-sided 95% Student-t quantile for df degrees of freedom
+static double student_t95(int df) {
+  static const double table[30] = {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+      2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+      2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (df < 1) {
+    return 0.0;
+  }
+  return df <= 30 ? table[df - 1] : 1.960;
+}
+
+static BenchSummary summarize(const double *samples, int n) {
+  BenchSummary summary = {0.0, 0.0, 0.0};
+  for (int i = 0; i < n; i++) {
+    summary.mean += samples[i];
+  }
+  summary.mean /= n;
+  if (n > 1) {
+    double sum_sq = 0.0;
+    for (int i = 0; i < n; i++) {
+      double d = samples[i] - summary.mean;
+      sum_sq += d * d;
+    }
+    summary.stddev = sqrt(sum_sq / (n - 1));
+    summary.ci95 = student_t95(n - 1) * summary.stddev / sqrt((double)n);
+  }
+  return summary;
+}
+
+static int find_engine(const char *name) {
+  for (int i = 0; i < BENCH_ENGINE_COUNT; i++) {
+    if (strcmp(bench_engines[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Parse a comma-separated engine list into selected[]. Returns 0 or -1.
+static int parse_engines(const char *list, int *selected) {
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "%s", list);
+  memset(selected, 0, BENCH_ENGINE_COUNT * sizeof(int));
+  for (char *name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+    int engine = find_engine(name);
+    if (engine < 0) {
+      fprintf(stderr, "Unknown engine: %s\n", name);
+      return -1;
+    }
+    selected[engine] = 1;
+  }
+  return 0;
+}
+
+static void print_usage(const char *program_name) {
+  printf("Usage: %s [options] dataset_file...\n\n", program_name);
+  printf("Runs each engine on each dataset with warm-up and repeated timed "
+         "runs.\n\n");
+  printf("  --engines <list>  Comma-separated engines (default: all)\n");
+  printf("  --reps <K>        Timed repetitions per engine (default: %d)\n",
+         BENCH_DEFAULT_REPS);
+  printf("  --warmup <N>      Untimed runs before the timed ones "
+         "(default: %d)\n",
+         BENCH_DEFAULT_WARMUP);
+  printf("  --lookup <name>   Baseline known-flow lookup backend "
+         "(default: hash)\n");
+  printf("  --window <N>, --threshold <share>\n");
+  printf("                    hybrid_feedback window and learning threshold\n");
+  printf("  --slow-path <kind[:cycles]>\n");
+  printf("                    Slow-path workload of every engine "
+         "(default: legacy)\n");
+  printf("  --offload <N>     hybrid_accelerated inspection threads (default: "
+         "0,\n"
+         "                    inline); their CPU time counts toward Mpps\n");
+  printf("  --offload-policy hold|pass\n");
+  printf("                    Packets of flows awaiting a verdict "
+         "(default: hold)\n");
+  printf("  --pipeline <name> hybrid_accelerated pipeline variant\n");
+  printf("  --param name=value, --params <file>\n");
+  printf("                    hybrid_accelerated parameter overrides\n");
+  printf("  --model <file>    Start hybrid_accelerated from a trained model\n");
+  printf("  --output <file>   Results file (default: %s/bench_<time>.tsv)\n\n",
+         BENCH_RESULTS_DIR);
+  printf("Engines:");
+  for (int i = 0; i < BENCH_ENGINE_COUNT; i++) {
+    printf(" %s", bench_engines[i].name);
+  }
+  printf("\n\n");
+  print_lookup_backends(stdout);
+  printf("\n");
+  print_slow_path_workloads(stdout);
+}
+
+// Warm up, then time reps runs of one engine on one trace and append the
+// summary to results. Returns 0, or -1 if the engine could not be set up.
+static int bench_engine(const BenchEngine *engine, const Trace *trace,
+                        const char *dataset, int warmup, int reps,
+                        FILE *results) {
+  double mpps[BENCH_MAX_REPS];
+  double slow[BENCH_MAX_REPS];
+  double fast_share = 0.0;
+
+  for (int i = 0; i < warmup + reps; i++) {
+    if (engine->setup(trace) != 0) {
+      fprintf(stderr, "%s: setup failed on %s\n", engine->name, dataset);
+      return -1;
+    }
+    double start = cpu_seconds();
+    engine->run(trace);
+    double elapsed = cpu_seconds() - start;
+    BenchCounts counts = engine->counts(trace);
+    engine->teardown();
+
+    if (i >= warmup) {
+      int rep = i - warmup;
+      mpps[rep] = elapsed > 0 ? trace->packet_count / elapsed / 1e6 : 0.0;
+      slow[rep] = (double)counts.slow_packets;
+      fast_share += (double)counts.fast_packets / trace->packet_count;
+    }
+  }
+  fast_share /= reps;
+
+  BenchSummary mpps_summary = summarize(mpps, reps);
+  BenchSummary slow_summary = summarize(slow, reps);
+  printf("  %-18s %8.2f ± %-6.2f (sd %5.2f) %12.0f ± %-10.0f %6.2f%%\n",
+         engine->name, mpps_summary.mean, mpps_summary.ci95,
+         mpps_summary.stddev, slow_summary.mean, slow_summary.ci95,
+         100.0 * fast_share);
+
+  fprintf(results, "%s\t%s\t%d\t%d\t%.4f\t%.4f\t%.4f\t%.1f\t%.1f\t%.1f\t%.6f\t",
+          dataset, engine->name, trace->packet_count, reps, mpps_summary.mean,
+          mpps_summary.stddev, mpps_summary.ci95, slow_summary.mean,
+          slow_summary.stddev, slow_summary.ci95, fast_share);
+  for (int rep = 0; rep < reps; rep++) {
+    fprintf(results, "%s%.4f", rep ? "," : "", mpps[rep]);
+  }
+  fprintf(results, "\n");
+  fflush(results);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int selected[BENCH_ENGINE_COUNT];
+  for (int i = 0; i < BENCH_ENGINE_COUNT; i++) {
+    selected[i] = 1;
+  }
+  int reps = BENCH_DEFAULT_REPS;
+  int warmup = BENCH_DEFAULT_WARMUP;
+  const char *output_file = NULL;
+  SlowPathKind slow_path = SLOW_PATH_LEGACY;
+  uint32_t slow_path_cycles = SLOW_PATH_DEFAULT_CYCLES;
+  const char **datasets = calloc((size_t)argc, sizeof(char *));
+  int dataset_count = 0;
+  accelerated_default_options(&g_accelerated);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc) {
+      if (parse_engines(argv[++i], selected) != 0) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      reps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      warmup = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--lookup") == 0 && i + 1 < argc) {
+      if (parse_lookup_backend(argv[++i], &g_backend) != 0) {
+        fprintf(stderr, "Unknown lookup backend: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+      g_feedback_window = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      g_feedback_threshold = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--slow-path") == 0 && i + 1 < argc) {
+      if (parse_slow_path(argv[++i], &slow_path, &slow_path_cycles) != 0) {
+        fprintf(stderr, "Invalid slow-path workload: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--offload") == 0 && i + 1 < argc) {
+      g_accelerated.offload_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--offload-policy") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "hold") != 0 && strcmp(argv[i], "pass") != 0) {
+        fprintf(stderr, "Unknown offload policy: %s\n", argv[i]);
+        return 1;
+      }
+      g_accelerated.offload_pass = strcmp(argv[i], "pass") == 0;
+    } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+      g_accelerated.pipeline = argv[++i];
+    } else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc) {
+      if (accelerated_set_param(argv[++i]) != 0) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--params") == 0 && i + 1 < argc) {
+      if (accelerated_load_params(argv[++i]) != 0) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+      g_accelerated.model_file = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+      print_usage(argv[0]);
+      return 1;
+    } else {
+      datasets[dataset_count++] = argv[i];
+    }
+  }
+  if (dataset_count == 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  if (reps < 1 || reps > BENCH_MAX_REPS || warmup < 0) {
+    fprintf(stderr, "--reps must be in [1, %d] and --warmup non-negative\n",
+            BENCH_MAX_REPS);
+    return 1;
+  }
+
+  if (slow_path_init(&g_workload, slow_path, slow_path_cycles) != 0) {
+    return 1;
+  }
+  g_accelerated.slow_path = &g_workload;
+
+  time_t now = time(NULL);
+  char stamp[32];
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+  char default_output[64];
+  if (!output_file) {
+    if (mkdir(BENCH_RESULTS_DIR, 0755) != 0 && errno != EEXIST) {
+      perror(BENCH_RESULTS_DIR);
+      return 1;
+    }
+    snprintf(default_output, sizeof(default_output), "%s/bench_%s.tsv",
+             BENCH_RESULTS_DIR, stamp);
+    output_file = default_output;
+  }
+  FILE *results = fopen(output_file, "w");
+  if (!results) {
+    perror(output_file);
+    return 1;
+  }
+  fprintf(results, "# dynaflow_bench %s\n", stamp);
+  fprintf(results,
+          "# reps=%d warmup=%d lookup=%s window=%d threshold=%.4f "
+          "pipeline=%s model=%s offload=%d/%s\n",
+          reps, warmup, lookup_backend_name(g_backend), g_feedback_window,
+          g_feedback_threshold,
+          g_accelerated.pipeline ? g_accelerated.pipeline : "full",
+          g_accelerated.model_file ? g_accelerated.model_file : "none",
+          g_accelerated.offload_workers,
+          g_accelerated.offload_pass ? "pass" : "hold");
+  fprintf(results, "# ");
+  print_slow_path_workload(results, &g_workload);
+  fprintf(results, "# ci95 columns are half-widths of the Student-t 95%% "
+                   "confidence interval of the mean\n");
+  fprintf(results,
+          "dataset\tengine\tpackets\treps\tmpps_mean\tmpps_stddev\tmpps_ci95"
+          "\tslow_mean\tslow_stddev\tslow_ci95\tfast_share\tmpps_samples\n");
+
+  printf("=== DynaFlow Benchmark ===\n");
+  printf("%d warm-up + %d timed runs per engine, baseline lookup %s\n",
+         warmup, reps, lookup_backend_name(g_backend));
+  print_slow_path_workload(stdout, &g_workload);
+  printf("\n");
+
+  int status = 0;
+  for (int d = 0; d < dataset_count; d++) {
+    Trace trace;
+    if (trace_load(datasets[d], &trace) != 0) {
+      status = 1;
+      continue;
+    }
+    printf("%s (%d packets, %d known flows, IP range %d)\n", datasets[d],
+           trace.packet_count, trace.known_count, trace.ip_range);
+    printf("  %-18s %-28s %-25s %s\n", "Engine", "Mpps (95% CI)",
+           "Slow path (95% CI)", "Fast");
+    for (int e = 0; e < BENCH_ENGINE_COUNT; e++) {
+      if (selected[e] && bench_engine(&bench_engines[e], &trace, datasets[d],
+                                      warmup, reps, results) != 0) {
+        status = 1;
+      }
+    }
+    printf("\n");
+    trace_free(&trace);
+  }
+
+  fclose(results);
+  printf("Results written to %s\n", output_file);
+  slow_path_free(&g_workload);
+  free(datasets);
+  return status;
+}
@@ -0,0 +1,482 @@
+#ifndef DYNAFLOW_FLOW_LOOKUP_H
+#define DYNAFLOW_FLOW_LOOKUP_H
+
+// Known-flow membership backends shared by the baseline engines
+// (traditional, hybrid_immediate, hybrid_feedback).
+//
+// Every backend answers "is this IP a known flow?" and supports inserting
+// new flows, so the baselines can be compared against hybrid_accelerated
+// with a competent lookup instead of only the original linear scan.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+typedef enum {
+  LOOKUP_LINEAR = 0, // Original scalar linear scan
+  LOOKUP_AVX2 = 1,   // Linear scan, 8 keys per compare
+  LOOKUP_SORTED = 2, // Sorted array + branchless binary search
+  LOOKUP_BITMAP = 3, // One bit per IP in [0, IP_RANGE)
+  LOOKUP_HASH = 4,   // Open-addressing hash set (linear probing)
+  LOOKUP_CUCKOO = 5  // Cuckoo filter (approximate, tiny false-positive rate)
+} LookupBackend;
+
+#define LOOKUP_BACKEND_COUNT 6
+
+#define SORTED_PENDING_SIZE 64   // Unsorted insert buffer before a merge
+#define HASH_EMPTY_KEY UINT32_MAX // IPs are non-negative ints
+#define CUCKOO_SLOTS 4           // Fingerprints per bucket
+#define CUCKOO_MAX_KICKS 500
+#define CUCKOO_STASH_SIZE 64
+
+// Fingerprint that found no bucket slot, with one of its two buckets
+typedef struct {
+  uint16_t fp;
+  uint32_t index;
+} CuckooStashEntry;
+
+typedef struct {
+  LookupBackend backend;
+  int count;          // Distinct flows inserted
+  int failed_inserts; // Flows a full backend could not store
+
+  // LINEAR / AVX2 / SORTED
+  uint32_t *keys;
+  int key_count;
+  int key_capacity;
+  uint32_t pending[SORTED_PENDING_SIZE];
+  int pending_count;
+
+  // BITMAP
+  uint64_t *bits;
+  uint32_t bit_range;
+
+  // HASH
+  uint32_t *slots;
+  uint32_t slot_mask;
+
+  // CUCKOO
+  uint16_t (*buckets)[CUCKOO_SLOTS];
+  uint32_t bucket_mask;
+  CuckooStashEntry stash[CUCKOO_STASH_SIZE];
+  int stash_count;
+  uint32_t kick_state;
+} FlowSet;
+
+static const char *lookup_backend_names[LOOKUP_BACKEND_COUNT] = {
+    "linear", "avx2", "sorted", "bitmap", "hash", "cuckoo"};
+
+static inline const char *lookup_backend_name(LookupBackend backend) {
+  return lookup_backend_names[backend];
+}
+
+// Returns 0 on success, -1 if the name is unknown
+static inline int parse_lookup_backend(const char *name,
+                                       LookupBackend *backend) {
+  for (int i = 0; i < LOOKUP_BACKEND_COUNT; i++) {
+    if (strcmp(name, lookup_backend_names[i]) == 0) {
+      *backend = (LookupBackend)i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static inline void print_lookup_backends(FILE *out) {
+  fprintf(out, "Lookup backends:\n");
+  fprintf(out, "  linear  - scalar linear scan (original behaviour)\n");
+  fprintf(out, "  avx2    - vectorised linear scan\n");
+  fprintf(out, "  sorted  - sorted array, branchless binary search\n");
+  fprintf(out, "  bitmap  - 1 bit per IP over the dataset IP range\n");
+  fprintf(out, "  hash    - open-addressing hash set\n");
+  fprintf(out, "  cuckoo  - cuckoo filter (approximate membership)\n");
+}
+
+static inline uint32_t flowset_hash(uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x85ebca6b;
+  key ^= key >> 13;
+  key *= 0xc2b2ae35;
+  key ^= key >> 16;
+  return key;
+}
+
+static inline uint32_t next_pow2(uint32_t v) {
+  uint32_t p = 1;
+  while (p < v)
+    p <<= 1;
+  return p;
+}
+
+// ---------------------------------------------------------------------------
+// Linear scans
+
+static inline int linear_contains(const uint32_t *keys, int n, uint32_t ip) {
+  for (int i = 0; i < n; i++) {
+    if (keys[i] == ip)
+      return 1;
+  }
+  return 0;
+}
+
+static inline int avx2_contains(const uint32_t *keys, int n, uint32_t ip) {
+  int i = 0;
+#ifdef __AVX2__
+  __m256i needle = _mm256_set1_epi32((int)ip);
+  for (; i + 32 <= n; i += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(keys + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(keys + i + 8));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(keys + i + 16));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(keys + i + 24));
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, needle),
+                        _mm256_cmpeq_epi32(b, needle)),
+        _mm256_or_si256(_mm256_cmpeq_epi32(c, needle),
+                        _mm256_cmpeq_epi32(d, needle)));
+    if (!_mm256_testz_si256(m, m))
+      return 1;
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(keys + i));
+    __m256i m = _mm256_cmpeq_epi32(a, needle);
+    if (!_mm256_testz_si256(m, m))
+      return 1;
+  }
+#endif
+  return linear_contains(keys + i, n - i, ip);
+}
+
+static inline void keys_append(FlowSet *set, uint32_t ip) {
+  if (set->key_count >= set->key_capacity) {
+    set->key_capacity = set->key_capacity ? set->key_capacity * 2 : 1024;
+    set->keys =
+        (uint32_t *)realloc(set->keys, set->key_capacity * sizeof(uint32_t));
+  }
+  set->keys[set->key_count++] = ip;
+}
+
+// ---------------------------------------------------------------------------
+// Sorted array: binary search over a sorted run plus a small unsorted pending
+// buffer, merged in when full so inserts stay amortised O(n / 64)
+
+static inline int sorted_search(const uint32_t *keys, int n, uint32_t ip) {
+  if (n == 0)
+    return 0;
+  const uint32_t *base = keys;
+  int len = n;
+  while (len > 1) {
+    int half = len / 2;
+    base = (base[half] <= ip) ? base + half : base; // Compiles to cmov
+    len -= half;
+  }
+  return *base == ip;
+}
+
+static inline int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static inline void sorted_merge_pending(FlowSet *set) {
+  if (set->pending_count == 0)
+    return;
+
+  qsort(set->pending, set->pending_count, sizeof(uint32_t), compare_u32);
+
+  int total = set->key_count + set->pending_count;
+  if (total > set->key_capacity) {
+    while (set->key_capacity < total)
+      set->key_capacity = set->key_capacity ? set->key_capacity * 2 : 1024;
+    set->keys =
+        (uint32_t *)realloc(set->keys, set->key_capacity * sizeof(uint32_t));
+  }
+
+  // Merge from the back so the existing run can be extended in place
+  int i = set->key_count - 1;
+  int j = set->pending_count - 1;
+  int k = total - 1;
+  while (j >= 0) {
+    if (i >= 0 && set->keys[i] > set->pending[j]) {
+      set->keys[k--] = set->keys[i--];
+    } else {
+      set->keys[k--] = set->pending[j--];
+    }
+  }
+
+  set->key_count = total;
+  set->pending_count = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Bitmap over [0, bit_range), grown on demand for out-of-range inserts
+
+static inline void bitmap_grow(FlowSet *set, uint32_t ip) {
+  uint32_t old_words = (set->bit_range + 63) / 64;
+  uint32_t new_range = next_pow2(ip + 1);
+  uint32_t new_words = (new_range + 63) / 64;
+  set->bits = (uint64_t *)realloc(set->bits, new_words * sizeof(uint64_t));
+  memset(set->bits + old_words, 0, (new_words - old_words) * sizeof(uint64_t));
+  set->bit_range = new_words * 64;
+}
+
+// ---------------------------------------------------------------------------
+// Open-addressing hash set, linear probing, load factor <= 0.5
+
+static inline int hash_contains(const FlowSet *set, uint32_t ip) {
+  uint32_t pos = flowset_hash(ip) & set->slot_mask;
+  for (;;) {
+    uint32_t k = set->slots[pos];
+    if (k == ip)
+      return 1;
+    if (k == HASH_EMPTY_KEY)
+      return 0;
+    pos = (pos + 1) & set->slot_mask;
+  }
+}
+
+static inline int hash_insert_slot(uint32_t *slots, uint32_t mask,
+                                   uint32_t ip) {
+  uint32_t pos = flowset_hash(ip) & mask;
+  while (slots[pos] != HASH_EMPTY_KEY) {
+    if (slots[pos] == ip)
+      return 0;
+    pos = (pos + 1) & mask;
+  }
+  slots[pos] = ip;
+  return 1;
+}
+
+static inline void hash_alloc(FlowSet *set, uint32_t capacity) {
+  set->slots = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+  memset(set->slots, 0xff, capacity * sizeof(uint32_t)); // HASH_EMPTY_KEY
+  set->slot_mask = capacity - 1;
+}
+
+static inline void hash_grow(FlowSet *set) {
+  uint32_t *old = set->slots;
+  uint32_t old_capacity = set->slot_mask + 1;
+  hash_alloc(set, old_capacity * 2);
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old[i] != HASH_EMPTY_KEY)
+      hash_insert_slot(set->slots, set->slot_mask, old[i]);
+  }
+  free(old);
+}
+
+// ---------------------------------------------------------------------------
+// Cuckoo filter: 16-bit fingerprints, 4-way buckets, partial-key cuckoo
+// hashing. Sized from the IP range so evictions rarely fail; a fingerprint
+// left over when the kicks run out goes to a small stash with its bucket.
+// Once the stash is full, inserts that would need it fail, so a stored
+// flow is never lost: lookups have false positives but no false negatives.
+
+static inline uint16_t cuckoo_fingerprint(uint32_t ip) {
+  uint16_t fp = (uint16_t)(flowset_hash(ip ^ 0x9e3779b9) >> 16);
+  return fp ? fp : 1; // 0 marks an empty slot
+}
+
+static inline uint32_t cuckoo_alt_index(const FlowSet *set, uint32_t index,
+                                        uint16_t fp) {
+  return (index ^ flowset_hash(fp)) & set->bucket_mask;
+}
+
+static inline int cuckoo_bucket_has(const uint16_t *bucket, uint16_t fp) {
+  return (bucket[0] == fp) | (bucket[1] == fp) | (bucket[2] == fp) |
+         (bucket[3] == fp);
+}
+
+static inline int cuckoo_contains(const FlowSet *set, uint32_t ip) {
+  uint16_t fp = cuckoo_fingerprint(ip);
+  uint32_t i1 = flowset_hash(ip) & set->bucket_mask;
+  uint32_t i2 = cuckoo_alt_index(set, i1, fp);
+  if (cuckoo_bucket_has(set->buckets[i1], fp) |
+      cuckoo_bucket_has(set->buckets[i2], fp))
+    return 1;
+  // A stash entry's bucket is one of the pair {i1, i2} its fingerprint maps to
+  for (int s = 0; s < set->stash_count; s++) {
+    if (set->stash[s].fp == fp &&
+        (set->stash[s].index == i1 || set->stash[s].index == i2))
+      return 1;
+  }
+  return 0;
+}
+
+static inline int cuckoo_bucket_put(uint16_t *bucket, uint16_t fp) {
+  for (int s = 0; s < CUCKOO_SLOTS; s++) {
+    if (bucket[s] == 0) {
+      bucket[s] = fp;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Returns 1, or 0 if the table and stash are too full to take the flow
+static inline int cuckoo_insert(FlowSet *set, uint32_t ip) {
+  uint16_t fp = cuckoo_fingerprint(ip);
+  uint32_t i1 = flowset_hash(ip) & set->bucket_mask;
+  uint32_t i2 = cuckoo_alt_index(set, i1, fp);
+  if (cuckoo_bucket_put(set->buckets[i1], fp) ||
+      cuckoo_bucket_put(set->buckets[i2], fp))
+    return 1;
+  // Kicking only starts when the stash can take whatever is left over
+  if (set->stash_count == CUCKOO_STASH_SIZE)
+    return 0;
+
+  uint32_t index = (set->kick_state & 1) ? i1 : i2;
+  for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+    set->kick_state = set->kick_state * 1103515245u + 12345u;
+    int victim = (set->kick_state >> 16) & (CUCKOO_SLOTS - 1);
+    uint16_t evicted = set->buckets[index][victim];
+    set->buckets[index][victim] = fp;
+    fp = evicted;
+    index = cuckoo_alt_index(set, index, fp);
+    if (cuckoo_bucket_put(set->buckets[index], fp))
+      return 1;
+  }
+
+  // Table too full: the fingerprint still in flight may belong to any
+  // earlier flow, so it is the one stashed
+  set->stash[set->stash_count++] = (CuckooStashEntry){fp, index};
+  return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Public interface
+
+// capacity_hint: expected number of distinct flows
+// ip_range:      dataset IP range (bitmap size, cuckoo sizing)
+static inline void flowset_init(FlowSet *set, LookupBackend backend,
+                                int capacity_hint, int ip_range) {
+  memset(set, 0, sizeof(FlowSet));
+  set->backend = backend;
+  uint32_t expected =
+      (uint32_t)(capacity_hint > ip_range ? capacity_hint : ip_range);
+  if (expected < 1024)
+    expected = 1024;
+
+  switch (backend) {
+  case LOOKUP_LINEAR:
+  case LOOKUP_AVX2:
+  case LOOKUP_SORTED:
+    set->key_capacity = capacity_hint > 0 ? capacity_hint : 1024;
+    set->keys = (uint32_t *)malloc(set->key_capacity * sizeof(uint32_t));
+    break;
+  case LOOKUP_BITMAP:
+    set->bit_range = ((uint32_t)(ip_range > 0 ? ip_range : 1) + 63) / 64 * 64;
+    set->bits = (uint64_t *)calloc(set->bit_range / 64, sizeof(uint64_t));
+    break;
+  case LOOKUP_HASH:
+    hash_alloc(set, next_pow2((uint32_t)capacity_hint * 2 + 16));
+    break;
+  case LOOKUP_CUCKOO: {
+    // Aim for <= ~80% occupancy even if every IP in the range shows up
+    uint32_t buckets = next_pow2(expected / CUCKOO_SLOTS * 5 / 4 + 1);
+    set->buckets = calloc(buckets, sizeof(*set->buckets));
+    set->bucket_mask = buckets - 1;
+    set->kick_state = 0x2545f491;
+  } break;
+  }
+}
+
+static inline int flowset_contains(const FlowSet *set, int ip_value) {
+  uint32_t ip = (uint32_t)ip_value;
+  switch (set->backend) {
+  case LOOKUP_LINEAR:
+    return linear_contains(set->keys, set->key_count, ip);
+  case LOOKUP_AVX2:
+    return avx2_contains(set->keys, set->key_count, ip);
+  case LOOKUP_SORTED:
+    return sorted_search(set->keys, set->key_count, ip) ||
+           (set->pending_count > 0 &&
+            avx2_contains(set->pending, set->pending_count, ip));
+  case LOOKUP_BITMAP:
+    return ip < set->bit_range && ((set->bits[ip >> 6] >> (ip & 63)) & 1);
+  case LOOKUP_HASH:
+    return hash_contains(set, ip);
+  case LOOKUP_CUCKOO:
+    return cuckoo_contains(set, ip);
+  }
+  return 0;
+}
+
+// Returns 1 if the flow was new, 0 if it was already known or the backend
+// was too full to store it (counted in failed_inserts)
+static inline int flowset_insert(FlowSet *set, int ip_value) {
+  uint32_t ip = (uint32_t)ip_value;
+  if (flowset_contains(set, ip_value))
+    return 0;
+
+  switch (set->backend) {
+  case LOOKUP_LINEAR:
+  case LOOKUP_AVX2:
+    keys_append(set, ip);
+    break;
+  case LOOKUP_SORTED:
+    set->pending[set->pending_count++] = ip;
+    if (set->pending_count == SORTED_PENDING_SIZE)
+      sorted_merge_pending(set);
+    break;
+  case LOOKUP_BITMAP:
+    if (ip >= set->bit_range)
+      bitmap_grow(set, ip);
+    set->bits[ip >> 6] |= 1ULL << (ip & 63);
+    break;
+  case LOOKUP_HASH:
+    if ((uint32_t)(set->count + 1) * 2 > set->slot_mask + 1)
+      hash_grow(set);
+    hash_insert_slot(set->slots, set->slot_mask, ip);
+    break;
+  case LOOKUP_CUCKOO:
+    if (!cuckoo_insert(set, ip)) {
+      set->failed_inserts++;
+      return 0;
+    }
+    break;
+  }
+
+  set->count++;
+  return 1;
+}
+
+// Approximate resident size of the backend, for reporting
+static inline size_t flowset_memory_bytes(const FlowSet *set) {
+  switch (set->backend) {
+  case LOOKUP_LINEAR:
+  case LOOKUP_AVX2:
+  case LOOKUP_SORTED:
+    return (size_t)set->key_capacity * sizeof(uint32_t);
+  case LOOKUP_BITMAP:
+    return set->bit_range / 8;
+  case LOOKUP_HASH:
+    return ((size_t)set->slot_mask + 1) * sizeof(uint32_t);
+  case LOOKUP_CUCKOO:
+    return ((size_t)set->bucket_mask + 1) * sizeof(*set->buckets);
+  }
+  return 0;
+}
+
+// Report line for the engines: backend, size and any inserts it dropped
+static inline void print_flowset(FILE *out, const FlowSet *set) {
+  fprintf(out, "Lookup backend: %s (%zu bytes)\n",
+          lookup_backend_name(set->backend), flowset_memory_bytes(set));
+  if (set->failed_inserts > 0)
+    fprintf(out, "Lookup backend full: %d flows could not be stored\n",
+            set->failed_inserts);
+}
+
+static inline void flowset_free(FlowSet *set) {
+  free(set->keys);
+  free(set->bits);
+  free(set->slots);
+  free(set->buckets);
+  memset(set, 0, sizeof(FlowSet));
+}
+
+#endif // DYNAFLOW_FLOW_LOOKUP_H
@@ -1,11 +1,29 @@
+#define _GNU_SOURCE // MAP_HUGETLB, madvise, perf_event_open, pthreads
+
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "accelerated_engine.h"
+#include "arena.h"
+#include "bulk_score.h"
+#include "latency_histogram.h"
+#include "model_file.h"
+#include "perf_counters.h"
+#include "s3fifo.h"
+#include "slow_path.h"
+#include "spsc_queue.h"
+#include "timing_wheel.h"
+#include "trace.h"
+
 // Optimized Configuration
 static int INITIAL_KNOWN_SIZE;
 static int NUM_PACKETS;
@@ -15,21 +33,105 @@ static int IP_RANGE;
 #define BURSTY_FLOW_AREA_SIZE 500
 #define MICRO_FLOW_AREA_SIZE 1000
 #define HASH_TABLE_SIZE 65536 // Power of 2 for fast modulo
+
+// Defaults for the tunable parameters (see EngineParams, --param)
 #define CACHE_SIZE 8192       // Larger, power of 2 cache
-#define BURST_THRESHOLD 100   // More reasonable burst threshold
+#define BURST_THRESHOLD 100   // Hits per second a bursting flow exceeds
 #define CONFIDENCE_FAST_TRACK 60
 #define CONFIDENCE_ULTRA_FAST 85
 #define AGING_INTERVAL 25000 // More frequent aging for ML
 #define SKETCH_WIDTH 4096    // Optimized sketch size
 #define SKETCH_DEPTH 3       // Reduced depth for speed
+#define SKETCH_MAX_DEPTH 8
+#define IDLE_TIMEOUT 262144 // Microseconds without a hit before a flow ages
+#define MAINT_INTERVAL 64   // Packets between maintenance slices
+#define MAINT_BUDGET 64     // Maintenance entries per slice
+#define EVICT_TARGET 0.90   // Pool utilization eviction holds
+#define DIRECT_INDEX_MAX_RANGE (1 << 20) // 4 MB index, 128 KB bitmap at most
+
+// Statistics instrumentation level, fixed at build time:
+//   STATS_OFF   - no counters at all (production)
+//   STATS_BASIC - path mix and lookup hit/miss
+//   STATS_FULL  - plus hash, ML and pattern diagnostics
+#define STATS_OFF 0
+#define STATS_BASIC 1
+#define STATS_FULL 2
+#ifndef STATS_LEVEL
+#define STATS_LEVEL STATS_FULL
+#endif
+
+// Packet pipeline stages. Each pipeline variant is compiled with a constant
+// feature set, so disabled stages fold away instead of being tested per
+// packet. The variant itself is picked once at startup (--pipeline).
+#define PIPE_SKETCH (1u << 0)   // Count-min sketch update / new-flow routing
+#define PIPE_BURST (1u << 1)    // Burst detection and promotion
+#define PIPE_ML (1u << 2)       // ML scoring (otherwise promotion-score proxy)
+#define PIPE_PATTERN (1u << 3)  // Path history / consistency tracking
+#define PIPE_VALIDATE (1u << 4) // Delayed-label sampling (needs PIPE_ML)
+#define PIPE_CLASSIFY (1u << 5) // Flow type classification, anomaly flags
+#define PIPE_MAINT (1u << 6)    // Periodic aging and model adaptation
+#define PIPE_STATS (1u << 7)    // Per-packet counters (capped by STATS_LEVEL)
+#define PIPELINE_FULL 0xffu
+#define PIPELINE_INLINE static inline __attribute__((always_inline))
 
 // Enhanced ML Configuration
-#define ML_FEATURE_COUNT 8
+#define ML_FEATURE_COUNT 8 // == MODEL_FILE_FEATURES
 #define ML_HISTORY_SIZE 8            // Reduced for better performance
 #define ML_ADAPTATION_INTERVAL 50000 // Less frequent adaptation
 #define AGING_BUCKETS 4
 #define PREDICTION_CACHE_SIZE 1024 // Larger prediction cache
-#define BURST_WINDOW_SIZE 100      // More reasonable window
+#define PREDICTION_CACHE_TTL 30000000 // Microseconds of packet time
+
+// Every time-based decision (recency, idle aging, burst detection, the
+// prediction cache's TTL) reads packet time: microseconds since the trace's
+// first packet, from its timestamp column (trace.h). Traces without one
+// replay at a nominal one packet per microsecond, so packet time is the
+// packet index. Either way replays are deterministic, whatever the speed of
+// the machine.
+
+// Burst detection runs on packet time, so it behaves the same at any
+// throughput. Rates are compared at two timescales (EWMAs): a burst is a
+// short-term rate at least 2^BURST_RATE_RATIO_LOG2 times the long-term one and
+// above burst_threshold. Per flow the estimators track log2 of the gap between
+// hits; globally they track new-flow arrivals per tick.
+#define BURST_RATE_WINDOW (1 << 20) // Microseconds burst_threshold counts over
+#define BURST_RATE_RATIO_LOG2 1     // Short-term rate at least 2x long-term
+#define BURST_TICK_US 1024          // Arrival-rate sample period
+#define BURST_IDLE_TICKS 256 // Empty ticks folded in after a silence, at most
+#define BURST_ARRIVAL_FAST 4        // EWMA spans in ticks (1/alpha)
+#define BURST_ARRIVAL_SLOW 64
+#define BURST_GAP_FAST_SHIFT 2 // Per-flow EWMA alphas 1/4 and 1/32
+#define BURST_GAP_SLOW_SHIFT 5
+#define BURST_LOG2_FRAC_BITS 8 // Gap EWMAs are log2(us) in 8.8 fixed point
+#define BURST_GAP_UNSET 0xffff // No gap seen yet
+
+// Idle aging runs off a timing wheel on packet time: one tick per
+// IDLE_TICK_US microseconds. A dying flow idle for DYING_EXPIRY_PERIODS idle
+// timeouts expires.
+#define IDLE_TICK_SHIFT 10
+#define IDLE_TICK_US (1u << IDLE_TICK_SHIFT)
+#define DYING_EXPIRY_PERIODS 15
+#define IDLE_EXPIRY_BATCH 32 // Expired timers prefetched together
+
+// Online training: every ONLINE_SAMPLE_INTERVAL-th packet is recorded with
+// its features; its label ("did the flow recur within ONLINE_LABEL_HORIZON
+// packets?") is taken exactly at the horizon and trained in batches from
+// maintenance.
+#define ONLINE_SAMPLE_INTERVAL 16   // Power of 2
+#define ONLINE_LABEL_HORIZON 65536  // Packets, multiple of the interval
+#define ONLINE_TRAIN_INTERVAL 4096  // Packets between training batches
+#define ONLINE_RING_SIZE 8192       // Power of 2, > horizon / sample interval
+#define ONLINE_L2 0.0001            // Weight decay per update
+#define SHADOW_DEFAULT_INTERVAL 64  // Shadow-scored packets: 1 in N
+#define LIFECYCLE_INTERVAL 100000  // Packets between lifecycle passes
+#define PROGRESS_INTERVAL 200000   // Packets between progress lines
+
+// Slow-path offload to inspection threads (--offload)
+#define OFFLOAD_MAX_WORKERS 16
+#define OFFLOAD_QUEUE_SIZE 4096 // Messages per queue, power of 2
+#define OFFLOAD_POLL_MASK 15    // Completions are applied every 16 packets
+#define OFFLOAD_IDLE_SPINS 64   // Empty polls before a worker yields the CPU
+#define FAST_LATENCY_SAMPLE 64  // Fast-path latency: 1 in N fast packets
 
 // Processing paths
 typedef enum {
@@ -60,6 +162,13 @@ typedef enum {
   AGING_AGGRESSIVE = 3
 } AgingStrategy;
 
+// Model family behind ml_predict_raw and bulk scoring, chosen at startup
+typedef enum {
+  CLASSIFIER_LINEAR = 0, // Logistic regression on normalized features
+  CLASSIFIER_STUMPS = 1, // Boosted stumps on raw features, from a model file
+  CLASSIFIER_QUANTIZED = 2 // Linear model in int8 fixed point (shadow only)
+} ClassifierKind;
+
 // Enhanced ML model with better accuracy tracking
 typedef struct {
   double weights[ML_FEATURE_COUNT];
@@ -80,25 +189,154 @@ typedef struct {
   // Performance validation
   uint32_t validation_samples;
   uint32_t validation_correct;
+
+  // Boosted stumps, structure-of-arrays for a branchless walk
+  ClassifierKind classifier;
+  int stump_count;
+  double stump_base;
+  int stump_feature[MODEL_FILE_MAX_STUMPS];
+  double stump_threshold[MODEL_FILE_MAX_STUMPS];
+  double stump_value[MODEL_FILE_MAX_STUMPS][2];
+
+  // Quantized linear model: z = qscale / 255 * (qbias + sum qweights * x8),
+  // with features quantized to x8 = 0..255
+  int8_t qweights[ML_FEATURE_COUNT];
+  int32_t qbias;
+  double qscale;
 } MLModel;
 
-// Simplified flow pattern tracking
+// Delayed-label sample: normalised features and the prediction at packet t;
+// the label is resolved once the horizon has passed
+typedef struct {
+  float x[ML_FEATURE_COUNT];
+  float prediction;
+  uint32_t packet_index;
+  uint32_t ip;
+  int32_t flow_index;
+  uint8_t label; // Set once the horizon has passed
+} TrainingSample;
+
+typedef struct {
+  TrainingSample ring[ONLINE_RING_SIZE];
+  uint32_t head;     // Next slot to write
+  uint32_t labelled; // Oldest sample still waiting for its label
+  uint32_t tail;     // Oldest labelled sample not yet trained
+
+  uint64_t samples_recorded;
+  uint64_t samples_dropped; // Ring full when sampling
+  uint64_t samples_trained;
+  uint64_t positive_labels;
+  uint64_t labelled_correct; // Prequential: prediction made before training
+  uint64_t training_batches;
+} OnlineTrainer;
+
+// Shadow evaluation: a candidate model scores a sample of packets next to
+// the live one. Its decisions are only counted, never routed.
 typedef struct {
-  uint8_t path_history[ML_HISTORY_SIZE];
-  uint8_t history_index;
-  uint8_t history_filled;
-
-  // Derived patterns
-  double path_consistency;
-  double burst_score;
-  uint32_t consecutive_fast_paths;
-  uint32_t recent_promotions;
+  MLModel model;
+  const char *description;
+  uint32_t sample_interval; // Shadow-score 1 in N eligible packets
+  uint32_t countdown;
+  int tracks_live; // Quantized copy of the live model, refreshed on training
+
+  uint64_t samples;
+  uint64_t path_agreements;
+  double score_diff_sum; // Sum of |live - shadow|
+  uint64_t live_paths[6];
+  uint64_t shadow_paths[6];
+} ShadowEval;
+
+// Flow pattern tracking, packed into two words and updated in O(1).
+//
+// history: the last ML_HISTORY_SIZE path codes, 3 bits per slot in ring
+//          order (slot i at bit 3i), then the ring index, a filled flag and
+//          a seeded flag (known flow, see pattern_seed_known)
+// counts:  occupancy of each path in the window (4 bits per path), the
+//          number of adjacent-slot transitions, and the fast-path streak,
+//          saturated at PATTERN_STREAK_MAX
+typedef struct {
+  uint32_t history;
+  uint32_t counts;
 } FlowPattern;
 
+#define PATTERN_SLOT_BITS 3
+#define PATTERN_SLOT_MASK 0x7u
+#define PATTERN_INDEX_SHIFT 24
+#define PATTERN_FILLED_BIT (1u << 27)
+#define PATTERN_SEEDED_BIT (1u << 28)
+#define PATTERN_OCCUPANCY_BITS 4
+#define PATTERN_TRANSITIONS_SHIFT 24
+#define PATTERN_STREAK_SHIFT 27
+#define PATTERN_STREAK_MAX 3 // Only ever compared against 2 and 3
+#define PATTERN_MIN_LENGTH 4 // Consistency is tracked from 4 paths on
+
+// Derived values before enough history exists, for new and known flows
+#define PATTERN_NEW_CONSISTENCY 1.0
+#define PATTERN_NEW_BURST 0.0
+#define PATTERN_SEEDED_CONSISTENCY 0.85
+#define PATTERN_SEEDED_BURST 0.15
+
+typedef char pattern_history_fits_24_bits
+    [ML_HISTORY_SIZE * PATTERN_SLOT_BITS <= PATTERN_INDEX_SHIFT ? 1 : -1];
+
+// Pattern accessors
+static inline int pattern_filled(const FlowPattern *pattern) {
+  return (pattern->history & PATTERN_FILLED_BIT) != 0;
+}
+
+// Paths in the window
+static inline int pattern_length(const FlowPattern *pattern) {
+  return pattern_filled(pattern)
+             ? ML_HISTORY_SIZE
+             : (int)(pattern->history >> PATTERN_INDEX_SHIFT) &
+                   (ML_HISTORY_SIZE - 1);
+}
+
+static inline int pattern_has_consistency(const FlowPattern *pattern) {
+  return pattern_length(pattern) >= PATTERN_MIN_LENGTH;
+}
+
+// Share of the window taken by its most common path
+static inline double pattern_consistency(const FlowPattern *pattern) {
+  if (!pattern_has_consistency(pattern)) {
+    return (pattern->history & PATTERN_SEEDED_BIT)
+               ? PATTERN_SEEDED_CONSISTENCY
+               : PATTERN_NEW_CONSISTENCY;
+  }
+  uint32_t max_count = 0;
+  for (int p = 0; p <= DEEP_ANALYSIS_PATH; p++) {
+    uint32_t count = (pattern->counts >> (PATTERN_OCCUPANCY_BITS * p)) & 0xf;
+    max_count = count > max_count ? count : max_count;
+  }
+  return (double)max_count / pattern_length(pattern);
+}
+
+// Share of adjacent history slots holding different paths
+static inline double pattern_burst_score(const FlowPattern *pattern) {
+  if (!pattern_filled(pattern)) {
+    return (pattern->history & PATTERN_SEEDED_BIT) ? PATTERN_SEEDED_BURST
+                                                   : PATTERN_NEW_BURST;
+  }
+  uint32_t transitions =
+      (pattern->counts >> PATTERN_TRANSITIONS_SHIFT) & PATTERN_SLOT_MASK;
+  return (double)transitions / (ML_HISTORY_SIZE - 1);
+}
+
+static inline uint32_t pattern_fast_streak(const FlowPattern *pattern) {
+  return pattern->counts >> PATTERN_STREAK_SHIFT;
+}
+
+// Known flows start with a good pattern until their own history takes over
+static inline void pattern_seed_known(FlowPattern *pattern) {
+  pattern->history |= PATTERN_SEEDED_BIT;
+  pattern->counts = (pattern->counts & ~(0x3u << PATTERN_STREAK_SHIFT)) |
+                    (uint32_t)PATTERN_STREAK_MAX << PATTERN_STREAK_SHIFT;
+}
+
 // Enhanced aging metadata
 typedef struct {
-  time_t creation_time;
-  time_t last_access_time;
+  uint64_t creation_time; // Packet time
+  uint64_t last_access_time;
   uint32_t idle_periods;
   uint32_t total_accesses;
   AgingStrategy aging_strategy;
@@ -111,7 +349,9 @@ typedef struct FlowEntry {
   uint16_t confidence;
   uint16_t hits;
   uint32_t packet_count;
-  time_t last_seen;
+  uint16_t burst_gap_fast; // log2 hit-gap EWMAs (see flow_burst_update)
+  uint16_t burst_gap_slow;
+  uint64_t last_seen; // Packet time of the last hit
   FlowType flow_type;
   FlowType previous_type;
 
@@ -121,6 +361,11 @@ typedef struct FlowEntry {
   // Performance tracking
   uint32_t cache_hits;
   uint16_t promotion_score; // 0-1000 scale
+  uint8_t evict_freq;       // Hits since the eviction policy last looked
+  uint8_t evict_grace;      // Idle eviction round already forgiven
+  uint32_t last_packet;     // Packet index of the last hit (wraps)
+  uint16_t inspect_held;    // Packets held for an offloaded inspection
+  uint8_t inspect_pending;  // Inspection queued to a worker (--offload)
 
   struct FlowEntry *next;
 } FlowEntry;
@@ -128,13 +373,13 @@ typedef struct FlowEntry {
 typedef struct {
   FlowEntry *buckets[HASH_TABLE_SIZE];
   int total_entries;
-  uint64_t total_lookups;
-  uint64_t collision_count;
 } HashTable;
 
 typedef struct {
-  uint32_t counters[SKETCH_DEPTH][SKETCH_WIDTH];
-  uint32_t seeds[SKETCH_DEPTH];
+  uint32_t *counters; // depth rows of width counters
+  uint32_t width_mask;
+  int depth;
+  uint32_t seeds[SKETCH_MAX_DEPTH];
 } FastSketch;
 
 // Improved prediction cache
@@ -142,57 +387,237 @@ typedef struct {
   uint32_t ip;
   double prediction;
   ProcessingPath suggested_path;
-  time_t timestamp;
+  uint64_t expires; // Packet time; 0 for a never-written entry
   uint8_t confidence_level; // 0-255
 } PredictionCache;
 
 // Simplified aging manager
 typedef struct {
-  time_t last_aging_cycle;
-  uint64_t flows_aged_out;
+  uint64_t flows_aged;     // Idle timer expiries that applied aging
+  uint64_t idle_rearms;    // Timers that found the flow active again
+  uint64_t flows_aged_out; // Dying flows past the expiry period
+  uint64_t flows_evicted;
+  uint64_t admissions_deferred; // New keys turned away above the target
+  uint64_t evicted_by_type[7];
   uint64_t flows_demoted;
   uint64_t flows_promoted;
   double aging_pressure;
   double memory_utilization;
 
-  // Burst tracking - fixed
-  uint32_t burst_history[BURST_WINDOW_SIZE];
-  int burst_index;
-  uint32_t total_bursts;
-  double current_burst_rate;
+  // Burst detection: new-flow arrival rate EWMAs, per tick
+  uint64_t burst_tick_end;  // Packet time the current tick closes at
+  uint32_t tick_arrivals;   // New flows so far this tick
+  double arrival_rate_fast; // New flows per tick
+  double arrival_rate_slow;
+  int arrival_surge;        // Short-term arrival rate is bursting
+  uint64_t arrival_ticks;
+  uint64_t surge_ticks;
+  uint64_t surges;          // Surges started
+  uint64_t flow_burst_hits; // Hits on a flow whose own rate is bursting
+  uint64_t burst_promotions;
 } AgingManager;
 
+// Incremental maintenance. Every maint_interval packets one slice runs at
+// most maint_budget entries of lifecycle, training and idle-expiry work, so
+// no single packet pays for a whole pass.
+typedef struct {
+  // Lifecycle pass over flow_pool[0, lifecycle_end), resumed each slice
+  int lifecycle_cursor;
+  int lifecycle_end;              // 0 while no pass is running
+  uint64_t lifecycle_started;     // Packet the latest pass started at
+  BulkScoreModel lifecycle_model; // Model snapshot scoring the pass
+  uint64_t lifecycle_passes;
+  uint64_t lifecycle_pass_packets; // Packets spanned by completed passes
+
+  // Entries processed per task
+  uint64_t lifecycle_entries;
+  uint64_t training_entries;
+  uint64_t expiry_entries;
+  uint64_t cascade_entries;
+  uint64_t evict_entries;
+
+  uint64_t slices;
+  uint64_t saturated_slices;  // Slices that used their whole budget
+  LatencyHistogram latency;   // Slice duration in ns
+} MaintenanceScheduler;
+
 // Main table structure
 typedef struct {
   HashTable *hash_table;
   FlowEntry *flow_pool;
-  int pool_index;
+  int pool_index; // High-water mark; recycled slots come from free_slots
   int pool_size;
+  int live_flows;
+  uint64_t flows_created;
 
-  FlowEntry *fast_cache[CACHE_SIZE];
+  // Eviction: S3-FIFO queues over flow_pool slots, plus evicted slots ready
+  // for reuse
+  S3Fifo evictor;
+  int32_t *free_slots;
+  int free_count;
+
+  FlowEntry **fast_cache; // g_params.cache_size entries
   FastSketch *sketch;
 
+  // Direct-indexed lookup for bounded key spaces (0 = hashed path only)
+  uint32_t direct_range;
+  int32_t *direct_index;   // ip -> flow_pool index, valid when bit is set
+  uint64_t *direct_bitmap; // 1 bit per key: flow present
+
   MLModel *ml_model;
-  PredictionCache prediction_cache[PREDICTION_CACHE_SIZE];
+  PredictionCache *prediction_cache; // g_params.prediction_cache_size entries
   int prediction_cache_index;
 
   AgingManager *aging_manager;
+  TimingWheel idle_wheel; // One idle timer per flow_pool slot
+  OnlineTrainer *trainer; // NULL when online training is disabled
+  ShadowEval *shadow;     // NULL unless --shadow is given
+  MaintenanceScheduler *maint;
+
+  // Model scores parallel to flow_pool, refreshed by score_flow_pool()
+  float *flow_scores;
+  uint64_t bulk_score_passes;
+  uint64_t bulk_scored_flows;
+  double bulk_score_seconds;
+
+  uint64_t total_processed; // Drives maintenance, so never compiled out
+  uint64_t packet_time;     // Microseconds; see PREDICTION_CACHE_TTL
+  uint64_t next_aging_at;   // Runtime interval, so no per-packet division
+} OptimizedTable;
 
-  // Statistics
-  uint64_t total_processed;
+// Statistics block, owned by the packet thread (offload workers count
+// nothing here). It is cache-line aligned, so counters never share a line
+// with table pointers. Only the owner writes; readers take a relaxed
+// snapshot.
+typedef struct {
+  // Basic: exactly one cache line
+  uint64_t path_counts[6];
   uint64_t cache_hits;
   uint64_t cache_misses;
-  uint64_t path_counts[6];
-  uint64_t ml_predictions;
-  uint64_t ml_cache_hits;
 
-  // Performance counters
+  // Full: diagnostics
+  uint64_t total_lookups;
+  uint64_t collision_count;
+  uint64_t ml_predictions; // Model calls on the packet path
+  uint64_t ml_cache_lookups;
+  uint64_t ml_cache_hits;
   uint64_t ultra_fast_promotions;
   uint64_t confidence_updates;
   uint64_t pattern_updates;
-} OptimizedTable;
+} __attribute__((aligned(64))) EngineStats;
+
+EngineStats g_stats;
+
+// Owner-side increment: a plain add, but a single store readers can
+// observe without tearing
+static inline void stat_add(uint64_t *counter, uint64_t value) {
+  __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value,
+                   __ATOMIC_RELAXED);
+}
+
+#if STATS_LEVEL >= STATS_BASIC
+#define STAT_BASIC(field) stat_add(&g_stats.field, 1)
+#else
+#define STAT_BASIC(field) ((void)0)
+#endif
+
+#if STATS_LEVEL >= STATS_FULL
+#define STAT_FULL(field) stat_add(&g_stats.field, 1)
+#else
+#define STAT_FULL(field) ((void)0)
+#endif
+
+// Counters on the packet path, also dropped by variants without PIPE_STATS
+#define PSTAT_BASIC(features, field)                                           \
+  do {                                                                         \
+    if ((features) & PIPE_STATS)                                               \
+      STAT_BASIC(field);                                                       \
+  } while (0)
+#define PSTAT_FULL(features, field)                                            \
+  do {                                                                         \
+    if ((features) & PIPE_STATS)                                               \
+      STAT_FULL(field);                                                        \
+  } while (0)
+
+// Copy the block; safe to call while the packet thread is still counting
+void stats_snapshot(EngineStats *out) {
+  const uint64_t *src = (const uint64_t *)&g_stats;
+  uint64_t *dst = (uint64_t *)out;
+  for (size_t f = 0; f < sizeof(EngineStats) / sizeof(uint64_t); f++) {
+    dst[f] = __atomic_load_n(&src[f], __ATOMIC_RELAXED);
+  }
+}
+
+static const char *stats_level_name() {
+  return STATS_LEVEL >= STATS_FULL    ? "full"
+         : STATS_LEVEL >= STATS_BASIC ? "basic"
+                                      : "off";
+}
+
+// Tunable engine parameters, fixed before the tables are built. Defaults are
+// the values above; --param/--params override them and autotune.sh searches
+// over them.
+typedef struct {
+  int cache_size;            // Flow lookup cache entries (power of 2)
+  int prediction_cache_size; // Prediction cache entries (power of 2)
+  int sketch_width;          // Counters per sketch row (power of 2)
+  int sketch_depth;          // Sketch rows, 1 to SKETCH_MAX_DEPTH
+  int aging_interval;        // Packets between aging pressure updates
+  int idle_timeout;          // Microseconds without a hit before a flow ages
+  int maint_interval;        // Packets between maintenance slices (power of 2)
+  int maint_budget;          // Maintenance entries per slice, 0 = unbounded
+  double evict_target;       // Pool utilization eviction holds (1 = when full)
+  int confidence_fast_track;
+  int confidence_ultra_fast;
+  double cached_ultra_fast; // Cached-prediction path thresholds
+  double cached_fast;
+  double cached_accelerated;
+  int burst_threshold; // Hits per BURST_RATE_WINDOW a burst must exceed
+
+  // Derived by finalize_engine_params()
+  uint32_t cache_mask;
+  uint32_t prediction_cache_mask;
+  uint64_t maint_mask;
+  int32_t burst_gap_limit; // Gap EWMA below which a flow beats the threshold
+} EngineParams;
+
+EngineParams g_params = {CACHE_SIZE,
+                         PREDICTION_CACHE_SIZE,
+                         SKETCH_WIDTH,
+                         SKETCH_DEPTH,
+                         AGING_INTERVAL,
+                         IDLE_TIMEOUT,
+                         MAINT_INTERVAL,
+                         MAINT_BUDGET,
+                         EVICT_TARGET,
+                         CONFIDENCE_FAST_TRACK,
+                         CONFIDENCE_ULTRA_FAST,
+                         0.8,
+                         0.6,
+                         0.4,
+                         BURST_THRESHOLD,
+                         CACHE_SIZE - 1,
+                         PREDICTION_CACHE_SIZE - 1,
+                         MAINT_INTERVAL - 1,
+                         0};
 
 OptimizedTable *g_table;
+Arena g_arena; // Backing for all engine structures when enabled
+
+// Zeroed allocation from the arena when it has room, otherwise calloc. The
+// arena is sized by a counting pass over the same allocations, so running
+// out of room (g_arena.exhausted) is a sizing bug that accelerated_open
+// reports.
+static void *engine_alloc(size_t bytes) {
+  void *ptr = arena_alloc(&g_arena, bytes);
+  return ptr ? ptr : calloc(1, bytes);
+}
+
+static void engine_free(void *ptr) {
+  if (ptr && !arena_owns(&g_arena, ptr)) {
+    free(ptr);
+  }
+}
 
 // Fast hash function
 static inline uint32_t fast_hash(uint32_t key) {
@@ -206,7 +631,7 @@ static inline uint32_t fast_hash(uint32_t key) {
 
 // Initialize ML model with better defaults
 MLModel *init_ml_model() {
-  MLModel *model = (MLModel *)calloc(1, sizeof(MLModel));
+  MLModel *model = (MLModel *)engine_alloc(sizeof(MLModel));
 
   // Balanced weights for better performance
   model->weights[0] = 0.35; // confidence weight (increased)
@@ -235,65 +660,76 @@ MLModel *init_ml_model() {
 
 // Initialize aging manager
 AgingManager *init_aging_manager() {
-  AgingManager *manager = (AgingManager *)calloc(1, sizeof(AgingManager));
+  AgingManager *manager = (AgingManager *)engine_alloc(sizeof(AgingManager));
   manager->aging_pressure = 0.3;
   manager->memory_utilization = 0.0;
-  manager->last_aging_cycle = time(NULL);
-  manager->burst_index = 0;
+  manager->burst_tick_end = BURST_TICK_US;
   return manager;
 }
 
 // Initialize hash table
 HashTable *init_hash_table() {
-  HashTable *ht = (HashTable *)calloc(1, sizeof(HashTable));
+  HashTable *ht = (HashTable *)engine_alloc(sizeof(HashTable));
   return ht;
 }
 
 // Fast sketch operations
 FastSketch *init_fast_sketch() {
-  FastSketch *sketch = (FastSketch *)calloc(1, sizeof(FastSketch));
-  sketch->seeds[0] = 0x9e3779b9;
-  sketch->seeds[1] = 0x85ebca6b;
-  sketch->seeds[2] = 0xc2b2ae35;
+  static const uint32_t seeds[SKETCH_MAX_DEPTH] = {
+      0x9e3779b9, 0x85ebca6b, 0xc2b2ae35, 0x27d4eb2f,
+      0x165667b1, 0xd3a2646c, 0xfd7046c5, 0xb55a4f09};
+  FastSketch *sketch = (FastSketch *)engine_alloc(sizeof(FastSketch));
+  sketch->depth = g_params.sketch_depth;
+  sketch->width_mask = (uint32_t)g_params.sketch_width - 1;
+  sketch->counters = (uint32_t *)engine_alloc(
+      (size_t)g_params.sketch_depth * g_params.sketch_width * sizeof(uint32_t));
+  memcpy(sketch->seeds, seeds, sizeof(seeds));
   return sketch;
 }
 
 static inline void sketch_update_fast(FastSketch *sketch, uint32_t ip) {
-  for (int i = 0; i < SKETCH_DEPTH; i++) {
-    uint32_t pos = fast_hash(ip ^ sketch->seeds[i]) & (SKETCH_WIDTH - 1);
-    sketch->counters[i][pos]++;
+  uint32_t *row = sketch->counters;
+  for (int i = 0; i < sketch->depth; i++) {
+    row[fast_hash(ip ^ sketch->seeds[i]) & sketch->width_mask]++;
+    row += sketch->width_mask + 1;
   }
 }
 
 static inline uint32_t sketch_query_fast(FastSketch *sketch, uint32_t ip) {
   uint32_t min_count = UINT32_MAX;
-  for (int i = 0; i < SKETCH_DEPTH; i++) {
-    uint32_t pos = fast_hash(ip ^ sketch->seeds[i]) & (SKETCH_WIDTH - 1);
-    if (sketch->counters[i][pos] < min_count) {
-      min_count = sketch->counters[i][pos];
+  const uint32_t *row = sketch->counters;
+  for (int i = 0; i < sketch->depth; i++) {
+    uint32_t count = row[fast_hash(ip ^ sketch->seeds[i]) & sketch->width_mask];
+    if (count < min_count) {
+      min_count = count;
     }
+    row += sketch->width_mask + 1;
   }
   return min_count;
 }
 
 // Improved feature extraction
-static inline void extract_ml_features(FlowEntry *flow,
-                                       double features[ML_FEATURE_COUNT]) {
-  time_t now = time(NULL);
-  double time_diff =
-      (double)(now - flow->last_seen + 1); // Avoid division by zero
+static inline void extract_ml_features_at(const FlowEntry *flow, uint64_t now,
+                                          double features[ML_FEATURE_COUNT]) {
+  // Seconds since the last hit, plus one to avoid division by zero
+  double time_diff = (double)(now - flow->last_seen) * 1e-6 + 1.0;
 
   features[0] = (double)flow->confidence;
   features[1] = (double)flow->hits;
   features[2] = (double)flow->packet_count;
   features[3] = 100.0 / time_diff; // Higher for more recent
-  features[4] = flow->pattern.path_consistency * 100.0;
-  features[5] = flow->pattern.burst_score * 100.0;
+  features[4] = pattern_consistency(&flow->pattern) * 100.0;
+  features[5] = pattern_burst_score(&flow->pattern) * 100.0;
   features[6] =
       flow->hits > 0 ? (double)flow->cache_hits / flow->hits * 100.0 : 0.0;
   features[7] = (double)flow->flow_type * 10.0;
 }
 
+static inline void extract_ml_features(FlowEntry *flow,
+                                       double features[ML_FEATURE_COUNT]) {
+  extract_ml_features_at(flow, g_table->packet_time, features);
+}
+
 // Improved feature normalization
 static inline void normalize_features(MLModel *model,
                                       double features[ML_FEATURE_COUNT]) {
@@ -312,36 +748,188 @@ static inline void normalize_features(MLModel *model,
   }
 }
 
-// Enhanced ML predictor
-static inline double enhanced_ml_predict(FlowEntry *flow) {
-  if (!flow)
-    return 0.0;
-
-  double features[ML_FEATURE_COUNT];
-  extract_ml_features(flow, features);
-  normalize_features(g_table->ml_model, features);
+// Linear model on raw features (normalized in place)
+static inline double linear_predict(MLModel *model,
+                                    double features[ML_FEATURE_COUNT]) {
+  normalize_features(model, features);
 
   // Linear combination
-  double prediction = g_table->ml_model->bias;
+  double prediction = model->bias;
   for (int i = 0; i < ML_FEATURE_COUNT; i++) {
-    prediction += g_table->ml_model->weights[i] * features[i];
+    prediction += model->weights[i] * features[i];
   }
 
   // Sigmoid activation
   prediction = 1.0 / (1.0 + exp(-prediction));
-
-  g_table->ml_predictions++;
   return prediction;
 }
 
+// Boosted stumps: each comparison selects a leaf by index, so the walk has
+// no data-dependent branch and no exp(). Four partial sums keep the adds
+// independent; slots past stump_count are zero stumps.
+#define STUMP_LEAF(k)                                                          \
+  model->stump_value[k]                                                        \
+                    [features[model->stump_feature[k]] >                       \
+                     model->stump_threshold[k]]
+static inline double stumps_predict(const MLModel *model,
+                                    const double features[ML_FEATURE_COUNT]) {
+  double s0 = model->stump_base, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+  for (int k = 0; k < model->stump_count; k += 4) {
+    s0 += STUMP_LEAF(k);
+    s1 += STUMP_LEAF(k + 1);
+    s2 += STUMP_LEAF(k + 2);
+    s3 += STUMP_LEAF(k + 3);
+  }
+  double score = (s0 + s1) + (s2 + s3);
+  score = score < 0.0 ? 0.0 : score;
+  return score > 1.0 ? 1.0 : score;
+}
+#undef STUMP_LEAF
+
+// Quantized linear model: integer dot product, one float rescale
+static inline double quantized_predict(MLModel *model,
+                                       double features[ML_FEATURE_COUNT]) {
+  normalize_features(model, features);
+  int32_t acc = model->qbias;
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    acc += model->qweights[i] * (int32_t)(features[i] * 255.0 + 0.5);
+  }
+  return 1.0 / (1.0 + exp(-model->qscale / 255.0 * acc));
+}
+
+// Convert a linear model to int8 weights (symmetric, per-model scale)
+static inline void quantize_linear_model(MLModel *model) {
+  double max_weight = 0.0;
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    max_weight = fmax(max_weight, fabs(model->weights[i]));
+  }
+  model->qscale = max_weight > 0.0 ? max_weight / 127.0 : 1.0;
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    model->qweights[i] = (int8_t)lround(model->weights[i] / model->qscale);
+  }
+  model->qbias = (int32_t)lround(model->bias * 255.0 / model->qscale);
+  model->classifier = CLASSIFIER_QUANTIZED;
+}
+
+static inline double model_predict(MLModel *model, FlowEntry *flow) {
+  double features[ML_FEATURE_COUNT];
+  extract_ml_features(flow, features);
+  switch (model->classifier) {
+  case CLASSIFIER_STUMPS:
+    return stumps_predict(model, features);
+  case CLASSIFIER_QUANTIZED:
+    return quantized_predict(model, features);
+  default:
+    return linear_predict(model, features);
+  }
+}
+
+// Enhanced ML predictor (uncounted)
+static inline double ml_predict_raw(FlowEntry *flow) {
+  if (!flow)
+    return 0.0;
+  return model_predict(g_table->ml_model, flow);
+}
+
+static inline double monotonic_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Fold the live model into column form for bulk scoring
+static inline void build_bulk_score_model(const MLModel *model,
+                                          BulkScoreModel *out) {
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    double range = model->feature_maxs[i] - model->feature_mins[i];
+    if (range > 1e-6) {
+      out->scale[i] = (float)(1.0 / range);
+      out->offset[i] = (float)(-model->feature_mins[i] / range);
+    } else {
+      out->scale[i] = 0.0f;
+      out->offset[i] = 0.5f; // normalize_features' default
+    }
+    out->weights[i] = (float)model->weights[i];
+  }
+  out->bias = (float)model->bias;
+
+  out->stump_count =
+      model->classifier == CLASSIFIER_STUMPS ? model->stump_count : 0;
+  out->stump_base = (float)model->stump_base;
+  for (int k = 0; k < out->stump_count; k++) {
+    out->stump_feature[k] = model->stump_feature[k];
+    out->stump_threshold[k] = (float)model->stump_threshold[k];
+    out->stump_value[k][0] = (float)model->stump_value[k][0];
+    out->stump_value[k][1] = (float)model->stump_value[k][1];
+  }
+}
+
+// Score flows [from, to) into flow_scores: flows are gathered into feature
+// columns a block at a time and scored eight per instruction. Maintenance
+// and reporting read the scores instead of predicting per flow.
+static inline void score_flow_range(const BulkScoreModel *model, int from,
+                                    int to) {
+  BulkScoreColumns cols;
+  uint64_t now = g_table->packet_time;
+  for (int base = from; base < to; base += BULK_SCORE_BLOCK) {
+    int n = to - base < BULK_SCORE_BLOCK ? to - base : BULK_SCORE_BLOCK;
+    // Same features as extract_ml_features_at, written straight to columns
+    for (int j = 0; j < n; j++) {
+      const FlowEntry *flow = &g_table->flow_pool[base + j];
+      float hits = (float)flow->hits;
+      cols.col[0][j] = (float)flow->confidence;
+      cols.col[1][j] = hits;
+      cols.col[2][j] = (float)flow->packet_count;
+      cols.col[3][j] =
+          100.0f / ((float)(now - flow->last_seen) * 1e-6f + 1.0f);
+      cols.col[4][j] = (float)(pattern_consistency(&flow->pattern) * 100.0);
+      cols.col[5][j] = (float)(pattern_burst_score(&flow->pattern) * 100.0);
+      cols.col[6][j] =
+          flow->hits > 0 ? (float)flow->cache_hits / hits * 100.0f : 0.0f;
+      cols.col[7][j] = (float)flow->flow_type * 10.0f;
+    }
+    bulk_score_block(model, &cols, n, &g_table->flow_scores[base]);
+  }
+}
+
+// Score the whole pool with the live model
+static inline void score_flow_pool() {
+  double start = monotonic_seconds();
+  BulkScoreModel model;
+  build_bulk_score_model(g_table->ml_model, &model);
+  int pool_index = g_table->pool_index;
+  score_flow_range(&model, 0, pool_index);
+
+  g_table->bulk_score_passes++;
+  g_table->bulk_scored_flows += pool_index;
+  g_table->bulk_score_seconds += monotonic_seconds() - start;
+}
+
+// Flow score on the packet path: the ML prediction, or the promotion score as
+// a cheap proxy in variants built without ML
+PIPELINE_INLINE double flow_score(FlowEntry *flow, const unsigned features) {
+  if (features & PIPE_ML) {
+    PSTAT_FULL(features, ml_predictions);
+    return ml_predict_raw(flow);
+  }
+  return flow->promotion_score / 1000.0;
+}
+
 // Improved prediction cache
-static inline double check_prediction_cache(uint32_t ip) {
-  uint32_t cache_idx = fast_hash(ip) & (PREDICTION_CACHE_SIZE - 1);
+PIPELINE_INLINE double check_prediction_cache(uint32_t ip,
+                                              const unsigned features) {
+  uint32_t cache_idx = fast_hash(ip) & g_params.prediction_cache_mask;
   PredictionCache *cached = &g_table->prediction_cache[cache_idx];
 
-  time_t now = time(NULL);
-  if (cached->ip == ip && (now - cached->timestamp) < 30) { // 30 second cache
-    g_table->ml_cache_hits++;
+  PSTAT_FULL(features, ml_cache_lookups);
+  if (cached->ip == ip && g_table->packet_time < cached->expires) {
+    PSTAT_FULL(features, ml_cache_hits);
     return cached->prediction;
   }
   return -1.0;
@@ -349,70 +937,150 @@ static inline double check_prediction_cache(uint32_t ip) {
 
 static inline void update_prediction_cache(uint32_t ip, double prediction,
                                            ProcessingPath path) {
-  uint32_t cache_idx = fast_hash(ip) & (PREDICTION_CACHE_SIZE - 1);
+  uint32_t cache_idx = fast_hash(ip) & g_params.prediction_cache_mask;
   PredictionCache *entry = &g_table->prediction_cache[cache_idx];
 
   entry->ip = ip;
   entry->prediction = prediction;
   entry->suggested_path = path;
-  entry->timestamp = time(NULL);
+  entry->expires = g_table->packet_time + PREDICTION_CACHE_TTL;
   entry->confidence_level = (uint8_t)(prediction * 255);
 }
 
-// Simplified pattern update
-static inline void update_flow_pattern(FlowEntry *flow, ProcessingPath path) {
+// Pattern update: write one slot and adjust the counters for what it
+// replaced, with no scan of the window
+PIPELINE_INLINE void update_flow_pattern(FlowEntry *flow, ProcessingPath path,
+                                         const unsigned features) {
   FlowPattern *pattern = &flow->pattern;
+  uint32_t history = pattern->history;
+  uint32_t counts = pattern->counts;
+  uint32_t index = (history >> PATTERN_INDEX_SHIFT) & (ML_HISTORY_SIZE - 1);
+  uint32_t shift = index * PATTERN_SLOT_BITS;
+  uint32_t code = (uint32_t)path;
+  uint32_t old = (history >> shift) & PATTERN_SLOT_MASK;
+
+  // Transitions between adjacent slots (in slot order, as stored) only
+  // change for the neighbours of the slot being written
+  int delta = 0;
+  if (index > 0) {
+    uint32_t left = (history >> (shift - PATTERN_SLOT_BITS)) & PATTERN_SLOT_MASK;
+    delta += (code != left) - (old != left);
+  }
+  if (index < ML_HISTORY_SIZE - 1) {
+    uint32_t right =
+        (history >> (shift + PATTERN_SLOT_BITS)) & PATTERN_SLOT_MASK;
+    delta += (code != right) - (old != right);
+  }
+  counts += (uint32_t)delta << PATTERN_TRANSITIONS_SHIFT;
 
-  // Update path history
-  pattern->path_history[pattern->history_index] = (uint8_t)path;
-  pattern->history_index = (pattern->history_index + 1) % ML_HISTORY_SIZE;
-  if (!pattern->history_filled && pattern->history_index == 0) {
-    pattern->history_filled = 1;
-  }
-
-  // Calculate consistency - only if we have enough history
-  if (pattern->history_filled || pattern->history_index >= 4) {
-    int size =
-        pattern->history_filled ? ML_HISTORY_SIZE : pattern->history_index;
-    int consistent_count = 0;
-    uint8_t mode_path = pattern->path_history[0];
-
-    // Find most common path
-    int max_count = 0;
-    for (int i = 0; i < size; i++) {
-      int count = 1;
-      for (int j = i + 1; j < size; j++) {
-        if (pattern->path_history[j] == pattern->path_history[i])
-          count++;
-      }
-      if (count > max_count) {
-        max_count = count;
-        mode_path = pattern->path_history[i];
-      }
-    }
-
-    pattern->path_consistency = (double)max_count / size;
+  // Occupancy: the evicted path leaves the window once it has wrapped
+  if (history & PATTERN_FILLED_BIT) {
+    counts -= 1u << (PATTERN_OCCUPANCY_BITS * old);
   }
+  counts += 1u << (PATTERN_OCCUPANCY_BITS * code);
 
   // Track consecutive fast paths for promotion
-  if (path <= FAST_PATH) {
-    pattern->consecutive_fast_paths++;
-  } else {
-    pattern->consecutive_fast_paths = 0;
+  uint32_t streak = counts >> PATTERN_STREAK_SHIFT;
+  streak = path <= FAST_PATH
+               ? (streak < PATTERN_STREAK_MAX ? streak + 1 : streak)
+               : 0;
+  counts = (counts & ~(0x3u << PATTERN_STREAK_SHIFT)) |
+           streak << PATTERN_STREAK_SHIFT;
+
+  index = (index + 1) & (ML_HISTORY_SIZE - 1);
+  history = (history & ~(PATTERN_SLOT_MASK << shift)) | code << shift;
+  history = (history & ~(PATTERN_SLOT_MASK << PATTERN_INDEX_SHIFT)) |
+            index << PATTERN_INDEX_SHIFT;
+  if (index == 0) {
+    history |= PATTERN_FILLED_BIT;
   }
 
-  // Calculate burst score based on path variability
-  if (pattern->history_filled) {
-    int transitions = 0;
-    for (int i = 1; i < ML_HISTORY_SIZE; i++) {
-      if (pattern->path_history[i] != pattern->path_history[i - 1]) {
-        transitions++;
-      }
+  pattern->history = history;
+  pattern->counts = counts;
+  PSTAT_FULL(features, pattern_updates);
+}
+
+// Record a delayed-label training sample for this packet (1 in
+// ONLINE_SAMPLE_INTERVAL). Runs before the flow's last_packet is advanced.
+static inline void record_training_sample(FlowEntry *flow) {
+  OnlineTrainer *trainer = g_table->trainer;
+  if (!trainer ||
+      (g_table->total_processed & (ONLINE_SAMPLE_INTERVAL - 1)) != 0) {
+    return;
+  }
+  if (trainer->head - trainer->tail >= ONLINE_RING_SIZE) {
+    trainer->samples_dropped++;
+    return;
+  }
+
+  double features[ML_FEATURE_COUNT];
+  extract_ml_features(flow, features);
+  normalize_features(g_table->ml_model, features);
+
+  TrainingSample *sample =
+      &trainer->ring[trainer->head & (ONLINE_RING_SIZE - 1)];
+  MLModel *model = g_table->ml_model;
+  double z = model->bias;
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    sample->x[i] = (float)features[i];
+    z += model->weights[i] * features[i];
+  }
+  sample->prediction = (float)(1.0 / (1.0 + exp(-z)));
+  sample->packet_index = (uint32_t)g_table->total_processed;
+  sample->ip = flow->ip;
+  sample->flow_index = (int32_t)(flow - g_table->flow_pool);
+  trainer->head++;
+  trainer->samples_recorded++;
+}
+
+// Take one logistic regression SGD step for each of up to limit labelled
+// samples. Called from maintenance, never per packet; a backlog delays
+// training but not labels. Returns the number of samples trained.
+static inline int train_online_model(int limit) {
+  OnlineTrainer *trainer = g_table->trainer;
+  if (!trainer) {
+    return 0;
+  }
+
+  MLModel *model = g_table->ml_model;
+  double lr = model->learning_rate;
+  int trained = 0;
+
+  while (trained < limit && trainer->tail != trainer->labelled) {
+    TrainingSample *sample =
+        &trainer->ring[trainer->tail & (ONLINE_RING_SIZE - 1)];
+    int label = sample->label;
+
+    // Prequential accuracy: the prediction was made before this update
+    int predicted = sample->prediction > 0.5f;
+    model->validation_samples++;
+    if (predicted == label) {
+      model->validation_correct++;
+      trainer->labelled_correct++;
+    }
+    trainer->positive_labels += label;
+
+    // Gradient of the log loss with the current weights
+    double z = model->bias;
+    for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+      z += model->weights[i] * sample->x[i];
+    }
+    double error = 1.0 / (1.0 + exp(-z)) - label;
+    for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+      model->weights[i] -=
+          lr * (error * sample->x[i] + ONLINE_L2 * model->weights[i]);
     }
-    pattern->burst_score = (double)transitions / (ML_HISTORY_SIZE - 1);
+    model->bias -= lr * error;
+
+    trainer->tail++;
+    trained++;
   }
 
-  g_table->pattern_updates++;
+  if (trained > 0) {
+    trainer->samples_trained += trained;
+    trainer->training_batches++;
+  }
+  return trained;
 }
 
 // Better ML model adaptation
@@ -450,93 +1118,238 @@ static inline void adapt_ml_model() {
   model->last_adaptation = g_table->total_processed;
 }
 
-// Simplified aging strategies
+// Idle time (microseconds) after which each strategy starts aging a flow
+static inline uint32_t aging_threshold(AgingStrategy strategy) {
+  uint32_t timeout = (uint32_t)g_params.idle_timeout;
+  switch (strategy) {
+  case AGING_LINEAR:
+    return 3 * timeout;
+  case AGING_AGGRESSIVE:
+    return timeout + timeout / 2;
+  default:
+    return timeout;
+  }
+}
+
+// Simplified aging strategies, applied when a flow's idle timer expires.
+// Decay is scaled by idle time in units of the idle timeout.
 static inline void apply_aging_strategy(FlowEntry *flow,
-                                        AgingStrategy strategy) {
-  time_t now = time(NULL);
-  double idle_time = (double)(now - flow->last_seen);
+                                        AgingStrategy strategy, uint32_t idle,
+                                        double ml_score) {
+  double idle_periods = (double)idle / g_params.idle_timeout;
 
   switch (strategy) {
   case AGING_LINEAR:
-    if (idle_time > 180) { // 3 minutes
-      flow->confidence = flow->confidence > 3 ? flow->confidence - 3 : 0;
-    }
+    flow->confidence = flow->confidence > 3 ? flow->confidence - 3 : 0;
     break;
 
-  case AGING_EXPONENTIAL:
-    if (idle_time > 60) {                       // 1 minute
-      double decay = 1.0 - (idle_time / 600.0); // 10 minute decay
-      if (decay < 0.1)
-        decay = 0.1;
-      flow->confidence = (uint16_t)(flow->confidence * decay);
-    }
-    break;
+  case AGING_EXPONENTIAL: {
+    double decay = 1.0 - idle_periods / 10.0;
+    if (decay < 0.1)
+      decay = 0.1;
+    flow->confidence = (uint16_t)(flow->confidence * decay);
+  } break;
 
   case AGING_ADAPTIVE: {
-    double ml_score = enhanced_ml_predict(flow);
     double protection = ml_score * 0.8; // Protect high-scoring flows
-    double decay = (idle_time / 1200.0) * (1.0 - protection); // 20 minute base
+    double decay = idle_periods / 20.0 * (1.0 - protection);
+    if (decay > 1.0)
+      decay = 1.0;
     flow->confidence = (uint16_t)(flow->confidence * (1.0 - decay));
   } break;
 
   case AGING_AGGRESSIVE:
-    if (idle_time > 90) { // 1.5 minutes
-      flow->confidence = flow->confidence > 8 ? flow->confidence - 8 : 0;
-      if (flow->confidence < 15) {
-        flow->flow_type = DYING_FLOW;
-      }
+    flow->confidence = flow->confidence > 8 ? flow->confidence - 8 : 0;
+    if (flow->confidence < 15) {
+      flow->flow_type = DYING_FLOW;
     }
     break;
   }
 }
 
-// Fixed burst detection
-static inline int detect_burst_enhanced() {
-  AgingManager *manager = g_table->aging_manager;
+// Arm a flow's idle timer delay microseconds from now
+static inline void arm_idle_timer(int32_t pool_idx, uint32_t delay) {
+  uint64_t due = g_table->packet_time + delay;
+  timing_wheel_schedule(&g_table->idle_wheel, pool_idx,
+                        (uint32_t)((due + IDLE_TICK_US - 1) >> IDLE_TICK_SHIFT));
+}
+
+// Packet time since the flow's last hit, saturated to 32 bits
+static inline uint32_t flow_idle_time(const FlowEntry *flow, uint64_t now) {
+  uint64_t idle = now - flow->last_seen;
+  return idle < UINT32_MAX ? (uint32_t)idle : UINT32_MAX;
+}
 
-  // Simple burst detection based on packet rate
-  static uint64_t last_packet_count = 0;
-  static time_t last_check = 0;
+// Age one flow whose idle timer expired. Hits never touch the wheel, so the
+// flow may have been active since; it is then re-armed at its real deadline
+// instead of being aged. Each live flow therefore costs one visit per idle
+// timeout, and only flows that really sat idle are aged.
+static inline void age_idle_flow(int32_t idx, uint64_t now) {
+  AgingManager *manager = g_table->aging_manager;
+  FlowEntry *flow = &g_table->flow_pool[idx];
+  uint32_t idle = flow_idle_time(flow, now);
+  uint32_t threshold = aging_threshold(flow->aging.aging_strategy);
+  if (idle < threshold) {
+    arm_idle_timer(idx, threshold - idle);
+    manager->idle_rearms++;
+    return;
+  }
 
-  time_t now = time(NULL);
-  if (now != last_check) {
-    uint64_t packets_this_second = g_table->total_processed - last_packet_count;
+  flow->aging.idle_periods++;
+  double ml_score = flow->aging.aging_strategy == AGING_ADAPTIVE
+                        ? ml_predict_raw(flow)
+                        : 0.0;
+  apply_aging_strategy(flow, flow->aging.aging_strategy, idle, ml_score);
+  manager->flows_aged++;
+
+  // Track flow state changes
+  if (flow->confidence < 10 && flow->flow_type != DYING_FLOW) {
+    flow->previous_type = flow->flow_type;
+    flow->flow_type = DYING_FLOW;
+    manager->flows_demoted++;
+  }
 
-    // Update burst history
-    manager->burst_history[manager->burst_index] =
-        (uint32_t)packets_this_second;
-    manager->burst_index = (manager->burst_index + 1) % BURST_WINDOW_SIZE;
+  // Expired: stays unarmed until the flow sees traffic again
+  if (flow->flow_type == DYING_FLOW &&
+      idle >= DYING_EXPIRY_PERIODS * (uint32_t)g_params.idle_timeout) {
+    flow->confidence = 0;
+    manager->flows_aged_out++;
+    return;
+  }
+  arm_idle_timer(idx, (uint32_t)g_params.idle_timeout);
+}
 
-    // Calculate average rate
-    uint32_t total = 0;
-    for (int i = 0; i < BURST_WINDOW_SIZE; i++) {
-      total += manager->burst_history[i];
+// Advance the idle wheel to the current packet time and age what expired, using
+// at most limit entries (cascaded plus expired timers); the rest waits for
+// the next slice. Expired timers are drained in batches so their (random)
+// flow entries can be prefetched before any is touched. Returns the entries
+// used.
+static inline int expire_idle_flows(int limit) {
+  TimingWheel *wheel = &g_table->idle_wheel;
+  MaintenanceScheduler *maint = g_table->maint;
+  uint64_t now = g_table->packet_time;
+  int cascaded =
+      timing_wheel_advance(wheel, (uint32_t)(now >> IDLE_TICK_SHIFT), limit);
+  maint->cascade_entries += (uint64_t)cascaded;
+
+  int used = cascaded;
+  int32_t batch[IDLE_EXPIRY_BATCH];
+  while (used < limit) {
+    int cap = limit - used < IDLE_EXPIRY_BATCH ? limit - used
+                                               : IDLE_EXPIRY_BATCH;
+    int n = 0;
+    int32_t idx;
+    while (n < cap && (idx = timing_wheel_pop_expired(wheel)) >= 0) {
+      const char *entry = (const char *)&g_table->flow_pool[idx];
+      __builtin_prefetch(entry, 1);
+      __builtin_prefetch(entry + sizeof(FlowEntry) - 1, 1);
+      batch[n++] = idx;
+    }
+    for (int i = 0; i < n; i++) {
+      age_idle_flow(batch[i], now);
+    }
+    used += n;
+    maint->expiry_entries += (uint64_t)n;
+    if (n < cap) {
+      break;
     }
-    manager->current_burst_rate = (double)total / BURST_WINDOW_SIZE;
+  }
+  return used;
+}
+
+// A flow aged while idle got a packet: restart its idle period, re-arming
+// the timer if the flow had expired
+static inline void revive_idle_flow(FlowEntry *flow) {
+  flow->aging.idle_periods = 0;
+  int32_t idx = (int32_t)(flow - g_table->flow_pool);
+  if (!timing_wheel_armed(&g_table->idle_wheel, idx)) {
+    arm_idle_timer(idx, aging_threshold(flow->aging.aging_strategy));
+  }
+}
 
-    last_packet_count = g_table->total_processed;
-    last_check = now;
+// log2(value) in BURST_LOG2_FRAC_BITS fixed point, linear between powers.
+// Branch-free: the gaps it sees are effectively random.
+static inline int32_t burst_log2(uint32_t value) {
+  int leading = __builtin_clz(value | 1);
+  uint32_t normalized = value << leading; // Top bit set
+  return ((31 - leading) << BURST_LOG2_FRAC_BITS) |
+         (int32_t)((normalized >> (31 - BURST_LOG2_FRAC_BITS)) &
+                   ((1u << BURST_LOG2_FRAC_BITS) - 1));
+}
 
-    // Detect burst if current rate is significantly above average
-    return (packets_this_second > manager->current_burst_rate * 2.0 &&
-            packets_this_second > BURST_THRESHOLD);
+// Fold one hit into the flow's gap EWMAs and report whether its short-term
+// rate is bursting. Gaps are in microseconds of packet time and averaged in
+// the log domain, which spans any idle spell and makes "twice the long-term
+// rate" a fixed difference.
+static inline int flow_burst_update(FlowEntry *flow) {
+  int32_t sample = burst_log2(flow_idle_time(flow, g_table->packet_time));
+  if (flow->burst_gap_slow == BURST_GAP_UNSET) {
+    flow->burst_gap_fast = flow->burst_gap_slow = (uint16_t)sample;
+    return 0;
   }
+  int32_t fast = flow->burst_gap_fast;
+  int32_t slow = flow->burst_gap_slow;
+  fast += (sample - fast) / (1 << BURST_GAP_FAST_SHIFT);
+  slow += (sample - slow) / (1 << BURST_GAP_SLOW_SHIFT);
+  flow->burst_gap_fast = (uint16_t)fast;
+  flow->burst_gap_slow = (uint16_t)slow;
+  return (fast < g_params.burst_gap_limit) &
+         (fast + (BURST_RATE_RATIO_LOG2 << BURST_LOG2_FRAC_BITS) < slow);
+}
 
-  return 0;
+// Close the finished arrival tick: fold the new-flow count into the global
+// EWMAs and decide whether arrivals are surging
+static inline void burst_tick() {
+  AgingManager *manager = g_table->aging_manager;
+  double sample = manager->tick_arrivals;
+  if (manager->arrival_ticks++ == 0) {
+    manager->arrival_rate_fast = manager->arrival_rate_slow = sample;
+  } else {
+    manager->arrival_rate_fast +=
+        (sample - manager->arrival_rate_fast) / BURST_ARRIVAL_FAST;
+    manager->arrival_rate_slow +=
+        (sample - manager->arrival_rate_slow) / BURST_ARRIVAL_SLOW;
+  }
+  int surge = manager->arrival_rate_fast >
+                  manager->arrival_rate_slow * (1 << BURST_RATE_RATIO_LOG2) &&
+              manager->arrival_rate_fast * (BURST_RATE_WINDOW / BURST_TICK_US) >
+                  g_params.burst_threshold;
+  manager->surges += surge && !manager->arrival_surge;
+  manager->surge_ticks += surge;
+  manager->arrival_surge = surge;
+  manager->tick_arrivals = 0;
+  manager->burst_tick_end += BURST_TICK_US;
 }
 
-// Enhanced aging cycle
-static inline void enhanced_aging_cycle() {
+// Close every tick packet time has passed. The ticks of a long silence are
+// empty; after BURST_IDLE_TICKS of them the EWMAs have settled, so the
+// rest are skipped.
+static inline void burst_advance_ticks() {
   AgingManager *manager = g_table->aging_manager;
-  time_t now = time(NULL);
+  uint64_t now = g_table->packet_time;
+  for (int ticks = 0; now >= manager->burst_tick_end; ticks++) {
+    if (ticks == BURST_IDLE_TICKS) {
+      manager->burst_tick_end = now - now % BURST_TICK_US + BURST_TICK_US;
+      break;
+    }
+    burst_tick();
+  }
+}
 
-  if (now - manager->last_aging_cycle < 30) { // 30 second cycles
-    return;
+// A new flow arrived (burst detection's global rate)
+PIPELINE_INLINE void burst_note_arrival(const unsigned features) {
+  if (features & PIPE_BURST) {
+    g_table->aging_manager->tick_arrivals++;
   }
+}
+
+// Aging pressure update; the aging itself runs off the idle timers
+static inline void enhanced_aging_cycle() {
+  AgingManager *manager = g_table->aging_manager;
 
   // Calculate memory pressure
   manager->memory_utilization =
-      (double)g_table->pool_index / g_table->pool_size;
+      (double)g_table->live_flows / g_table->pool_size;
 
   // Adjust aging pressure
   if (manager->memory_utilization > 0.85) {
@@ -546,90 +1359,487 @@ static inline void enhanced_aging_cycle() {
   } else {
     manager->aging_pressure = 0.3;
   }
+}
 
-  // Age a subset of flows
-  int flows_to_age = (int)(g_table->pool_index * 0.1); // Age 10% each cycle
-
-  for (int i = 0; i < flows_to_age && i < g_table->pool_index; i++) {
-    int flow_idx = (int)(g_table->total_processed + i) % g_table->pool_index;
-    FlowEntry *flow = &g_table->flow_pool[flow_idx];
-
-    if (flow->ip != 0) { // Active flow
-      apply_aging_strategy(flow, flow->aging.aging_strategy);
-
-      // Track flow state changes
-      if (flow->confidence < 10 && flow->flow_type != DYING_FLOW) {
-        flow->previous_type = flow->flow_type;
-        flow->flow_type = DYING_FLOW;
-        manager->flows_demoted++;
-      }
-    }
+// Eviction policy: does the flow at an S3-FIFO queue head stay? A hit since
+// the last visit keeps it (micro flows on probation need two). An idle flow
+// is forgiven rounds by the value it has built up: two if large or promoted,
+// one if it already earns the fast path, and one more if its model or
+// promotion score beats the aging pressure, so protection narrows as the
+// pool fills. Dying flows are never forgiven.
+static int flow_keep(void *ctx, int32_t idx, int in_main) {
+  (void)ctx;
+  FlowEntry *flow = &g_table->flow_pool[idx];
+  int needed = flow->flow_type == MICRO_FLOW && !in_main ? 2 : 1;
+  if (flow->evict_freq >= needed) {
+    flow->evict_freq = in_main ? flow->evict_freq - 1 : 0;
+    flow->evict_grace = 0;
+    return 1;
+  }
+  if (flow->flow_type == DYING_FLOW) {
+    return 0;
   }
 
-  manager->last_aging_cycle = now;
+  int grace = 0;
+  if (flow->flow_type == LARGE_FLOW || flow->flow_type == PROMOTED_FLOW) {
+    grace = 2;
+  } else if (flow->confidence >= g_params.confidence_fast_track) {
+    grace = 1;
+  }
+  double score = g_table->flow_scores[idx];
+  double promotion = flow->promotion_score / 1000.0;
+  if ((score > promotion ? score : promotion) >
+      g_table->aging_manager->aging_pressure) {
+    grace++;
+  }
+  if (flow->evict_grace < grace) {
+    flow->evict_grace++;
+    return 1;
+  }
+  return 0;
 }
 
-// Initialize optimized table
-OptimizedTable *init_optimized_table() {
-  OptimizedTable *table = (OptimizedTable *)calloc(1, sizeof(OptimizedTable));
-  table->hash_table = init_hash_table();
-  table->sketch = init_fast_sketch();
-  table->ml_model = init_ml_model();
-  table->aging_manager = init_aging_manager();
-
-  table->pool_size =
-      LARGE_FLOW_AREA_SIZE + BURSTY_FLOW_AREA_SIZE + MICRO_FLOW_AREA_SIZE;
-  table->flow_pool = (FlowEntry *)calloc(table->pool_size, sizeof(FlowEntry));
-  table->pool_index = 0;
+// What happens to the packets of a flow with an inspection outstanding
+typedef enum {
+  OFFLOAD_HOLD = 0, // Held until the verdict, then released on the fast path
+  OFFLOAD_PASS = 1  // Pass on the fast path provisionally
+} OffloadPolicy;
 
-  return table;
+// An inspection thread with its own request and completion queues. Only the
+// packet thread pushes requests and pops completions.
+typedef struct {
+  SpscQueue requests;
+  SpscQueue completions;
+  SlowPathWorkload workload; // Private copy: its match counter is per thread
+  pthread_t thread;
+  int stop;
+  uint64_t inspections; // Written by the worker only
+} OffloadWorker;
+
+// Slow-path inspection, inline or offloaded. Everything but the workers'
+// own fields belongs to the packet thread.
+typedef struct {
+  OffloadWorker workers[OFFLOAD_MAX_WORKERS];
+  int worker_count; // 0 = inline
+  OffloadPolicy policy;
+  uint64_t queued;
+  uint64_t completed;
+  uint64_t stale;       // Verdicts for flows evicted meanwhile
+  uint64_t queue_full;  // Inspections run inline because a queue was full
+  uint64_t outstanding; // Queued but not yet applied
+  uint64_t held;
+  uint64_t released;
+  uint64_t held_dropped; // Held packets of flows evicted before the verdict
+  uint64_t provisional;  // Packets passed before the verdict
+  uint64_t alerts;       // Inspections that raised alerts
+  LatencyHistogram turnaround; // Queue to verdict, ns
+
+  // Fast-path latency, both modes: from one sampled fast-path packet to the
+  // next one, so inspection work run inline in between counts against it
+  LatencyHistogram fast_latency;
+  uint64_t fast_mark_ns;
+  uint32_t fast_countdown;
+} InspectionEngine;
+
+static InspectionEngine g_inspect;
+
+// A flow leaving the table drops the packets it still holds
+static inline void offload_forget(FlowEntry *flow) {
+  g_inspect.held_dropped += flow->inspect_held;
+  flow->inspect_held = 0;
+  flow->inspect_pending = 0;
 }
 
-// Fast flow lookup
-static inline FlowEntry *find_flow_fast(uint32_t ip) {
-  uint32_t cache_idx = fast_hash(ip) & (CACHE_SIZE - 1);
-  FlowEntry *cached = g_table->fast_cache[cache_idx];
-
-  if (cached && cached->ip == ip) {
-    g_table->cache_hits++;
-    cached->cache_hits++;
-    return cached;
+// Evict one flow chosen by the policy and recycle its slot. Returns 0 when
+// no flow leaves: the queues are empty or every flow visited is kept.
+static inline int evict_flow() {
+  int from_small;
+  int32_t idx = s3fifo_evict(&g_table->evictor, flow_keep, NULL, &from_small);
+  if (idx < 0) {
+    return 0;
+  }
+  FlowEntry *flow = &g_table->flow_pool[idx];
+  uint32_t ip = flow->ip;
+  if (from_small) {
+    s3fifo_ghost_insert(&g_table->evictor, ip);
   }
 
-  g_table->hash_table->total_lookups++;
-  uint32_t bucket = fast_hash(ip) & (HASH_TABLE_SIZE - 1);
-  FlowEntry *entry = g_table->hash_table->buckets[bucket];
-
-  while (entry) {
-    if (entry->ip == ip) {
-      g_table->fast_cache[cache_idx] = entry;
-      return entry;
+  // Unlink from the direct index or its hash chain, and the lookup cache
+  if (ip < g_table->direct_range) {
+    g_table->direct_bitmap[ip >> 6] &= ~(1ULL << (ip & 63));
+  } else {
+    FlowEntry **link =
+        &g_table->hash_table->buckets[fast_hash(ip) & (HASH_TABLE_SIZE - 1)];
+    while (*link != flow) {
+      link = &(*link)->next;
     }
-    entry = entry->next;
-    g_table->hash_table->collision_count++;
+    *link = flow->next;
   }
+  FlowEntry **cached = &g_table->fast_cache[fast_hash(ip) & g_params.cache_mask];
+  if (*cached == flow) {
+    *cached = NULL;
+  }
+  g_table->hash_table->total_entries--;
+  timing_wheel_cancel(&g_table->idle_wheel, idx);
 
-  g_table->cache_misses++;
-  return NULL;
+  AgingManager *manager = g_table->aging_manager;
+  manager->flows_evicted++;
+  manager->evicted_by_type[flow->flow_type]++;
+  offload_forget(flow);
+  flow->ip = 0; // Marks the slot free for pool scans
+  g_table->free_slots[g_table->free_count++] = idx;
+  g_table->live_flows--;
+  return 1;
 }
 
-// Enhanced flow creation
-static inline FlowEntry *create_flow_fast(uint32_t ip) {
-  if (g_table->pool_index >= g_table->pool_size) {
-    return NULL;
+// Evict down to the target utilization, at most limit flows. Returns the
+// flows evicted.
+static inline int evict_to_target(int limit) {
+  int target = (int)(g_params.evict_target * g_table->pool_size);
+  int evicted = 0;
+  while (evicted < limit && g_table->live_flows > target && evict_flow()) {
+    evicted++;
   }
+  return evicted;
+}
 
-  FlowEntry *new_flow = &g_table->flow_pool[g_table->pool_index++];
-  memset(new_flow, 0, sizeof(FlowEntry));
+// Promote and demote flows [from, to) by their flow_scores
+static inline void lifecycle_apply(int from, int to) {
+  uint64_t now = g_table->packet_time;
+  int promoted_count = 0;
+  int demoted_count = 0;
 
-  new_flow->ip = ip;
-  new_flow->confidence = 35; // Slightly higher starting confidence
-  new_flow->hits = 1;
-  new_flow->packet_count = 1;
-  new_flow->last_seen = time(NULL);
-  new_flow->flow_type = NORMAL_FLOW;
-  new_flow->previous_type = NORMAL_FLOW;
-  new_flow->promotion_score = 100; // Start with some promotion potential
+  for (int i = from; i < to; i++) {
+    FlowEntry *flow = &g_table->flow_pool[i];
+    if (flow->ip == 0)
+      continue;
+
+    uint32_t idle = flow_idle_time(flow, now);
+    double ml_score = g_table->flow_scores[i];
+
+    // Promote promising flows
+    if (flow->flow_type == NORMAL_FLOW && ml_score > 0.75 &&
+        flow->promotion_score > 700 && flow->hits > 8) {
+      flow->previous_type = flow->flow_type;
+      flow->flow_type = PROMOTED_FLOW;
+      flow->confidence = (uint16_t)g_params.confidence_fast_track;
+      promoted_count++;
+    }
+
+    // Demote underperforming promoted flows
+    if (flow->flow_type == PROMOTED_FLOW &&
+        (ml_score < 0.4 || idle > 5 * (uint32_t)g_params.idle_timeout ||
+         flow->promotion_score < 200)) {
+      flow->flow_type = flow->previous_type;
+      flow->confidence = flow->confidence > 15 ? flow->confidence - 15 : 10;
+      demoted_count++;
+    }
+  }
+
+  g_table->aging_manager->flows_promoted += promoted_count;
+  g_table->aging_manager->flows_demoted += demoted_count;
+}
+
+// Advanced flow lifecycle management: a whole pass at once, scored in bulk
+static inline void manage_flow_lifecycle() {
+  score_flow_pool();
+  lifecycle_apply(0, g_table->pool_index);
+}
+
+// Advance the running lifecycle pass by up to limit flows, starting a new
+// pass once LIFECYCLE_INTERVAL packets have passed since the last start.
+// The pass scores with the model snapshot taken when it started. Returns the
+// flows processed.
+static inline int lifecycle_step(int limit) {
+  MaintenanceScheduler *maint = g_table->maint;
+  if (maint->lifecycle_end == 0) {
+    if (g_table->total_processed - maint->lifecycle_started <
+            LIFECYCLE_INTERVAL ||
+        g_table->pool_index == 0) {
+      return 0;
+    }
+    maint->lifecycle_started = g_table->total_processed;
+    maint->lifecycle_cursor = 0;
+    maint->lifecycle_end = g_table->pool_index;
+    build_bulk_score_model(g_table->ml_model, &maint->lifecycle_model);
+  }
+
+  int from = maint->lifecycle_cursor;
+  int n = maint->lifecycle_end - from < limit ? maint->lifecycle_end - from
+                                              : limit;
+  score_flow_range(&maint->lifecycle_model, from, from + n);
+  lifecycle_apply(from, from + n);
+  maint->lifecycle_cursor += n;
+  maint->lifecycle_entries += (uint64_t)n;
+
+  if (maint->lifecycle_cursor == maint->lifecycle_end) {
+    maint->lifecycle_end = 0;
+    maint->lifecycle_passes++;
+    maint->lifecycle_pass_packets +=
+        g_table->total_processed - maint->lifecycle_started;
+  }
+  return n;
+}
+
+// Flows per slice that finish the running lifecycle pass within
+// LIFECYCLE_INTERVAL packets of its start
+static inline int lifecycle_pace() {
+  MaintenanceScheduler *maint = g_table->maint;
+  if (maint->lifecycle_end == 0) {
+    return g_table->total_processed - maint->lifecycle_started >=
+                   LIFECYCLE_INTERVAL
+               ? 1 // Lets the pass start; the next slice computes its pace
+               : 0;
+  }
+  uint64_t deadline = maint->lifecycle_started + LIFECYCLE_INTERVAL;
+  uint64_t slices_left =
+      deadline > g_table->total_processed
+          ? (deadline - g_table->total_processed) / g_params.maint_interval
+          : 0;
+  int remaining = maint->lifecycle_end - maint->lifecycle_cursor;
+  return slices_left > 0 ? (int)((remaining + slices_left - 1) / slices_left)
+                         : remaining;
+}
+
+// One maintenance slice. O(1) upkeep runs whenever due. Entry-based work
+// shares the budget: the lifecycle pass gets the pace that finishes it on
+// schedule (at most half the budget), training its sample rate (at most a
+// quarter), eviction toward the target utilization at most a quarter, idle
+// expiry what is left, and training backlog any remainder.
+// With maint_budget 0 every task runs all of its due work at once.
+static inline void run_maintenance_slice(int train) {
+  MaintenanceScheduler *maint = g_table->maint;
+  uint64_t start = monotonic_ns();
+
+  if (g_table->total_processed >= g_table->next_aging_at) {
+    g_table->next_aging_at += (uint64_t)g_params.aging_interval;
+    enhanced_aging_cycle();
+  }
+  adapt_ml_model();
+
+  int budget = INT_MAX;
+  int pace = INT_MAX;
+  int share = INT_MAX;
+  if (g_params.maint_budget > 0) {
+    budget = g_params.maint_budget;
+    pace = lifecycle_pace();
+    if (pace > budget / 2) {
+      pace = budget / 2 > 0 ? budget / 2 : 1;
+    }
+    share = g_params.maint_interval / ONLINE_SAMPLE_INTERVAL + 1;
+    if (share > budget / 4) {
+      share = budget / 4;
+    }
+  }
+
+  int used = lifecycle_step(pace);
+  int trained = train ? train_online_model(share) : 0;
+  used += trained;
+  if (used < budget) {
+    int evict_share = budget == INT_MAX ? INT_MAX : budget / 4 + 1;
+    int evicted =
+        evict_to_target(evict_share < budget - used ? evict_share : budget - used);
+    maint->evict_entries += (uint64_t)evicted;
+    used += evicted;
+  }
+  if (used < budget) {
+    used += expire_idle_flows(budget - used);
+  }
+  if (used < budget && train) {
+    int extra = train_online_model(budget - used);
+    trained += extra;
+    used += extra;
+  }
+  maint->training_entries += (uint64_t)trained;
+
+  if (train && g_table->total_processed % ONLINE_TRAIN_INTERVAL == 0 &&
+      g_table->shadow && g_table->shadow->tracks_live) {
+    g_table->shadow->model = *g_table->ml_model;
+    quantize_linear_model(&g_table->shadow->model);
+  }
+
+  maint->slices++;
+  maint->saturated_slices += used >= budget;
+  latency_histogram_record(&maint->latency, monotonic_ns() - start);
+}
+
+// Initialize optimized table
+OptimizedTable *init_optimized_table() {
+  OptimizedTable *table = (OptimizedTable *)engine_alloc(sizeof(OptimizedTable));
+  table->hash_table = init_hash_table();
+  table->fast_cache =
+      (FlowEntry **)engine_alloc(g_params.cache_size * sizeof(FlowEntry *));
+  table->sketch = init_fast_sketch();
+  table->ml_model = init_ml_model();
+  table->prediction_cache = (PredictionCache *)engine_alloc(
+      g_params.prediction_cache_size * sizeof(PredictionCache));
+  table->aging_manager = init_aging_manager();
+
+  table->pool_size =
+      LARGE_FLOW_AREA_SIZE + BURSTY_FLOW_AREA_SIZE + MICRO_FLOW_AREA_SIZE;
+  table->flow_pool =
+      (FlowEntry *)engine_alloc(table->pool_size * sizeof(FlowEntry));
+  table->trainer = (OnlineTrainer *)engine_alloc(sizeof(OnlineTrainer));
+  table->flow_scores = (float *)engine_alloc(table->pool_size * sizeof(float));
+  table->maint =
+      (MaintenanceScheduler *)engine_alloc(sizeof(MaintenanceScheduler));
+  timing_wheel_init(&table->idle_wheel, table->pool_size,
+                    (TimingWheelNode *)engine_alloc(
+                        timing_wheel_nodes(table->pool_size) *
+                        sizeof(TimingWheelNode)),
+                    0);
+  uint32_t ring = s3fifo_ring_size(table->pool_size);
+  s3fifo_init(&table->evictor, table->pool_size,
+              (int32_t *)engine_alloc(ring * sizeof(int32_t)),
+              (int32_t *)engine_alloc(ring * sizeof(int32_t)),
+              (uint32_t *)engine_alloc(ring * sizeof(uint32_t)));
+  table->free_slots =
+      (int32_t *)engine_alloc(table->pool_size * sizeof(int32_t));
+  table->pool_index = 0;
+  table->next_aging_at = (uint64_t)g_params.aging_interval;
+
+  return table;
+}
+
+// Switch lookups to a direct-indexed array when the key space is bounded.
+// Keys at or above the range keep using the hashed path.
+int enable_direct_index(uint32_t range) {
+  if (range == 0 || range > DIRECT_INDEX_MAX_RANGE) {
+    return 0;
+  }
+
+  uint32_t words = (range + 63) / 64;
+  g_table->direct_index = (int32_t *)engine_alloc(range * sizeof(int32_t));
+  g_table->direct_bitmap = (uint64_t *)engine_alloc(words * sizeof(uint64_t));
+  if (!g_table->direct_index || !g_table->direct_bitmap) {
+    engine_free(g_table->direct_index);
+    engine_free(g_table->direct_bitmap);
+    g_table->direct_index = NULL;
+    g_table->direct_bitmap = NULL;
+    return 0;
+  }
+  g_table->direct_range = range;
+
+  // Index any flows created before the switch
+  for (int i = 0; i < g_table->pool_index; i++) {
+    uint32_t ip = g_table->flow_pool[i].ip;
+    if (ip < range) {
+      g_table->direct_index[ip] = i;
+      g_table->direct_bitmap[ip >> 6] |= 1ULL << (ip & 63);
+    }
+  }
+  return 1;
+}
+
+// Fast flow lookup
+PIPELINE_INLINE FlowEntry *find_flow_fast(uint32_t ip,
+                                          const unsigned features) {
+  // Bounded key space: one bit test, then a single indexed load
+  if (ip < g_table->direct_range) {
+    if (!((g_table->direct_bitmap[ip >> 6] >> (ip & 63)) & 1)) {
+      PSTAT_BASIC(features, cache_misses);
+      return NULL;
+    }
+    FlowEntry *direct = &g_table->flow_pool[g_table->direct_index[ip]];
+    PSTAT_BASIC(features, cache_hits);
+    direct->cache_hits++;
+    return direct;
+  }
+
+  uint32_t cache_idx = fast_hash(ip) & g_params.cache_mask;
+  FlowEntry *cached = g_table->fast_cache[cache_idx];
+
+  if (cached && cached->ip == ip) {
+    PSTAT_BASIC(features, cache_hits);
+    cached->cache_hits++;
+    return cached;
+  }
+
+  PSTAT_FULL(features, total_lookups);
+  uint32_t bucket = fast_hash(ip) & (HASH_TABLE_SIZE - 1);
+  FlowEntry *entry = g_table->hash_table->buckets[bucket];
+
+  while (entry) {
+    if (entry->ip == ip) {
+      g_table->fast_cache[cache_idx] = entry;
+      return entry;
+    }
+    entry = entry->next;
+    PSTAT_FULL(features, collision_count);
+  }
+
+  PSTAT_BASIC(features, cache_misses);
+  return NULL;
+}
+
+// Lookup without touching caches or per-flow counters
+static inline FlowEntry *peek_flow(uint32_t ip) {
+  if (ip < g_table->direct_range) {
+    if (!((g_table->direct_bitmap[ip >> 6] >> (ip & 63)) & 1)) {
+      return NULL;
+    }
+    return &g_table->flow_pool[g_table->direct_index[ip]];
+  }
+  FlowEntry *entry =
+      g_table->hash_table->buckets[fast_hash(ip) & (HASH_TABLE_SIZE - 1)];
+  while (entry && entry->ip != ip) {
+    entry = entry->next;
+  }
+  return entry;
+}
+
+// Label the samples whose horizon ends at this packet: did the flow recur in
+// the ONLINE_LABEL_HORIZON packets after the sample, this one included?
+// Called every ONLINE_SAMPLE_INTERVAL packets; sample indices and the
+// horizon are multiples of the interval, so each label is taken exactly at
+// the horizon, the same target the offline trainer uses.
+static inline void label_training_samples(void) {
+  OnlineTrainer *trainer = g_table->trainer;
+  uint32_t now = (uint32_t)g_table->total_processed;
+  while (trainer->labelled != trainer->head) {
+    TrainingSample *sample =
+        &trainer->ring[trainer->labelled & (ONLINE_RING_SIZE - 1)];
+    if (now - sample->packet_index < ONLINE_LABEL_HORIZON) {
+      break; // Ring is in packet order, the rest are newer
+    }
+    // The sampled slot, unless the flow was evicted and perhaps re-created
+    FlowEntry *flow = &g_table->flow_pool[sample->flow_index];
+    if (flow->ip != sample->ip) {
+      flow = peek_flow(sample->ip);
+    }
+    sample->label =
+        flow && (int32_t)(flow->last_packet - sample->packet_index) > 0;
+    trainer->labelled++;
+  }
+}
+
+// Enhanced flow creation
+static inline FlowEntry *create_flow_fast(uint32_t ip) {
+  int32_t pool_idx;
+  if (g_table->free_count > 0) {
+    pool_idx = g_table->free_slots[--g_table->free_count];
+  } else if (g_table->pool_index < g_table->pool_size) {
+    pool_idx = g_table->pool_index++;
+  } else {
+    return NULL;
+  }
+  g_table->live_flows++;
+  g_table->flows_created++;
+
+  FlowEntry *new_flow = &g_table->flow_pool[pool_idx];
+  memset(new_flow, 0, sizeof(FlowEntry));
+
+  new_flow->ip = ip;
+  new_flow->confidence = 35; // Slightly higher starting confidence
+  new_flow->hits = 1;
+  new_flow->packet_count = 1;
+  new_flow->burst_gap_fast = BURST_GAP_UNSET;
+  new_flow->burst_gap_slow = BURST_GAP_UNSET;
+  new_flow->last_seen = g_table->packet_time;
+  new_flow->last_packet = (uint32_t)g_table->total_processed;
+  new_flow->flow_type = NORMAL_FLOW;
+  new_flow->previous_type = NORMAL_FLOW;
+  new_flow->promotion_score = 100; // Start with some promotion potential
 
   // Initialize aging
   new_flow->aging.creation_time = new_flow->last_seen;
@@ -637,19 +1847,46 @@ static inline FlowEntry *create_flow_fast(uint32_t ip) {
   new_flow->aging.aging_strategy = AGING_EXPONENTIAL;
   new_flow->aging.aging_multiplier = 1.0;
 
-  // Initialize pattern
-  new_flow->pattern.path_consistency = 1.0;
-  new_flow->pattern.burst_score = 0.0;
+  // Pattern starts empty (zeroed above); no model score until scored
+  arm_idle_timer(pool_idx, aging_threshold(AGING_EXPONENTIAL));
+  s3fifo_insert(&g_table->evictor, pool_idx, ip);
+  g_table->flow_scores[pool_idx] = 0.0f;
 
-  // Add to hash table
-  uint32_t bucket = fast_hash(ip) & (HASH_TABLE_SIZE - 1);
-  new_flow->next = g_table->hash_table->buckets[bucket];
-  g_table->hash_table->buckets[bucket] = new_flow;
+  // Add to the direct index, or the hash table for unbounded keys
+  if (ip < g_table->direct_range) {
+    g_table->direct_index[ip] = pool_idx;
+    g_table->direct_bitmap[ip >> 6] |= 1ULL << (ip & 63);
+  } else {
+    uint32_t bucket = fast_hash(ip) & (HASH_TABLE_SIZE - 1);
+    new_flow->next = g_table->hash_table->buckets[bucket];
+    g_table->hash_table->buckets[bucket] = new_flow;
+  }
   g_table->hash_table->total_entries++;
 
   return new_flow;
 }
 
+// Create a flow for an unknown key, subject to admission. Below the target
+// utilization every key gets a slot. Above it a key must have been seen
+// recently: evicted from probation, or turned away once before (the ghost
+// filter doubles as a doorkeeper). One-packet keys under churn then never
+// displace a flow. A full pool recycles the eviction policy's victim.
+static inline FlowEntry *admit_flow(uint32_t ip) {
+  if (g_table->live_flows >=
+      (int)(g_params.evict_target * g_table->pool_size)) {
+    if (!s3fifo_ghost_contains(&g_table->evictor, ip)) {
+      s3fifo_ghost_insert(&g_table->evictor, ip);
+      g_table->aging_manager->admissions_deferred++;
+      return NULL;
+    }
+    if (g_table->free_count == 0 &&
+        g_table->pool_index >= g_table->pool_size && !evict_flow()) {
+      return NULL;
+    }
+  }
+  return create_flow_fast(ip);
+}
+
 // Processing functions
 static inline void ultra_fast_process(uint32_t ip) {
   volatile uint32_t r = ip;
@@ -671,7 +1908,10 @@ static inline void accelerated_process(uint32_t ip) {
   (void)c;
 }
 
-static inline void slow_process(uint32_t ip) {
+// Calibrated slow-path workload; NULL runs the legacy loop below
+static SlowPathWorkload *g_slow_path;
+
+static inline void legacy_slow_process(uint32_t ip) {
   volatile int c = 0;
   uint32_t limit = (uint32_t)sqrt(ip);
   for (uint32_t i = 1; i <= limit; i++) {
@@ -681,45 +1921,299 @@ static inline void slow_process(uint32_t ip) {
   (void)c;
 }
 
-// Improved burst promotion
-static inline void maybe_promote_burst(FlowEntry *flow) {
+// Returns the inspection's alerts (signature matches, dfa workload only)
+static inline uint32_t slow_process(uint32_t ip) {
+  if (g_slow_path) {
+    return slow_path_run(g_slow_path, ip);
+  }
+  legacy_slow_process(ip);
+  return 0;
+}
+
+// Alerts mark the flow suspected and halve its confidence
+static inline void apply_inspection_verdict(FlowEntry *flow, uint32_t alerts) {
+  if (alerts == 0) {
+    return;
+  }
+  g_inspect.alerts++;
+  if (flow->flow_type != SUSPECTED_FLOW) {
+    flow->previous_type = flow->flow_type;
+    flow->flow_type = SUSPECTED_FLOW;
+  }
+  flow->confidence /= 2;
+}
+
+static void *offload_worker_main(void *arg) {
+  OffloadWorker *worker = arg;
+  SpscMessage message;
+  int idle = 0;
+  for (;;) {
+    if (spsc_pop(&worker->requests, &message)) {
+      if (worker->workload.kind != SLOW_PATH_LEGACY) {
+        message.result = slow_path_run(&worker->workload, message.ip);
+      } else {
+        legacy_slow_process(message.ip);
+        message.result = 0;
+      }
+      while (spsc_push(&worker->completions, &message) != 0) {
+        sched_yield();
+      }
+      __atomic_fetch_add(&worker->inspections, 1, __ATOMIC_RELAXED);
+      idle = 0;
+    } else if (__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE)) {
+      return NULL;
+    } else if (++idle > OFFLOAD_IDLE_SPINS) {
+      sched_yield();
+    }
+  }
+}
+
+// Queue an inspection for a packet of flow (NULL: a packet without flow
+// state). Returns 0 when the worker's queue is full and the caller has to
+// run it inline.
+static inline int offload_submit(FlowEntry *flow, uint32_t ip) {
+  uint32_t w = (uint32_t)(((uint64_t)fast_hash(ip) * g_inspect.worker_count) >>
+                          32);
+  SpscMessage message;
+  message.enqueued_ns = monotonic_ns();
+  message.ip = ip;
+  message.flow = flow ? (int32_t)(flow - g_table->flow_pool) : -1;
+  message.result = 0;
+  if (spsc_push(&g_inspect.workers[w].requests, &message) != 0) {
+    g_inspect.queue_full++;
+    return 0;
+  }
+  if (flow) {
+    flow->inspect_pending = 1;
+  }
+  g_inspect.queued++;
+  g_inspect.outstanding++;
+  return 1;
+}
+
+// Apply every verdict that has come back: release held packets and feed the
+// alerts into the flow. A slot recycled since the request was queued (other
+// key, or nothing pending) makes the verdict stale.
+static inline void offload_poll() {
+  uint64_t now = monotonic_ns();
+  SpscMessage message;
+  for (int w = 0; w < g_inspect.worker_count; w++) {
+    while (spsc_pop(&g_inspect.workers[w].completions, &message)) {
+      g_inspect.outstanding--;
+      g_inspect.completed++;
+      latency_histogram_record(&g_inspect.turnaround,
+                               now - message.enqueued_ns);
+      if (message.flow < 0) {
+        g_inspect.alerts += message.result != 0; // No flow to feed back into
+        continue;
+      }
+      FlowEntry *flow = &g_table->flow_pool[message.flow];
+      if (flow->ip != message.ip || !flow->inspect_pending) {
+        g_inspect.stale++;
+        continue;
+      }
+      flow->inspect_pending = 0;
+      for (uint32_t i = 0; i < flow->inspect_held; i++) {
+        fast_process(message.ip);
+      }
+      g_inspect.released += flow->inspect_held;
+      flow->inspect_held = 0;
+      apply_inspection_verdict(flow, message.result);
+    }
+  }
+}
+
+// Wait for and apply every outstanding verdict
+static void offload_flush() {
+  while (g_inspect.outstanding > 0) {
+    offload_poll();
+    if (g_inspect.outstanding > 0) {
+      sched_yield();
+    }
+  }
+}
+
+static void offload_stop() {
+  offload_flush();
+  for (int i = 0; i < g_inspect.worker_count; i++) {
+    OffloadWorker *worker = &g_inspect.workers[i];
+    __atomic_store_n(&worker->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(worker->thread, NULL);
+    spsc_free(&worker->requests);
+    spsc_free(&worker->completions);
+  }
+  g_inspect.worker_count = 0;
+}
+
+// Start worker_count inspection threads, each with a copy of workload (NULL
+// for the legacy loops). Returns 0, or -1 with a message on stderr.
+static int offload_start(int worker_count, OffloadPolicy policy,
+                         const SlowPathWorkload *workload) {
+  memset(&g_inspect, 0, sizeof(g_inspect));
+  g_inspect.policy = policy;
+  g_inspect.fast_countdown = FAST_LATENCY_SAMPLE;
+  if (worker_count <= 0) {
+    return 0;
+  }
+  if (worker_count > OFFLOAD_MAX_WORKERS) {
+    fprintf(stderr, "At most %d offload workers\n", OFFLOAD_MAX_WORKERS);
+    return -1;
+  }
+  for (int i = 0; i < worker_count; i++) {
+    OffloadWorker *worker = &g_inspect.workers[i];
+    if (workload) {
+      worker->workload = *workload;
+      worker->workload.matches = 0;
+    }
+    if (spsc_init(&worker->requests, OFFLOAD_QUEUE_SIZE) != 0 ||
+        spsc_init(&worker->completions, OFFLOAD_QUEUE_SIZE) != 0 ||
+        pthread_create(&worker->thread, NULL, offload_worker_main, worker) !=
+            0) {
+      fprintf(stderr, "Failed to start offload worker %d\n", i);
+      spsc_free(&worker->requests);
+      spsc_free(&worker->completions);
+      offload_stop();
+      return -1;
+    }
+    g_inspect.worker_count++;
+  }
+  return 0;
+}
+
+// Slow-path inspection of a packet: queued to a worker when offloading,
+// inline otherwise. flow is NULL for packets routed without flow state.
+// Returns the alerts of an inline inspection of a flow, for the caller to
+// apply once the packet has updated the flow, as a worker's verdict would.
+PIPELINE_INLINE uint32_t inspect_packet(uint32_t ip, FlowEntry *flow) {
+  if (g_inspect.worker_count > 0 && offload_submit(flow, ip)) {
+    return 0;
+  }
+  uint32_t alerts = slow_process(ip);
+  if (!flow) {
+    g_inspect.alerts += alerts != 0;
+    return 0;
+  }
+  return alerts;
+}
+
+// A hit on a flow whose inspection is outstanding
+PIPELINE_INLINE void offload_pending_packet(FlowEntry *flow, uint32_t ip) {
+  if (g_inspect.policy == OFFLOAD_HOLD) {
+    flow->inspect_held++;
+    g_inspect.held++;
+    if (flow->inspect_held == UINT16_MAX) {
+      offload_flush(); // Verdict needed before the count wraps
+    }
+  } else {
+    fast_process(ip);
+    g_inspect.provisional++;
+  }
+}
+
+// Sample fast-path latency after a packet that took a fast path
+PIPELINE_INLINE void sample_fast_latency() {
+  if (g_inspect.fast_mark_ns != 0) {
+    uint64_t now = monotonic_ns();
+    latency_histogram_record(&g_inspect.fast_latency,
+                             now - g_inspect.fast_mark_ns);
+    g_inspect.fast_mark_ns = 0;
+  } else if (--g_inspect.fast_countdown == 0) {
+    g_inspect.fast_countdown = FAST_LATENCY_SAMPLE;
+    g_inspect.fast_mark_ns = monotonic_ns();
+  }
+}
+
+// Burst promotion: a hit on a flow whose own rate is bursting, or any hit
+// while new-flow arrivals surge, fast-tracks a flow the model already likes
+PIPELINE_INLINE void maybe_promote_burst(FlowEntry *flow,
+                                         const unsigned features) {
   if (!flow)
     return;
 
-  if (detect_burst_enhanced()) {
-    double ml_score = enhanced_ml_predict(flow);
+  AgingManager *manager = g_table->aging_manager;
+  if (g_table->packet_time >= manager->burst_tick_end) {
+    burst_advance_ticks();
+  }
+  int flow_burst = flow_burst_update(flow);
+  manager->flow_burst_hits += flow_burst;
+
+  // Only flows with a fast streak still below ultra-fast can be promoted;
+  // test that before paying for a model score
+  if ((flow_burst || manager->arrival_surge) &&
+      pattern_fast_streak(&flow->pattern) >= 2 &&
+      flow->confidence < g_params.confidence_ultra_fast) {
+    double ml_score = flow_score(flow, features);
 
     // Promote based on ML score and current performance
-    if (ml_score > 0.75 && flow->pattern.consecutive_fast_paths >= 3) {
-      if (flow->confidence < CONFIDENCE_ULTRA_FAST) {
-        flow->confidence = CONFIDENCE_ULTRA_FAST;
+    if (ml_score > 0.75 && pattern_fast_streak(&flow->pattern) >= 3) {
+      if (flow->confidence < g_params.confidence_ultra_fast) {
+        flow->confidence = (uint16_t)g_params.confidence_ultra_fast;
         flow->previous_type = flow->flow_type;
         flow->flow_type = PROMOTED_FLOW;
-        flow->pattern.recent_promotions++;
-        g_table->aging_manager->flows_promoted++;
-        g_table->ultra_fast_promotions++;
+        manager->flows_promoted++;
+        manager->burst_promotions++;
+        PSTAT_FULL(features, ultra_fast_promotions);
       }
-    } else if (ml_score > 0.55 && flow->pattern.consecutive_fast_paths >= 2) {
-      if (flow->confidence < CONFIDENCE_FAST_TRACK) {
-        flow->confidence = CONFIDENCE_FAST_TRACK;
+    } else if (ml_score > 0.55 && pattern_fast_streak(&flow->pattern) >= 2) {
+      if (flow->confidence < g_params.confidence_fast_track) {
+        flow->confidence = (uint16_t)g_params.confidence_fast_track;
         flow->flow_type = BURSTY_FLOW;
+        manager->burst_promotions++;
       }
     }
   }
 }
 
 // Enhanced path selection
-static inline ProcessingPath select_path_enhanced(uint32_t ip,
-                                                  FlowEntry *flow) {
+// Path for an established flow with the given model score (no side effects)
+static inline ProcessingPath path_for_score(const FlowEntry *flow,
+                                            double ml_prediction) {
+  // Consider both confidence and ML prediction
+  if (flow->confidence >= g_params.confidence_ultra_fast &&
+      ml_prediction > 0.7) {
+    return ULTRA_FAST_PATH;
+  } else if (flow->confidence >= g_params.confidence_fast_track &&
+             ml_prediction > 0.5) {
+    return FAST_PATH;
+  } else if (ml_prediction > 0.6 || pattern_fast_streak(&flow->pattern) >= 3) {
+    return ADAPTIVE_PATH;
+  }
+  return ACCELERATED_PATH;
+}
+
+// Score a sampled established flow with both models and record what each
+// would have routed it to
+static inline void shadow_observe(FlowEntry *flow) {
+  ShadowEval *shadow = g_table->shadow;
+  if (--shadow->countdown > 0) {
+    return;
+  }
+  shadow->countdown = shadow->sample_interval;
+
+  double live = ml_predict_raw(flow);
+  double candidate = model_predict(&shadow->model, flow);
+  ProcessingPath live_path = path_for_score(flow, live);
+  ProcessingPath shadow_path = path_for_score(flow, candidate);
+
+  shadow->samples++;
+  shadow->path_agreements += live_path == shadow_path;
+  shadow->score_diff_sum += fabs(live - candidate);
+  shadow->live_paths[live_path]++;
+  shadow->shadow_paths[shadow_path]++;
+}
+
+PIPELINE_INLINE ProcessingPath select_path_enhanced(uint32_t ip,
+                                                    FlowEntry *flow,
+                                                    const unsigned features) {
   // Check prediction cache first for established flows
-  if (flow && flow->hits > 2) {
-    double cached_prediction = check_prediction_cache(ip);
+  if ((features & PIPE_ML) && flow && flow->hits > 2) {
+    double cached_prediction = check_prediction_cache(ip, features);
     if (cached_prediction >= 0.0) {
-      if (cached_prediction > 0.8)
+      if (cached_prediction > g_params.cached_ultra_fast)
         return ULTRA_FAST_PATH;
-      if (cached_prediction > 0.6)
+      if (cached_prediction > g_params.cached_fast)
         return FAST_PATH;
-      if (cached_prediction > 0.4)
+      if (cached_prediction > g_params.cached_accelerated)
         return ACCELERATED_PATH;
       return ADAPTIVE_PATH;
     }
@@ -727,6 +2221,8 @@ static inline ProcessingPath select_path_enhanced(uint32_t ip,
 
   // New flow handling
   if (!flow) {
+    if (!(features & PIPE_SKETCH))
+      return SLOW_PATH;
     uint32_t sketch_count = sketch_query_fast(g_table->sketch, ip);
     return (sketch_count > 8 ? ACCELERATED_PATH : SLOW_PATH);
   }
@@ -737,71 +2233,22 @@ static inline ProcessingPath select_path_enhanced(uint32_t ip,
   }
 
   // ML-driven selection for established flows
-  double ml_prediction = enhanced_ml_predict(flow);
-  ProcessingPath selected_path;
-
-  // Consider both confidence and ML prediction
-  if (flow->confidence >= CONFIDENCE_ULTRA_FAST && ml_prediction > 0.7) {
-    selected_path = ULTRA_FAST_PATH;
-  } else if (flow->confidence >= CONFIDENCE_FAST_TRACK && ml_prediction > 0.5) {
-    selected_path = FAST_PATH;
-  } else if (ml_prediction > 0.6 || flow->pattern.consecutive_fast_paths >= 3) {
-    selected_path = ADAPTIVE_PATH;
-  } else {
-    selected_path = ACCELERATED_PATH;
-  }
+  double ml_prediction = flow_score(flow, features);
+  ProcessingPath selected_path = path_for_score(flow, ml_prediction);
 
   // Cache the prediction for future use
-  if (flow->hits > 2) {
+  if ((features & PIPE_ML) && flow->hits > 2) {
     update_prediction_cache(ip, ml_prediction, selected_path);
   }
 
   return selected_path;
 }
 
-// Validation for ML performance
-static inline void validate_ml_prediction(FlowEntry *flow,
-                                          ProcessingPath actual_path) {
-  if (!flow || flow->hits < 5)
-    return; // Only validate established flows
-
-  double prediction = enhanced_ml_predict(flow);
-
-  // Determine if the prediction was "correct" based on actual path taken
-  int predicted_fast = (prediction > 0.6);
-  int actual_fast = (actual_path <= FAST_PATH);
-
-  g_table->ml_model->validation_samples++;
-  if (predicted_fast == actual_fast) {
-    g_table->ml_model->validation_correct++;
-  }
-}
-
-// Main packet processing
-static inline void process_packet_optimized(uint32_t ip) {
-  // Update sketch
-  sketch_update_fast(g_table->sketch, ip);
-
-  // Lookup or create flow
-  FlowEntry *flow = find_flow_fast(ip);
-  if (!flow) {
-    flow = create_flow_fast(ip);
-    if (flow) {
-      accelerated_process(ip);
-      g_table->path_counts[ACCELERATED_PATH]++;
-      update_flow_pattern(flow, ACCELERATED_PATH);
-    }
-    goto update_stats;
-  }
-
-  // Burst promotion
-  maybe_promote_burst(flow);
-
-  // Path selection
-  ProcessingPath path = select_path_enhanced(ip, flow);
-  g_table->path_counts[path]++;
-
-  // Execute processing
+// Execute the selected processing path. Returns inline inspection alerts
+// (see inspect_packet).
+PIPELINE_INLINE uint32_t execute_path(uint32_t ip, FlowEntry *flow,
+                                      ProcessingPath path,
+                                      const unsigned features) {
   switch (path) {
   case ULTRA_FAST_PATH:
     ultra_fast_process(ip);
@@ -813,36 +2260,110 @@ static inline void process_packet_optimized(uint32_t ip) {
     accelerated_process(ip);
     break;
   case SLOW_PATH:
-    slow_process(ip);
-    break;
+    return inspect_packet(ip, flow);
   case ADAPTIVE_PATH:
-    if (enhanced_ml_predict(flow) > 0.75) {
+    if (flow_score(flow, features) > 0.75) {
       fast_process(ip);
     } else {
       accelerated_process(ip);
     }
     break;
   case DEEP_ANALYSIS_PATH:
-    slow_process(ip);
-    break;
+    return inspect_packet(ip, flow);
+  }
+  return 0;
+}
+
+// Main packet processing, specialised per pipeline variant
+PIPELINE_INLINE void process_packet_pipeline(uint32_t ip,
+                                             const unsigned features) {
+  ProcessingPath path = ACCELERATED_PATH;
+  uint32_t alerts = 0;
+
+  // Update sketch
+  if (features & PIPE_SKETCH) {
+    sketch_update_fast(g_table->sketch, ip);
+  }
+
+  // Lookup or create flow
+  FlowEntry *flow = find_flow_fast(ip, features);
+  if (!flow) {
+    burst_note_arrival(features);
+    flow = (features & PIPE_MAINT) ? admit_flow(ip) : create_flow_fast(ip);
+    if (flow) {
+      // An unknown flow's first packet is inspected; with workers, its
+      // next packets are held or passed until the verdict comes back
+      path = SLOW_PATH;
+      alerts = inspect_packet(ip, flow);
+      if (features & PIPE_PATTERN) {
+        update_flow_pattern(flow, path, features);
+      }
+    } else {
+      // Pool exhausted: route on sketch frequency alone, no flow state
+      path = select_path_enhanced(ip, NULL, features);
+      execute_path(ip, NULL, path, features);
+    }
+    PSTAT_BASIC(features, path_counts[path]);
+    goto update_stats;
+  }
+
+  // Hits on an existing flow count toward keeping it (saturating)
+  flow->evict_freq += flow->evict_freq < 3;
+
+  // Inspection still with a worker: hold the packet or pass it provisionally
+  if (flow->inspect_pending) {
+    offload_pending_packet(flow, ip);
+    path = FAST_PATH;
+    PSTAT_BASIC(features, path_counts[path]);
+    if ((features & PIPE_STATS) && g_inspect.policy == OFFLOAD_PASS) {
+      sample_fast_latency();
+    }
+    goto update_stats;
+  }
+
+  // Burst promotion
+  if (features & PIPE_BURST) {
+    maybe_promote_burst(flow, features);
+  }
+
+  // Path selection
+  path = select_path_enhanced(ip, flow, features);
+  PSTAT_BASIC(features, path_counts[path]);
+  if ((features & PIPE_ML) && g_table->shadow && flow->hits > 1) {
+    shadow_observe(flow);
+  }
+
+  // Execute processing
+  alerts = execute_path(ip, flow, path, features);
+  if ((features & PIPE_STATS) &&
+      (path == FAST_PATH || path == ULTRA_FAST_PATH)) {
+    sample_fast_latency();
   }
 
-  // Update flow pattern and validate ML
-  update_flow_pattern(flow, path);
-  validate_ml_prediction(flow, path);
+  // Update flow pattern and sample for delayed-label training
+  if (features & PIPE_PATTERN) {
+    update_flow_pattern(flow, path, features);
+  }
+  if ((features & PIPE_VALIDATE) && (features & PIPE_ML)) {
+    record_training_sample(flow);
+  }
 
 update_stats:
   // Update flow statistics
   if (flow) {
     flow->hits++;
     flow->packet_count++;
-    flow->last_seen = time(NULL);
+    flow->last_seen = g_table->packet_time;
+    flow->last_packet = (uint32_t)g_table->total_processed;
     flow->aging.last_access_time = flow->last_seen;
     flow->aging.total_accesses++;
+    if ((features & PIPE_MAINT) && flow->aging.idle_periods != 0) {
+      revive_idle_flow(flow);
+    }
 
     // Smart confidence updates
     if (flow->hits % 4 == 0 && flow->confidence < 100) {
-      double ml_score = enhanced_ml_predict(flow);
+      double ml_score = flow_score(flow, features);
       int base_boost = 4;
       int ml_boost = (int)(ml_score * 6.0); // 0-6 additional boost
       int total_boost = base_boost + ml_boost;
@@ -850,274 +2371,1432 @@ update_stats:
       flow->confidence = (flow->confidence + total_boost > 100)
                              ? 100
                              : flow->confidence + total_boost;
-      g_table->confidence_updates++;
+      PSTAT_FULL(features, confidence_updates);
     }
 
-    // Enhanced flow type classification
-    if (flow->packet_count > 800 && flow->flow_type != LARGE_FLOW) {
-      flow->previous_type = flow->flow_type;
-      flow->flow_type = LARGE_FLOW;
-      flow->aging.aging_strategy = AGING_ADAPTIVE;
-    } else if (flow->pattern.burst_score > 0.6 && flow->hits > 10) {
-      if (flow->flow_type != BURSTY_FLOW && flow->flow_type != PROMOTED_FLOW) {
+    if (features & PIPE_CLASSIFY) {
+      // Enhanced flow type classification
+      if (flow->packet_count > 800 && flow->flow_type != LARGE_FLOW) {
         flow->previous_type = flow->flow_type;
-        flow->flow_type = BURSTY_FLOW;
-        flow->aging.aging_strategy = AGING_LINEAR;
+        flow->flow_type = LARGE_FLOW;
+        flow->aging.aging_strategy = AGING_ADAPTIVE;
+      } else if (pattern_burst_score(&flow->pattern) > 0.6 && flow->hits > 10) {
+        if (flow->flow_type != BURSTY_FLOW &&
+            flow->flow_type != PROMOTED_FLOW) {
+          flow->previous_type = flow->flow_type;
+          flow->flow_type = BURSTY_FLOW;
+          flow->aging.aging_strategy = AGING_LINEAR;
+        }
+      } else if (flow->packet_count < 10 && flow->hits < 5) {
+        flow->flow_type = MICRO_FLOW;
+        flow->aging.aging_strategy = AGING_AGGRESSIVE;
+      }
+
+      // Anomaly detection - simplified
+      if (pattern_filled(&flow->pattern) &&
+          pattern_consistency(&flow->pattern) < 0.3) {
+        if (flow->flow_type != SUSPECTED_FLOW && flow->hits > 8) {
+          flow->previous_type = flow->flow_type;
+          flow->flow_type = SUSPECTED_FLOW;
+        }
       }
-    } else if (flow->packet_count < 10 && flow->hits < 5) {
-      flow->flow_type = MICRO_FLOW;
-      flow->aging.aging_strategy = AGING_AGGRESSIVE;
     }
 
-    // Anomaly detection - simplified
-    if (flow->pattern.history_filled && flow->pattern.path_consistency < 0.3) {
-      if (flow->flow_type != SUSPECTED_FLOW && flow->hits > 8) {
-        flow->previous_type = flow->flow_type;
-        flow->flow_type = SUSPECTED_FLOW;
+    // Promotion score updates (also the score proxy without ML)
+    if (path <= FAST_PATH) {
+      flow->promotion_score =
+          (flow->promotion_score < 950) ? flow->promotion_score + 10 : 1000;
+    } else if (path >= SLOW_PATH) {
+      flow->promotion_score =
+          (flow->promotion_score > 50) ? flow->promotion_score - 5 : 0;
+    }
+    apply_inspection_verdict(flow, alerts);
+  }
+
+  if ((features & PIPE_VALIDATE) && (features & PIPE_ML) && g_table->trainer &&
+      (g_table->total_processed & (ONLINE_SAMPLE_INTERVAL - 1)) == 0) {
+    label_training_samples();
+  }
+  g_table->total_processed++;
+  if (g_inspect.worker_count > 0 &&
+      (g_table->total_processed & OFFLOAD_POLL_MASK) == 0) {
+    offload_poll();
+  }
+
+  // Incremental maintenance
+  if ((features & PIPE_MAINT) &&
+      (g_table->total_processed & g_params.maint_mask) == 0) {
+    run_maintenance_slice((features & PIPE_ML) != 0);
+  }
+}
+
+// Packet time of the next packet: its timestamp, or its index at the nominal
+// one packet per microsecond when the trace has none
+static inline void advance_packet_time(const uint64_t *times, int i) {
+  g_table->packet_time = times ? times[i] : g_table->total_processed;
+}
+
+static inline void process_packet_optimized(uint32_t ip) {
+  process_packet_pipeline(ip, PIPELINE_FULL);
+}
+
+// Pipeline variants: each is a separately compiled copy of the packet loop
+typedef struct {
+  const char *name;
+  unsigned features;
+  void (*run)(const int *packets, const uint64_t *times, int count);
+  const char *description;
+} PipelineVariant;
+
+#define DEFINE_PIPELINE_VARIANT(fn_name, feature_set)                          \
+  static void fn_name(const int *packets, const uint64_t *times, int count) {  \
+    for (int i = 0; i < count; i++) {                                          \
+      advance_packet_time(times, i);                                           \
+      process_packet_pipeline((uint32_t)packets[i], (feature_set));            \
+    }                                                                          \
+  }
+
+#define PIPELINE_NO_ML (PIPELINE_FULL & ~(PIPE_ML | PIPE_VALIDATE))
+#define PIPELINE_NO_SKETCH (PIPELINE_FULL & ~PIPE_SKETCH)
+#define PIPELINE_STATS_OFF (PIPELINE_FULL & ~PIPE_STATS)
+#define PIPELINE_LEAN (PIPE_PATTERN | PIPE_CLASSIFY | PIPE_MAINT)
+
+DEFINE_PIPELINE_VARIANT(run_pipeline_full, PIPELINE_FULL)
+DEFINE_PIPELINE_VARIANT(run_pipeline_no_ml, PIPELINE_NO_ML)
+DEFINE_PIPELINE_VARIANT(run_pipeline_no_sketch, PIPELINE_NO_SKETCH)
+DEFINE_PIPELINE_VARIANT(run_pipeline_stats_off, PIPELINE_STATS_OFF)
+DEFINE_PIPELINE_VARIANT(run_pipeline_lean, PIPELINE_LEAN)
+
+static const PipelineVariant pipeline_variants[] = {
+    {"full", PIPELINE_FULL, run_pipeline_full, "every stage (default)"},
+    {"no-ml", PIPELINE_NO_ML, run_pipeline_no_ml,
+     "promotion-score proxy instead of ML scoring, no validation"},
+    {"no-sketch", PIPELINE_NO_SKETCH, run_pipeline_no_sketch,
+     "no count-min sketch; unknown flows on a full pool go slow"},
+    {"stats-off", PIPELINE_STATS_OFF, run_pipeline_stats_off,
+     "no per-packet counters"},
+    {"lean", PIPELINE_LEAN, run_pipeline_lean,
+     "no ML, sketch, burst detection or counters"}};
+
+#define NUM_PIPELINE_VARIANTS                                                  \
+  (int)(sizeof(pipeline_variants) / sizeof(pipeline_variants[0]))
+
+static const PipelineVariant *find_pipeline_variant(const char *name) {
+  for (int i = 0; i < NUM_PIPELINE_VARIANTS; i++) {
+    if (strcmp(pipeline_variants[i].name, name) == 0) {
+      return &pipeline_variants[i];
+    }
+  }
+  return NULL;
+}
+
+// Maintenance scheduler: work done, its throughput and the latency each
+// slice adds to the packet that triggers it
+static inline void print_maintenance_report() {
+  MaintenanceScheduler *maint = g_table->maint;
+  const LatencyHistogram *latency = &maint->latency;
+  uint64_t entries = maint->lifecycle_entries + maint->training_entries +
+                     maint->evict_entries + maint->expiry_entries +
+                     maint->cascade_entries;
+  double seconds = latency->total * 1e-9;
+  char budget[32];
+  if (g_params.maint_budget > 0) {
+    snprintf(budget, sizeof(budget), "%d entries", g_params.maint_budget);
+  } else {
+    snprintf(budget, sizeof(budget), "unbounded");
+  }
+
+  printf("  Maintenance: %llu slices every %d packets, budget %s "
+         "(%.1f%% saturated)\n",
+         (unsigned long long)maint->slices, g_params.maint_interval, budget,
+         maint->slices > 0 ? 100.0 * maint->saturated_slices / maint->slices
+                           : 0.0);
+  printf("  Maintenance Work: %llu lifecycle, %llu training, %llu eviction, "
+         "%llu expiry, %llu cascade entries (%.1f M entries/s, %.1f "
+         "ns/packet)\n",
+         (unsigned long long)maint->lifecycle_entries,
+         (unsigned long long)maint->training_entries,
+         (unsigned long long)maint->evict_entries,
+         (unsigned long long)maint->expiry_entries,
+         (unsigned long long)maint->cascade_entries,
+         seconds > 0 ? entries / seconds / 1e6 : 0.0,
+         g_table->total_processed > 0
+             ? (double)latency->total / g_table->total_processed
+             : 0.0);
+  printf("  Maintenance Latency: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, "
+         "max %llu ns per slice\n",
+         (unsigned long long)latency_histogram_percentile(latency, 0.50),
+         (unsigned long long)latency_histogram_percentile(latency, 0.99),
+         (unsigned long long)latency_histogram_percentile(latency, 0.999),
+         (unsigned long long)latency->max);
+  printf("  Lifecycle Passes: %llu (%.0f packets per pass)\n",
+         (unsigned long long)maint->lifecycle_passes,
+         maint->lifecycle_passes > 0
+             ? (double)maint->lifecycle_pass_packets / maint->lifecycle_passes
+             : 0.0);
+}
+
+// Eviction: victims by queue and flow type, and how the policy spent visits
+static inline void print_eviction_report() {
+  AgingManager *manager = g_table->aging_manager;
+  const S3Fifo *evictor = &g_table->evictor;
+  printf("  Flows Evicted: %llu (%llu small, %llu main, %llu gave up), target "
+         "%.0f%% of pool\n",
+         (unsigned long long)manager->flows_evicted,
+         (unsigned long long)evictor->evicted_small,
+         (unsigned long long)evictor->evicted_main,
+         (unsigned long long)evictor->gave_up, g_params.evict_target * 100.0);
+  if (manager->flows_evicted == 0) {
+    return;
+  }
+  printf("  Eviction Queues: %llu promoted to main, %llu kept in main, %llu "
+         "ghost hits, %llu admissions deferred\n",
+         (unsigned long long)evictor->promoted,
+         (unsigned long long)evictor->reinserted,
+         (unsigned long long)evictor->ghost_hits,
+         (unsigned long long)manager->admissions_deferred);
+  printf("  Evicted by Type: normal %llu, large %llu, bursty %llu, micro %llu, "
+         "dying %llu, promoted %llu, suspected %llu\n",
+         (unsigned long long)manager->evicted_by_type[NORMAL_FLOW],
+         (unsigned long long)manager->evicted_by_type[LARGE_FLOW],
+         (unsigned long long)manager->evicted_by_type[BURSTY_FLOW],
+         (unsigned long long)manager->evicted_by_type[MICRO_FLOW],
+         (unsigned long long)manager->evicted_by_type[DYING_FLOW],
+         (unsigned long long)manager->evicted_by_type[PROMOTED_FLOW],
+         (unsigned long long)manager->evicted_by_type[SUSPECTED_FLOW]);
+}
+
+// Slow-path inspection: throughput by CPU and wall-clock time (they part
+// once worker threads add CPU time of their own), fast-path latency, and
+// the offload queues and pending flows
+static inline void print_inspection_report(double cpu_seconds,
+                                           double wall_seconds) {
+  const LatencyHistogram *fast = &g_inspect.fast_latency;
+  if (g_inspect.worker_count > 0) {
+    printf("\nSlow-Path Inspection: offloaded to %d threads, pending flows "
+           "%s\n",
+           g_inspect.worker_count,
+           g_inspect.policy == OFFLOAD_PASS ? "pass" : "hold");
+  } else {
+    printf("\nSlow-Path Inspection: inline\n");
+  }
+  printf("  Packet Rate: %.2f Mpps by CPU time (all threads), %.2f Mpps by "
+         "wall clock (%.3f s)\n",
+         cpu_seconds > 0 ? g_table->total_processed / cpu_seconds / 1e6 : 0.0,
+         wall_seconds > 0 ? g_table->total_processed / wall_seconds / 1e6
+                          : 0.0,
+         wall_seconds);
+  printf("  Fast-Path Latency: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max "
+         "%llu ns (%llu samples, 1 in %d fast packets)\n",
+         (unsigned long long)latency_histogram_percentile(fast, 0.50),
+         (unsigned long long)latency_histogram_percentile(fast, 0.99),
+         (unsigned long long)latency_histogram_percentile(fast, 0.999),
+         (unsigned long long)fast->max, (unsigned long long)fast->samples,
+         FAST_LATENCY_SAMPLE);
+  printf("  Alerts: %llu inspections raised alerts\n",
+         (unsigned long long)g_inspect.alerts);
+  if (g_inspect.worker_count == 0) {
+    return;
+  }
+
+  const LatencyHistogram *turnaround = &g_inspect.turnaround;
+  printf("  Offloaded: %llu queued, %llu completed (%llu stale), %llu run "
+         "inline on a full queue\n",
+         (unsigned long long)g_inspect.queued,
+         (unsigned long long)g_inspect.completed,
+         (unsigned long long)g_inspect.stale,
+         (unsigned long long)g_inspect.queue_full);
+  printf("  Verdict Turnaround: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max "
+         "%llu ns\n",
+         (unsigned long long)latency_histogram_percentile(turnaround, 0.50),
+         (unsigned long long)latency_histogram_percentile(turnaround, 0.99),
+         (unsigned long long)latency_histogram_percentile(turnaround, 0.999),
+         (unsigned long long)turnaround->max);
+  printf("  Pending Flows: %llu packets held (%llu released, %llu dropped "
+         "with their flow), %llu passed provisionally\n",
+         (unsigned long long)g_inspect.held,
+         (unsigned long long)g_inspect.released,
+         (unsigned long long)g_inspect.held_dropped,
+         (unsigned long long)g_inspect.provisional);
+  printf("  Inspections per Thread:");
+  for (int i = 0; i < g_inspect.worker_count; i++) {
+    printf(" %llu", (unsigned long long)__atomic_load_n(
+                        &g_inspect.workers[i].inspections, __ATOMIC_RELAXED));
+  }
+  printf("\n");
+}
+
+// Enhanced statistics reporting
+static inline void print_enhanced_statistics() {
+  printf("\n=== ENHANCED ML & AGING STATISTICS ===\n");
+
+  EngineStats stats;
+  stats_snapshot(&stats);
+
+  // ML Statistics
+  MLModel *model = g_table->ml_model;
+  double validation_accuracy = 0.0;
+  if (model->validation_samples > 0) {
+    validation_accuracy =
+        (double)model->validation_correct / model->validation_samples;
+  }
+
+  printf("ML Model Performance:\n");
+  OnlineTrainer *trainer = g_table->trainer;
+  if (trainer && trainer->samples_trained > 0) {
+    // Whole run, against delayed recurrence labels
+    printf("  Validation Accuracy: %.1f%% (%llu correct / %llu samples, "
+           "labels: recurred within %d packets)\n",
+           100.0 * trainer->labelled_correct / trainer->samples_trained,
+           (unsigned long long)trainer->labelled_correct,
+           (unsigned long long)trainer->samples_trained, ONLINE_LABEL_HORIZON);
+    printf("  Online Training: %llu samples in %llu batches, %.1f%% positive, "
+           "%llu dropped\n",
+           (unsigned long long)trainer->samples_trained,
+           (unsigned long long)trainer->training_batches,
+           100.0 * trainer->positive_labels / trainer->samples_trained,
+           (unsigned long long)trainer->samples_dropped);
+    printf("  Weights:");
+    for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+      printf(" %.3f", model->weights[i]);
+    }
+    printf(" | bias %.3f\n", model->bias);
+  } else {
+    printf("  Validation Accuracy: %.1f%% (%u correct / %u samples)\n",
+           validation_accuracy * 100.0, model->validation_correct,
+           model->validation_samples);
+  }
+  printf("  Learning Rate: %.6f\n", model->learning_rate);
+#if STATS_LEVEL >= STATS_FULL
+  printf("  Packet-Path ML Predictions: %llu\n",
+         (unsigned long long)stats.ml_predictions);
+  printf("  Prediction Cache Hit Rate: %.1f%% (%llu / %llu lookups)\n",
+         stats.ml_cache_lookups > 0
+             ? 100.0 * stats.ml_cache_hits / stats.ml_cache_lookups
+             : 0.0,
+         (unsigned long long)stats.ml_cache_hits,
+         (unsigned long long)stats.ml_cache_lookups);
+#endif
+
+  // Aging Statistics
+  AgingManager *manager = g_table->aging_manager;
+  printf("\nAging & Lifecycle Management:\n");
+  printf("  Memory Utilization: %.1f%% (%d / %d flows)\n",
+         manager->memory_utilization * 100.0, g_table->live_flows,
+         g_table->pool_size);
+  printf("  Aging Pressure: %.1f%%\n", manager->aging_pressure * 100.0);
+  printf("  Flows Promoted: %llu\n",
+         (unsigned long long)manager->flows_promoted);
+  printf("  Flows Demoted: %llu\n",
+         (unsigned long long)manager->flows_demoted);
+  printf("  Flows Aged Out: %llu\n",
+         (unsigned long long)manager->flows_aged_out);
+  print_eviction_report();
+  printf("  Idle Timers: %llu expired, %llu aged, %llu re-armed active, "
+         "%llu cascaded (tick %u us, timeout %d us)\n",
+         (unsigned long long)g_table->idle_wheel.fired,
+         (unsigned long long)manager->flows_aged,
+         (unsigned long long)manager->idle_rearms,
+         (unsigned long long)g_table->idle_wheel.cascaded, IDLE_TICK_US,
+         g_params.idle_timeout);
+  print_maintenance_report();
+  printf("  Burst Detection: %llu bursting-flow hits, %llu arrival surges "
+         "(%.1f%% of ticks), %llu promotions\n",
+         (unsigned long long)manager->flow_burst_hits,
+         (unsigned long long)manager->surges,
+         manager->arrival_ticks > 0
+             ? 100.0 * manager->surge_ticks / manager->arrival_ticks
+             : 0.0,
+         (unsigned long long)manager->burst_promotions);
+  printf("  New-Flow Rate: %.1f short-term, %.1f long-term per %d us\n",
+         manager->arrival_rate_fast, manager->arrival_rate_slow, BURST_TICK_US);
+  if (g_table->bulk_score_passes > 0) {
+    printf("  Bulk Scoring: %llu passes, %.1f us/pass (%.1f ns/flow, %s)\n",
+           (unsigned long long)g_table->bulk_score_passes,
+           g_table->bulk_score_seconds * 1e6 / g_table->bulk_score_passes,
+           g_table->bulk_scored_flows > 0
+               ? g_table->bulk_score_seconds * 1e9 / g_table->bulk_scored_flows
+               : 0.0,
+#ifdef __AVX2__
+           "AVX2"
+#else
+           "scalar"
+#endif
+    );
+  }
+
+  // Performance counters
+#if STATS_LEVEL >= STATS_FULL
+  printf("\nPerformance Metrics:\n");
+  printf("  Ultra-fast Promotions: %llu\n",
+         (unsigned long long)stats.ultra_fast_promotions);
+  printf("  Confidence Updates: %llu\n",
+         (unsigned long long)stats.confidence_updates);
+  printf("  Pattern Updates: %llu\n",
+         (unsigned long long)stats.pattern_updates);
+#else
+  (void)stats;
+#endif
+
+  // Flow Type Distribution with enhanced metrics
+  int flow_type_counts[7] = {0};
+  double avg_confidence_by_type[7] = {0};
+  double avg_ml_score_by_type[7] = {0};
+  double avg_promotion_score_by_type[7] = {0};
+
+  score_flow_pool();
+  for (int i = 0; i < g_table->pool_index; i++) {
+    FlowEntry *flow = &g_table->flow_pool[i];
+    if (flow->ip == 0)
+      continue;
+
+    int type = (int)flow->flow_type;
+    if (type >= 0 && type < 7) {
+      flow_type_counts[type]++;
+      avg_confidence_by_type[type] += flow->confidence;
+      avg_ml_score_by_type[type] += g_table->flow_scores[i];
+      avg_promotion_score_by_type[type] += flow->promotion_score;
+    }
+  }
+
+  const char *flow_type_names[] = {"Normal", "Large",    "Bursty",   "Micro",
+                                   "Dying",  "Promoted", "Suspected"};
+
+  printf("\nFlow Type Distribution:\n");
+  for (int i = 0; i < 7; i++) {
+    if (flow_type_counts[i] > 0) {
+      printf("  %-9s: %5d flows (%4.1f%%) | conf: %4.1f | ML: %.3f | promo: "
+             "%4.0f\n",
+             flow_type_names[i], flow_type_counts[i],
+             100.0 * flow_type_counts[i] / g_table->live_flows,
+             avg_confidence_by_type[i] / flow_type_counts[i],
+             avg_ml_score_by_type[i] / flow_type_counts[i],
+             avg_promotion_score_by_type[i] / flow_type_counts[i]);
+    }
+  }
+
+  // Pattern Analysis
+  double total_path_consistency = 0;
+  double total_burst_score = 0;
+  int flows_with_patterns = 0;
+  int high_consistency_flows = 0;
+
+  for (int i = 0; i < g_table->pool_index; i++) {
+    FlowEntry *flow = &g_table->flow_pool[i];
+    if (flow->ip == 0)
+      continue;
+
+    if (pattern_has_consistency(&flow->pattern)) {
+      double consistency = pattern_consistency(&flow->pattern);
+      total_path_consistency += consistency;
+      total_burst_score += pattern_burst_score(&flow->pattern);
+      flows_with_patterns++;
+
+      if (consistency > 0.8) {
+        high_consistency_flows++;
+      }
+    }
+  }
+
+  if (flows_with_patterns > 0) {
+    printf("\nPattern Analysis:\n");
+    printf("  Flows with Patterns: %d (%.1f%%)\n", flows_with_patterns,
+           100.0 * flows_with_patterns / g_table->live_flows);
+    printf("  Average Path Consistency: %.3f\n",
+           total_path_consistency / flows_with_patterns);
+    printf("  High Consistency Flows: %d (%.1f%%)\n", high_consistency_flows,
+           100.0 * high_consistency_flows / flows_with_patterns);
+    printf("  Average Burst Score: %.3f\n",
+           total_burst_score / flows_with_patterns);
+  }
+}
+
+// Offline training: replay a trace through the engine, label every sampled
+// packet by whether its flow recurs within ONLINE_LABEL_HORIZON packets
+// (exact, from the whole trace), and fit weights, bias and normalization
+// bounds. Samples are split in trace order: the last part is held out.
+#define OFFLINE_EPOCHS 20
+#define OFFLINE_LEARNING_RATE 0.1 // Decays as 1 / (1 + epoch)
+#define OFFLINE_HOLDOUT_FRACTION 0.2
+#define OFFLINE_BOUND_PERCENTILE 0.99 // Upper bound, robust to a few elephants
+#define STUMP_ROUNDS 16    // <= MODEL_FILE_MAX_STUMPS, multiple of 4
+#define STUMP_BINS 32      // Candidate thresholds per feature (quantiles)
+#define STUMP_SHRINKAGE 0.5
+#define PREDICT_TIMING_REPS 200
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static inline double model_logit(const MLModel *model, const double *x) {
+  double z = model->bias;
+  for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+    z += model->weights[i] * x[i];
+  }
+  return z;
+}
+
+static inline double classifier_predict(MLModel *model,
+                                        const double *raw_features) {
+  double x[ML_FEATURE_COUNT];
+  memcpy(x, raw_features, sizeof(x));
+  return model->classifier == CLASSIFIER_STUMPS ? stumps_predict(model, x)
+                                                : linear_predict(model, x);
+}
+
+// Accuracy over raw samples [from, to) with the model's classifier
+static double evaluate_offline(MLModel *model, const double *raw,
+                               const uint8_t *labels, int from, int to,
+                               double *log_loss) {
+  int correct = 0;
+  double loss = 0.0;
+  for (int s = from; s < to; s++) {
+    double p = classifier_predict(model, &raw[(size_t)s * ML_FEATURE_COUNT]);
+    correct += (p > 0.5) == labels[s];
+    p = p < 1e-9 ? 1e-9 : (p > 1.0 - 1e-9 ? 1.0 - 1e-9 : p);
+    loss -= labels[s] ? log(p) : log(1.0 - p);
+  }
+  int n = to - from;
+  *log_loss = n > 0 ? loss / n : 0.0;
+  return n > 0 ? (double)correct / n : 0.0;
+}
+
+// Mean ns per prediction over raw samples [from, to)
+static double time_predictions(MLModel *model, const double *raw, int from,
+                               int to) {
+  struct timespec t0, t1;
+  volatile double sink = 0.0;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int rep = 0; rep < PREDICT_TIMING_REPS; rep++) {
+    for (int s = from; s < to; s++) {
+      sink += classifier_predict(model, &raw[(size_t)s * ML_FEATURE_COUNT]);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  (void)sink;
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  return ns / ((double)PREDICT_TIMING_REPS * (to - from));
+}
+
+// Least-squares boosting of depth-1 trees on the raw training samples. Each
+// feature is cut at STUMP_BINS quantiles, so a round is one pass over the
+// samples per feature. Fills the stump fields of `model`.
+static int fit_stumps(MLModel *model, const double *raw, const uint8_t *labels,
+                      int n) {
+  double cuts[ML_FEATURE_COUNT][STUMP_BINS - 1];
+  uint8_t *bins = malloc((size_t)n * ML_FEATURE_COUNT);
+  double *column = malloc((size_t)n * sizeof(double));
+  double *score = malloc((size_t)n * sizeof(double));
+  if (!bins || !column || !score) {
+    free(bins);
+    free(column);
+    free(score);
+    return -1;
+  }
+
+  for (int j = 0; j < ML_FEATURE_COUNT; j++) {
+    for (int s = 0; s < n; s++) {
+      column[s] = raw[(size_t)s * ML_FEATURE_COUNT + j];
+    }
+    qsort(column, n, sizeof(double), compare_double);
+    for (int b = 0; b < STUMP_BINS - 1; b++) {
+      cuts[j][b] = column[(size_t)(b + 1) * (n - 1) / STUMP_BINS];
+    }
+    for (int s = 0; s < n; s++) {
+      double v = raw[(size_t)s * ML_FEATURE_COUNT + j];
+      int bin = 0;
+      while (bin < STUMP_BINS - 1 && v > cuts[j][bin]) {
+        bin++;
+      }
+      bins[(size_t)s * ML_FEATURE_COUNT + j] = (uint8_t)bin;
+    }
+  }
+  free(column);
+
+  double base = 0.0;
+  for (int s = 0; s < n; s++) {
+    base += labels[s];
+  }
+  base /= n;
+  for (int s = 0; s < n; s++) {
+    score[s] = base;
+  }
+  model->stump_base = base;
+  model->stump_count = 0;
+  memset(model->stump_feature, 0, sizeof(model->stump_feature));
+  memset(model->stump_threshold, 0, sizeof(model->stump_threshold));
+  memset(model->stump_value, 0, sizeof(model->stump_value));
+
+  for (int round = 0; round < STUMP_ROUNDS; round++) {
+    double best_gain = 0.0;
+    int best_feature = -1, best_cut = 0;
+    double best_left = 0.0, best_right = 0.0;
+
+    for (int j = 0; j < ML_FEATURE_COUNT; j++) {
+      double sum[STUMP_BINS] = {0};
+      int count[STUMP_BINS] = {0};
+      for (int s = 0; s < n; s++) {
+        int bin = bins[(size_t)s * ML_FEATURE_COUNT + j];
+        sum[bin] += labels[s] - score[s];
+        count[bin]++;
+      }
+      double total = 0.0;
+      for (int b = 0; b < STUMP_BINS; b++) {
+        total += sum[b];
+      }
+
+      // Split after bin b: x <= cuts[j][b] goes left
+      double left = 0.0;
+      int left_n = 0;
+      for (int b = 0; b < STUMP_BINS - 1; b++) {
+        left += sum[b];
+        left_n += count[b];
+        int right_n = n - left_n;
+        if (left_n == 0 || right_n == 0) {
+          continue;
+        }
+        double right = total - left;
+        double gain = left * left / left_n + right * right / right_n;
+        if (gain > best_gain) {
+          best_gain = gain;
+          best_feature = j;
+          best_cut = b;
+          best_left = left / left_n;
+          best_right = right / right_n;
+        }
+      }
+    }
+    if (best_feature < 0) {
+      break; // Residuals are constant within every split
+    }
+
+    int k = model->stump_count++;
+    model->stump_feature[k] = best_feature;
+    model->stump_threshold[k] = cuts[best_feature][best_cut];
+    model->stump_value[k][0] = STUMP_SHRINKAGE * best_left;
+    model->stump_value[k][1] = STUMP_SHRINKAGE * best_right;
+    for (int s = 0; s < n; s++) {
+      int above = bins[(size_t)s * ML_FEATURE_COUNT + best_feature] > best_cut;
+      score[s] += model->stump_value[k][above];
+    }
+  }
+
+  free(bins);
+  free(score);
+  return 0;
+}
+
+// Returns 0 and fills `out` on success, -1 if the trace is too short to fit
+static int train_offline_model(const int *packets, const uint64_t *times,
+                               int num_packets, ModelFile *out) {
+  int max_samples = (num_packets + ONLINE_SAMPLE_INTERVAL - 1) /
+                    ONLINE_SAMPLE_INTERVAL;
+  uint64_t *order = malloc((size_t)num_packets * sizeof(uint64_t));
+  uint8_t *recurs = calloc((size_t)max_samples, 1);
+  double *raw = malloc((size_t)max_samples * ML_FEATURE_COUNT * sizeof(double));
+  uint8_t *labels = malloc((size_t)max_samples);
+  if (!order || !recurs || !raw || !labels) {
+    fprintf(stderr, "Offline training: out of memory\n");
+    free(order);
+    free(recurs);
+    free(raw);
+    free(labels);
+    return -1;
+  }
+
+  // Labels: sort (ip, index) so each packet's next occurrence follows it
+  for (int i = 0; i < num_packets; i++) {
+    order[i] = (uint64_t)(uint32_t)packets[i] << 32 | (uint32_t)i;
+  }
+  qsort(order, num_packets, sizeof(uint64_t), compare_u64);
+  for (int k = 0; k < num_packets; k++) {
+    uint32_t index = (uint32_t)order[k];
+    if (index % ONLINE_SAMPLE_INTERVAL == 0 && k + 1 < num_packets &&
+        order[k + 1] >> 32 == order[k] >> 32 &&
+        (uint32_t)order[k + 1] - index <= ONLINE_LABEL_HORIZON) {
+      recurs[index / ONLINE_SAMPLE_INTERVAL] = 1;
+    }
+  }
+  free(order);
+
+  // Features: as the model would see them at path selection, i.e. before
+  // the packet updates its flow. The last horizon of the trace cannot be
+  // labelled and is only replayed.
+  int count = 0;
+  for (int i = 0; i < num_packets; i++) {
+    advance_packet_time(times, i);
+    if (i % ONLINE_SAMPLE_INTERVAL == 0 &&
+        i + ONLINE_LABEL_HORIZON < num_packets) {
+      FlowEntry *flow = peek_flow((uint32_t)packets[i]);
+      if (flow) {
+        extract_ml_features(flow, &raw[(size_t)count * ML_FEATURE_COUNT]);
+        labels[count++] = recurs[i / ONLINE_SAMPLE_INTERVAL];
+      }
+    }
+    process_packet_optimized((uint32_t)packets[i]);
+  }
+  free(recurs);
+
+  int train_count = (int)(count * (1.0 - OFFLINE_HOLDOUT_FRACTION));
+  if (train_count < 100 || train_count == count) {
+    fprintf(stderr, "Offline training: only %d samples, trace too short\n",
+            count);
+    free(raw);
+    free(labels);
+    return -1;
+  }
+
+  // Normalization bounds from the training part only
+  MLModel initial = *g_table->ml_model;
+  MLModel fit = initial;
+  double *column = malloc((size_t)train_count * sizeof(double));
+  for (int j = 0; j < ML_FEATURE_COUNT && column; j++) {
+    for (int s = 0; s < train_count; s++) {
+      column[s] = raw[(size_t)s * ML_FEATURE_COUNT + j];
+    }
+    qsort(column, train_count, sizeof(double), compare_double);
+    fit.feature_mins[j] = column[0];
+    fit.feature_maxs[j] =
+        column[(int)(OFFLINE_BOUND_PERCENTILE * (train_count - 1))];
+    if (fit.feature_maxs[j] <= fit.feature_mins[j]) {
+      fit.feature_maxs[j] = column[train_count - 1];
+    }
+  }
+  free(column);
+
+  // SGD from the initial weights, shuffled with a fixed seed so a trace
+  // always produces the same model
+  int *shuffle = malloc((size_t)train_count * sizeof(int));
+  double *x = malloc((size_t)train_count * ML_FEATURE_COUNT * sizeof(double));
+  if (!shuffle || !x) {
+    fprintf(stderr, "Offline training: out of memory\n");
+    free(shuffle);
+    free(x);
+    free(raw);
+    free(labels);
+    return -1;
+  }
+  for (int s = 0; s < train_count; s++) {
+    shuffle[s] = s;
+    memcpy(&x[(size_t)s * ML_FEATURE_COUNT], &raw[(size_t)s * ML_FEATURE_COUNT],
+           ML_FEATURE_COUNT * sizeof(double));
+    normalize_features(&fit, &x[(size_t)s * ML_FEATURE_COUNT]);
+  }
+  uint32_t rng = 0x9e3779b9u;
+  for (int epoch = 0; epoch < OFFLINE_EPOCHS; epoch++) {
+    for (int s = train_count - 1; s > 0; s--) {
+      rng ^= rng << 13, rng ^= rng >> 17, rng ^= rng << 5;
+      int r = (int)(rng % (uint32_t)(s + 1));
+      int tmp = shuffle[s];
+      shuffle[s] = shuffle[r];
+      shuffle[r] = tmp;
+    }
+    double lr = OFFLINE_LEARNING_RATE / (1.0 + epoch);
+    for (int s = 0; s < train_count; s++) {
+      const double *xs = &x[(size_t)shuffle[s] * ML_FEATURE_COUNT];
+      double error =
+          1.0 / (1.0 + exp(-model_logit(&fit, xs))) - labels[shuffle[s]];
+      for (int i = 0; i < ML_FEATURE_COUNT; i++) {
+        fit.weights[i] -= lr * (error * xs[i] + ONLINE_L2 * fit.weights[i]);
       }
+      fit.bias -= lr * error;
+    }
+  }
+  free(shuffle);
+  free(x);
+
+  double initial_loss, fit_loss;
+  double initial_acc =
+      evaluate_offline(&initial, raw, labels, train_count, count, &initial_loss);
+  double fit_acc =
+      evaluate_offline(&fit, raw, labels, train_count, count, &fit_loss);
+
+  MLModel stumps = fit;
+  stumps.classifier = CLASSIFIER_STUMPS;
+  if (fit_stumps(&stumps, raw, labels, train_count) != 0) {
+    fprintf(stderr, "Offline training: out of memory\n");
+    free(raw);
+    free(labels);
+    return -1;
+  }
+  double stumps_loss;
+  double stumps_acc =
+      evaluate_offline(&stumps, raw, labels, train_count, count, &stumps_loss);
+  double linear_ns = time_predictions(&fit, raw, train_count, count);
+  double stumps_ns = time_predictions(&stumps, raw, train_count, count);
+
+  int positives = 0;
+  for (int s = 0; s < count; s++) {
+    positives += labels[s];
+  }
+  free(raw);
+  free(labels);
+
+  printf("\nOffline Training:\n");
+  printf("  Samples: %d (%d train, %d hold-out), %.1f%% recur within %d "
+         "packets\n",
+         count, train_count, count - train_count, 100.0 * positives / count,
+         ONLINE_LABEL_HORIZON);
+  printf("  Hold-out accuracy: initial %.1f%% (log loss %.3f) -> trained "
+         "%.1f%% (log loss %.3f)\n",
+         100.0 * initial_acc, initial_loss, 100.0 * fit_acc, fit_loss);
+  printf("  Boosted stumps (%d): hold-out accuracy %.1f%% (log loss %.3f)\n",
+         stumps.stump_count, 100.0 * stumps_acc, stumps_loss);
+  printf("  Prediction cost: linear %.1f ns, stumps %.1f ns\n", linear_ns,
+         stumps_ns);
+
+  memset(out, 0, sizeof(ModelFile));
+  out->version = MODEL_FILE_VERSION;
+  out->feature_count = ML_FEATURE_COUNT;
+  out->label_horizon = ONLINE_LABEL_HORIZON;
+  out->samples = (uint32_t)train_count;
+  out->accuracy = fit_acc;
+  memcpy(out->weights, fit.weights, sizeof(out->weights));
+  out->bias = fit.bias;
+  memcpy(out->feature_mins, fit.feature_mins, sizeof(out->feature_mins));
+  memcpy(out->feature_maxs, fit.feature_maxs, sizeof(out->feature_maxs));
+  out->stump_base = stumps.stump_base;
+  out->stump_count = stumps.stump_count;
+  for (int k = 0; k < stumps.stump_count; k++) {
+    out->stumps[k].feature = stumps.stump_feature[k];
+    out->stumps[k].threshold = stumps.stump_threshold[k];
+    out->stumps[k].value[0] = stumps.stump_value[k][0];
+    out->stumps[k].value[1] = stumps.stump_value[k][1];
+  }
+  return 0;
+}
+
+static inline void apply_model_file(const ModelFile *file) {
+  MLModel *model = g_table->ml_model;
+  memcpy(model->weights, file->weights, sizeof(model->weights));
+  model->bias = file->bias;
+  memcpy(model->feature_mins, file->feature_mins, sizeof(model->feature_mins));
+  memcpy(model->feature_maxs, file->feature_maxs, sizeof(model->feature_maxs));
+  model->stump_base = file->stump_base;
+  model->stump_count = file->stump_count;
+  for (int k = 0; k < file->stump_count; k++) {
+    model->stump_feature[k] = file->stumps[k].feature;
+    model->stump_threshold[k] = file->stumps[k].threshold;
+    model->stump_value[k][0] = file->stumps[k].value[0];
+    model->stump_value[k][1] = file->stumps[k].value[1];
+  }
+  // stumps_predict walks whole groups of four: clear the slots past the
+  // file's stumps, which may still hold the previous model's
+  for (int k = file->stump_count; k < MODEL_FILE_MAX_STUMPS; k++) {
+    model->stump_feature[k] = 0;
+    model->stump_threshold[k] = 0.0;
+    model->stump_value[k][0] = 0.0;
+    model->stump_value[k][1] = 0.0;
+  }
+}
+
+// Set up shadow evaluation in shadow from "linear:<file>", "stumps:<file>"
+// or "quantized[:<file>]" (no file: a quantized copy of the live model).
+// Returns 0, or -1 with a message on stderr.
+static int init_shadow(ShadowEval *shadow, const char *spec,
+                       uint32_t sample_interval) {
+  const char *file = strchr(spec, ':');
+  size_t kind_len = file ? (size_t)(file - spec) : strlen(spec);
+  file = file ? file + 1 : NULL;
+
+  shadow->model = *g_table->ml_model;
+  shadow->description = spec;
+  shadow->sample_interval = sample_interval > 0 ? sample_interval : 1;
+  shadow->countdown = shadow->sample_interval;
+
+  ClassifierKind kind;
+  if (kind_len == 6 && strncmp(spec, "linear", 6) == 0 && file) {
+    kind = CLASSIFIER_LINEAR;
+  } else if (kind_len == 6 && strncmp(spec, "stumps", 6) == 0 && file) {
+    kind = CLASSIFIER_STUMPS;
+  } else if (kind_len == 9 && strncmp(spec, "quantized", 9) == 0) {
+    kind = CLASSIFIER_QUANTIZED;
+  } else {
+    fprintf(stderr, "Invalid shadow model '%s'\n", spec);
+    return -1;
+  }
+
+  if (file) {
+    ModelFile loaded;
+    if (model_file_load(file, &loaded) != 0) {
+      return -1;
+    }
+    if (kind == CLASSIFIER_STUMPS && loaded.stump_count == 0) {
+      fprintf(stderr, "%s has no stump ensemble\n", file);
+      return -1;
+    }
+    // Load through the live model's slot, then move it to the shadow
+    MLModel live = *g_table->ml_model;
+    apply_model_file(&loaded);
+    shadow->model = *g_table->ml_model;
+    *g_table->ml_model = live;
+  }
+  shadow->model.classifier = CLASSIFIER_LINEAR;
+  if (kind == CLASSIFIER_QUANTIZED) {
+    shadow->tracks_live = file == NULL;
+    quantize_linear_model(&shadow->model);
+  } else {
+    shadow->model.classifier = kind;
+  }
+
+  g_table->shadow = shadow;
+  return 0;
+}
+
+// Mean ns per model_predict call over the flow pool
+static double time_model_on_pool(MLModel *model) {
+  int n = g_table->pool_index;
+  if (n == 0) {
+    return 0.0;
+  }
+  volatile double sink = 0.0;
+  double start = monotonic_seconds();
+  for (int rep = 0; rep < PREDICT_TIMING_REPS / 20; rep++) {
+    for (int i = 0; i < n; i++) {
+      sink += model_predict(model, &g_table->flow_pool[i]);
     }
+  }
+  (void)sink;
+  return (monotonic_seconds() - start) * 1e9 / ((PREDICT_TIMING_REPS / 20) * n);
+}
 
-    // Promotion score updates
-    if (path <= FAST_PATH) {
-      flow->promotion_score =
-          (flow->promotion_score < 950) ? flow->promotion_score + 10 : 1000;
-    } else if (path >= SLOW_PATH) {
-      flow->promotion_score =
-          (flow->promotion_score > 50) ? flow->promotion_score - 5 : 0;
+static void print_shadow_report(double processing_seconds) {
+  ShadowEval *shadow = g_table->shadow;
+  printf("\nShadow Model (%s, 1 in %u established-flow packets):\n",
+         shadow->description, shadow->sample_interval);
+  if (shadow->samples == 0) {
+    printf("  No samples\n");
+    return;
+  }
+  printf("  Samples: %llu\n", (unsigned long long)shadow->samples);
+  printf("  Path Agreement: %.2f%% | Mean |score difference|: %.4f\n",
+         100.0 * shadow->path_agreements / shadow->samples,
+         shadow->score_diff_sum / shadow->samples);
+
+  const char *path_names[] = {"Fast", "Accelerated", "Ultra-Fast",
+                              "Slow", "Adaptive",    "Deep"};
+  printf("  Path Mix (live -> shadow):\n");
+  for (int i = 0; i < 6; i++) {
+    if (shadow->live_paths[i] == 0 && shadow->shadow_paths[i] == 0) {
+      continue;
     }
+    printf("    %-12s: %5.1f%% -> %5.1f%%\n", path_names[i],
+           100.0 * shadow->live_paths[i] / shadow->samples,
+           100.0 * shadow->shadow_paths[i] / shadow->samples);
   }
 
-  g_table->total_processed++;
+  // Each sample costs one live and one shadow prediction
+  double live_ns = time_model_on_pool(g_table->ml_model);
+  double shadow_ns = time_model_on_pool(&shadow->model);
+  double overhead = shadow->samples * (live_ns + shadow_ns) * 1e-9;
+  printf("  Inference Cost: shadow %.1f ns, live %.1f ns per prediction\n",
+         shadow_ns, live_ns);
+  printf("  Estimated Overhead: %.2f%% of processing time\n",
+         processing_seconds > 0 ? 100.0 * overhead / processing_seconds : 0.0);
+}
 
-  // Periodic maintenance
-  if (g_table->total_processed % AGING_INTERVAL == 0) {
-    enhanced_aging_cycle();
+// Load a dataset (trace.h) and keep up to LARGE_FLOW_AREA_SIZE of its known
+// flows in known. Returns 0, or -1 with a message on stderr.
+int read_dataset_fast(const char *fn, int *known, Trace *trace) {
+  if (trace_load(fn, trace) != 0) {
+    return -1;
   }
+  INITIAL_KNOWN_SIZE = trace->known_count;
+  NUM_PACKETS = trace->packet_count;
+  IP_RANGE = trace->ip_range;
 
-  if (g_table->total_processed % ML_ADAPTATION_INTERVAL == 0) {
-    adapt_ml_model();
+  printf("Dataset Info: Known=%d, Packets=%d, IP_Range=%d\n",
+         INITIAL_KNOWN_SIZE, NUM_PACKETS, IP_RANGE);
+  if (trace->times && NUM_PACKETS > 0) {
+    double span = trace->times[NUM_PACKETS - 1] * 1e-6;
+    printf("Timestamps: %.3f s of packet time (%.2f Mpps offered)\n", span,
+           span > 0.0 ? NUM_PACKETS / span / 1e6 : 0.0);
   }
-}
 
-// Advanced flow lifecycle management
-static inline void manage_flow_lifecycle() {
-  time_t now = time(NULL);
-  int promoted_count = 0;
-  int demoted_count = 0;
+  int kept = INITIAL_KNOWN_SIZE < LARGE_FLOW_AREA_SIZE ? INITIAL_KNOWN_SIZE
+                                                       : LARGE_FLOW_AREA_SIZE;
+  memcpy(known, trace->known, (size_t)kept * sizeof(int));
+  printf("Successfully loaded dataset: %s\n", fn);
+  return 0;
+}
 
-  for (int i = 0; i < g_table->pool_index && i < 1000; i++) { // Limit scope
-    FlowEntry *flow = &g_table->flow_pool[i];
-    if (flow->ip == 0)
-      continue;
+// Runtime parameter table: name, kind, bounds and slot in g_params
+typedef enum { PARAM_INT, PARAM_POW2, PARAM_DOUBLE } ParamKind;
 
-    double idle_time = (double)(now - flow->last_seen);
-    double ml_score = enhanced_ml_predict(flow);
+typedef struct {
+  const char *name;
+  ParamKind kind;
+  double min;
+  double max;
+  size_t offset;
+  const char *description;
+} ParamSpec;
+
+static const ParamSpec param_specs[] = {
+    {"cache_size", PARAM_POW2, 64, 1 << 20,
+     offsetof(EngineParams, cache_size), "Flow lookup cache entries"},
+    {"prediction_cache_size", PARAM_POW2, 64, 1 << 20,
+     offsetof(EngineParams, prediction_cache_size),
+     "Prediction cache entries"},
+    {"sketch_width", PARAM_POW2, 256, 1 << 20,
+     offsetof(EngineParams, sketch_width), "Counters per sketch row"},
+    {"sketch_depth", PARAM_INT, 1, SKETCH_MAX_DEPTH,
+     offsetof(EngineParams, sketch_depth), "Sketch rows"},
+    {"aging_interval", PARAM_INT, 1000, 1000000,
+     offsetof(EngineParams, aging_interval),
+     "Packets between aging pressure updates"},
+    {"idle_timeout", PARAM_INT, IDLE_TICK_US, 1 << 24,
+     offsetof(EngineParams, idle_timeout),
+     "Microseconds of packet time without a hit before a flow ages"},
+    {"maint_interval", PARAM_POW2, 1, ONLINE_TRAIN_INTERVAL,
+     offsetof(EngineParams, maint_interval),
+     "Packets between maintenance slices"},
+    {"maint_budget", PARAM_INT, 0, 1 << 20,
+     offsetof(EngineParams, maint_budget),
+     "Maintenance entries per slice (0 = all due work at once)"},
+    {"evict_target", PARAM_DOUBLE, 0.5, 1, offsetof(EngineParams, evict_target),
+     "Pool utilization eviction holds (1 = evict only when full)"},
+    {"confidence_fast_track", PARAM_INT, 0, 100,
+     offsetof(EngineParams, confidence_fast_track),
+     "Confidence for the fast path"},
+    {"confidence_ultra_fast", PARAM_INT, 0, 100,
+     offsetof(EngineParams, confidence_ultra_fast),
+     "Confidence for the ultra-fast path"},
+    {"cached_ultra_fast", PARAM_DOUBLE, 0, 1,
+     offsetof(EngineParams, cached_ultra_fast),
+     "Cached prediction above which a flow goes ultra-fast"},
+    {"cached_fast", PARAM_DOUBLE, 0, 1, offsetof(EngineParams, cached_fast),
+     "Cached prediction above which a flow goes fast"},
+    {"cached_accelerated", PARAM_DOUBLE, 0, 1,
+     offsetof(EngineParams, cached_accelerated),
+     "Cached prediction above which a flow goes accelerated"},
+    {"burst_threshold", PARAM_INT, 1, BURST_RATE_WINDOW,
+     offsetof(EngineParams, burst_threshold),
+     "Hits per second of packet time a bursting flow must exceed"},
+};
+#define NUM_PARAMS ((int)(sizeof(param_specs) / sizeof(param_specs[0])))
+
+static double param_value(const ParamSpec *spec) {
+  const char *slot = (const char *)&g_params + spec->offset;
+  return spec->kind == PARAM_DOUBLE ? *(const double *)slot
+                                    : (double)*(const int *)slot;
+}
 
-    // Promote promising flows
-    if (flow->flow_type == NORMAL_FLOW && ml_score > 0.75 &&
-        flow->promotion_score > 700 && flow->hits > 8) {
-      flow->previous_type = flow->flow_type;
-      flow->flow_type = PROMOTED_FLOW;
-      flow->confidence = CONFIDENCE_FAST_TRACK;
-      promoted_count++;
+// Apply one "name=value" assignment. Returns 0 on success, -1 (with a
+// message on stderr) for an unknown name or an out-of-range value.
+static int set_engine_param(const char *assignment) {
+  const char *eq = strchr(assignment, '=');
+  if (!eq) {
+    fprintf(stderr, "Parameter '%s' is not name=value\n", assignment);
+    return -1;
+  }
+  size_t name_len = (size_t)(eq - assignment);
+  for (int i = 0; i < NUM_PARAMS; i++) {
+    const ParamSpec *spec = &param_specs[i];
+    if (strlen(spec->name) != name_len ||
+        strncmp(spec->name, assignment, name_len) != 0) {
+      continue;
     }
-
-    // Demote underperforming promoted flows
-    if (flow->flow_type == PROMOTED_FLOW &&
-        (ml_score < 0.4 || idle_time > 300 || flow->promotion_score < 200)) {
-      flow->flow_type = flow->previous_type;
-      flow->confidence = flow->confidence > 15 ? flow->confidence - 15 : 10;
-      demoted_count++;
+    char *end;
+    double value = strtod(eq + 1, &end);
+    int integral = spec->kind != PARAM_DOUBLE;
+    if (end == eq + 1 || *end != '\0' || value < spec->min ||
+        value > spec->max || (integral && value != floor(value))) {
+      fprintf(stderr, "Parameter %s: '%s' is not in [%.10g, %.10g]\n",
+              spec->name, eq + 1, spec->min, spec->max);
+      return -1;
     }
-
-    // Age out dying flows
-    if (flow->flow_type == DYING_FLOW && idle_time > 900) { // 15 minutes
-      flow->confidence = 0;
-      // In a real system, we'd reclaim this entry
+    if (spec->kind == PARAM_POW2 && ((int)value & ((int)value - 1)) != 0) {
+      fprintf(stderr, "Parameter %s: %s is not a power of 2\n", spec->name,
+              eq + 1);
+      return -1;
     }
+    char *slot = (char *)&g_params + spec->offset;
+    if (integral) {
+      *(int *)slot = (int)value;
+    } else {
+      *(double *)slot = value;
+    }
+    return 0;
   }
+  fprintf(stderr, "Unknown parameter '%.*s' (see --list-params)\n",
+          (int)name_len, assignment);
+  return -1;
+}
 
-  g_table->aging_manager->flows_promoted += promoted_count;
-  g_table->aging_manager->flows_demoted += demoted_count;
+// Parameter file: one name=value per line, '#' starts a comment
+static int load_params_file(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  char line[256];
+  int status = 0;
+  while (status == 0 && fgets(line, sizeof(line), f)) {
+    char *p = strchr(line, '#');
+    if (p) {
+      *p = '\0';
+    }
+    char *start = line;
+    while (*start == ' ' || *start == '\t') {
+      start++;
+    }
+    char *end = start + strlen(start);
+    while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                           end[-1] == ' ' || end[-1] == '\t')) {
+      *--end = '\0';
+    }
+    if (*start != '\0') {
+      status = set_engine_param(start);
+    }
+  }
+  fclose(f);
+  return status;
 }
 
-// Enhanced statistics reporting
-static inline void print_enhanced_statistics() {
-  printf("\n=== ENHANCED ML & AGING STATISTICS ===\n");
+// Cross-parameter checks and derived masks, once all overrides are in
+static int finalize_engine_params() {
+  if (g_params.confidence_fast_track > g_params.confidence_ultra_fast) {
+    fprintf(stderr, "confidence_fast_track must not exceed "
+                    "confidence_ultra_fast\n");
+    return -1;
+  }
+  if (!(g_params.cached_ultra_fast >= g_params.cached_fast &&
+        g_params.cached_fast >= g_params.cached_accelerated)) {
+    fprintf(stderr, "Cached thresholds must satisfy cached_ultra_fast >= "
+                    "cached_fast >= cached_accelerated\n");
+    return -1;
+  }
+  g_params.cache_mask = (uint32_t)g_params.cache_size - 1;
+  g_params.prediction_cache_mask = (uint32_t)g_params.prediction_cache_size - 1;
+  g_params.maint_mask = (uint64_t)g_params.maint_interval - 1;
+  g_params.burst_gap_limit =
+      burst_log2(BURST_RATE_WINDOW / (uint32_t)g_params.burst_threshold);
+  return 0;
+}
 
-  // ML Statistics
-  MLModel *model = g_table->ml_model;
-  double validation_accuracy = 0.0;
-  if (model->validation_samples > 0) {
-    validation_accuracy =
-        (double)model->validation_correct / model->validation_samples;
+static void list_engine_params() {
+  printf("Tunable parameters (--param name=value):\n");
+  for (int i = 0; i < NUM_PARAMS; i++) {
+    const ParamSpec *spec = &param_specs[i];
+    printf("  %-22s %-8g [%.10g, %.10g]%s  %s\n", spec->name,
+           param_value(spec), spec->min, spec->max,
+           spec->kind == PARAM_POW2 ? " pow2" : "", spec->description);
   }
+}
 
-  printf("ML Model Performance:\n");
-  printf("  Validation Accuracy: %.1f%% (%u correct / %u samples)\n",
-         validation_accuracy * 100.0, model->validation_correct,
-         model->validation_samples);
-  printf("  Learning Rate: %.6f\n", model->learning_rate);
-  printf("  Total ML Predictions: %llu\n", g_table->ml_predictions);
-  printf("  Prediction Cache Hit Rate: %.1f%% (%llu hits)\n",
-         g_table->ml_predictions > 0
-             ? 100.0 * g_table->ml_cache_hits / g_table->ml_predictions
-             : 0.0,
-         g_table->ml_cache_hits);
+// In-process engine interface (accelerated_engine.h). main() drives the
+// same calls with the command-line options.
+static const PipelineVariant *g_pipeline = &pipeline_variants[0];
+static size_t g_engine_bytes; // Reserved by the latest accelerated_open()
 
-  // Aging Statistics
-  AgingManager *manager = g_table->aging_manager;
-  printf("\nAging & Lifecycle Management:\n");
-  printf("  Memory Utilization: %.1f%% (%d / %d flows)\n",
-         manager->memory_utilization * 100.0, g_table->pool_index,
-         g_table->pool_size);
-  printf("  Aging Pressure: %.1f%%\n", manager->aging_pressure * 100.0);
-  printf("  Flows Promoted: %llu\n", manager->flows_promoted);
-  printf("  Flows Demoted: %llu\n", manager->flows_demoted);
-  printf("  Flows Aged Out: %llu\n", manager->flows_aged_out);
-  printf("  Current Burst Rate: %.1f packets/sec\n",
-         manager->current_burst_rate);
+// Every long-lived engine allocation, in order: the table, the shadow model
+// when one is requested, and the direct index for a bounded key space.
+// Returns 0, or -1 if the table could not be allocated.
+static int engine_allocate(const AcceleratedOptions *options,
+                           ShadowEval **shadow) {
+  g_table = init_optimized_table();
+  if (!g_table) {
+    return -1;
+  }
+  *shadow = options->shadow_spec
+                ? (ShadowEval *)engine_alloc(sizeof(ShadowEval))
+                : NULL;
+  if (options->direct_index) {
+    enable_direct_index((uint32_t)IP_RANGE);
+  }
+  return 0;
+}
 
-  // Performance counters
-  printf("\nPerformance Metrics:\n");
-  printf("  Ultra-fast Promotions: %llu\n", g_table->ultra_fast_promotions);
-  printf("  Confidence Updates: %llu\n", g_table->confidence_updates);
-  printf("  Pattern Updates: %llu\n", g_table->pattern_updates);
+static void engine_release(void) {
+  engine_free(g_table->hash_table);
+  engine_free(g_table->fast_cache);
+  engine_free(g_table->sketch->counters);
+  engine_free(g_table->sketch);
+  engine_free(g_table->prediction_cache);
+  engine_free(g_table->ml_model);
+  engine_free(g_table->aging_manager);
+  engine_free(g_table->trainer);
+  engine_free(g_table->shadow);
+  engine_free(g_table->maint);
+  engine_free(g_table->flow_scores);
+  engine_free(g_table->idle_wheel.nodes);
+  engine_free(g_table->flow_pool);
+  engine_free(g_table->free_slots);
+  engine_free(g_table->evictor.small.slots);
+  engine_free(g_table->evictor.main.slots);
+  engine_free(g_table->evictor.ghost);
+  engine_free(g_table->direct_index);
+  engine_free(g_table->direct_bitmap);
+  engine_free(g_table);
+  g_table = NULL;
+}
 
-  // Flow Type Distribution with enhanced metrics
-  int flow_type_counts[7] = {0};
-  double avg_confidence_by_type[7] = {0};
-  double avg_ml_score_by_type[7] = {0};
-  double avg_promotion_score_by_type[7] = {0};
+// Total engine memory: engine_allocate run once against a counting arena,
+// so the figure cannot drift from what the init code allocates
+static size_t engine_memory_bytes(const AcceleratedOptions *options) {
+  arena_init_counting(&g_arena);
+  ShadowEval *shadow = NULL;
+  size_t bytes = 0;
+  if (engine_allocate(options, &shadow) == 0) {
+    bytes = g_arena.used;
+    engine_free(shadow);
+    engine_release();
+  }
+  memset(&g_arena, 0, sizeof(g_arena));
+  return bytes;
+}
 
-  for (int i = 0; i < g_table->pool_index; i++) {
-    FlowEntry *flow = &g_table->flow_pool[i];
-    if (flow->ip == 0)
-      continue;
+void accelerated_default_options(AcceleratedOptions *options) {
+  memset(options, 0, sizeof(*options));
+  options->shadow_interval = SHADOW_DEFAULT_INTERVAL;
+  options->online_training = 1;
+  options->direct_index = 1;
+  options->arena = 1;
+}
 
-    int type = (int)flow->flow_type;
-    if (type >= 0 && type < 7) {
-      flow_type_counts[type]++;
-      avg_confidence_by_type[type] += flow->confidence;
-      avg_ml_score_by_type[type] += enhanced_ml_predict(flow);
-      avg_promotion_score_by_type[type] += flow->promotion_score;
-    }
-  }
+int accelerated_set_param(const char *assignment) {
+  return set_engine_param(assignment);
+}
 
-  const char *flow_type_names[] = {"Normal", "Large",    "Bursty",   "Micro",
-                                   "Dying",  "Promoted", "Suspected"};
+int accelerated_load_params(const char *path) {
+  return load_params_file(path);
+}
 
-  printf("\nFlow Type Distribution:\n");
-  for (int i = 0; i < 7; i++) {
-    if (flow_type_counts[i] > 0) {
-      printf("  %-9s: %5d flows (%4.1f%%) | conf: %4.1f | ML: %.3f | promo: "
-             "%4.0f\n",
-             flow_type_names[i], flow_type_counts[i],
-             100.0 * flow_type_counts[i] / g_table->pool_index,
-             avg_confidence_by_type[i] / flow_type_counts[i],
-             avg_ml_score_by_type[i] / flow_type_counts[i],
-             avg_promotion_score_by_type[i] / flow_type_counts[i]);
+int accelerated_open(const AcceleratedOptions *options, const int *known,
+                     int known_count, int num_packets, int ip_range) {
+  int verbose = options->verbose;
+  if (finalize_engine_params() != 0) {
+    return -1;
+  }
+  g_pipeline = options->pipeline ? find_pipeline_variant(options->pipeline)
+                                 : &pipeline_variants[0];
+  if (!g_pipeline) {
+    fprintf(stderr, "Unknown pipeline variant %s\n", options->pipeline);
+    return -1;
+  }
+  if (options->stumps && !options->model_file) {
+    fprintf(stderr, "The stumps classifier needs a model file\n");
+    return -1;
+  }
+  INITIAL_KNOWN_SIZE = known_count;
+  NUM_PACKETS = num_packets;
+  IP_RANGE = ip_range;
+  g_slow_path =
+      options->slow_path && options->slow_path->kind != SLOW_PATH_LEGACY
+          ? options->slow_path
+          : NULL;
+  memset(&g_stats, 0, sizeof(g_stats));
+  memset(&g_arena, 0, sizeof(g_arena));
+
+  // Reserve all engine memory up front; the key range tells us whether the
+  // direct index will be needed
+  if (verbose) {
+    printf("Initializing optimized data structures...\n");
+  }
+  g_engine_bytes = engine_memory_bytes(options);
+  if (g_engine_bytes == 0) {
+    fprintf(stderr, "Failed to initialize table\n");
+    return -1;
+  }
+  if (options->arena) {
+    if (arena_init(&g_arena, g_engine_bytes, options->prefault) != 0) {
+      fprintf(stderr, "Arena reservation failed, falling back to calloc\n");
     }
   }
+  if (verbose) {
+    printf("Memory: %s arena, %.1f MB%s\n\n",
+           arena_backing_name(g_arena.backing), g_arena.size / 1048576.0,
+           g_arena.base && options->prefault ? ", prefaulted" : "");
+  }
 
-  // Pattern Analysis
-  double total_path_consistency = 0;
-  double total_burst_score = 0;
-  int flows_with_patterns = 0;
-  int high_consistency_flows = 0;
-
-  for (int i = 0; i < g_table->pool_index; i++) {
-    FlowEntry *flow = &g_table->flow_pool[i];
-    if (flow->ip == 0)
-      continue;
-
-    if (flow->pattern.history_filled || flow->pattern.history_index >= 4) {
-      total_path_consistency += flow->pattern.path_consistency;
-      total_burst_score += flow->pattern.burst_score;
-      flows_with_patterns++;
+  ShadowEval *shadow;
+  if (engine_allocate(options, &shadow) != 0) {
+    fprintf(stderr, "Failed to initialize table\n");
+    arena_destroy(&g_arena);
+    return -1;
+  }
+  if (g_arena.exhausted > 0) {
+    fprintf(stderr,
+            "Engine arena exhausted: %zu allocations outside %zu reserved "
+            "bytes\n",
+            g_arena.exhausted, g_engine_bytes);
+    goto fail;
+  }
 
-      if (flow->pattern.path_consistency > 0.8) {
-        high_consistency_flows++;
+  // The online trainer only fits the linear model
+  if (!options->online_training || options->stumps) {
+    engine_free(g_table->trainer);
+    g_table->trainer = NULL;
+  }
+  if (options->model_file) {
+    ModelFile loaded;
+    if (model_file_load(options->model_file, &loaded) != 0) {
+      goto fail;
+    }
+    apply_model_file(&loaded);
+    if (verbose) {
+      printf("Model: %s (v%d, %u samples, hold-out accuracy %.1f%%)\n",
+             options->model_file, loaded.version, loaded.samples,
+             100.0 * loaded.accuracy);
+    }
+    if (options->stumps) {
+      if (loaded.stump_count == 0) {
+        fprintf(stderr, "%s has no stump ensemble\n", options->model_file);
+        goto fail;
+      }
+      g_table->ml_model->classifier = CLASSIFIER_STUMPS;
+      if (verbose) {
+        printf("Classifier: %d boosted stumps\n", loaded.stump_count);
       }
     }
   }
-
-  if (flows_with_patterns > 0) {
-    printf("\nPattern Analysis:\n");
-    printf("  Flows with Patterns: %d (%.1f%%)\n", flows_with_patterns,
-           100.0 * flows_with_patterns / g_table->pool_index);
-    printf("  Average Path Consistency: %.3f\n",
-           total_path_consistency / flows_with_patterns);
-    printf("  High Consistency Flows: %d (%.1f%%)\n", high_consistency_flows,
-           100.0 * high_consistency_flows / flows_with_patterns);
-    printf("  Average Burst Score: %.3f\n",
-           total_burst_score / flows_with_patterns);
+  if (shadow) {
+    if (init_shadow(shadow, options->shadow_spec, options->shadow_interval) !=
+        0) {
+      goto fail;
+    }
+    if (verbose) {
+      printf("Shadow model: %s, 1 in %u packets\n", options->shadow_spec,
+             g_table->shadow->sample_interval);
+    }
   }
-}
 
-// Fast dataset reader with flexible filename
-int *read_dataset_fast(const char *fn, int *known, int *np, int *ir) {
-  FILE *f = fopen(fn, "r");
-  if (!f) {
-    fprintf(stderr, "Failed to open dataset file: %s\n", fn);
-    perror("Error details");
-    return NULL;
+  // Bounded key space: direct-indexed lookup, enabled by engine_allocate
+  if (g_table->direct_index) {
+    if (verbose) {
+      printf("Lookup: direct-indexed (range %d, bitmap %.1f KB, index %.1f "
+             "KB)\n",
+             IP_RANGE, (IP_RANGE + 63) / 64 * 8 / 1024.0,
+             IP_RANGE * sizeof(int32_t) / 1024.0);
+    }
+  } else if (verbose) {
+    printf("Lookup: hashed (%d buckets, %d-entry cache)\n", HASH_TABLE_SIZE,
+           g_params.cache_size);
   }
 
-  if (fscanf(f, "%d %d %d", &INITIAL_KNOWN_SIZE, np, ir) != 3) {
-    fprintf(stderr, "Error reading dataset header from: %s\n", fn);
-    fclose(f);
-    return NULL;
+  // Pre-populate known flows with enhanced initialization
+  if (verbose) {
+    printf("Pre-populating %d known flows...\n", INITIAL_KNOWN_SIZE);
   }
+  for (int i = 0; i < known_count && i < LARGE_FLOW_AREA_SIZE; i++) {
+    if (known[i] > 0) {
+      FlowEntry *flow = create_flow_fast((uint32_t)known[i]);
+      if (flow) {
+        flow->confidence = 75; // Higher starting confidence for known flows
+        flow->hits = 12;
+        flow->packet_count = 15;
+        flow->flow_type = LARGE_FLOW;
+        flow->aging.aging_strategy = AGING_ADAPTIVE;
+        flow->promotion_score = 800; // High promotion potential
 
-  NUM_PACKETS = *np;
-  IP_RANGE = *ir;
-
-  printf("Dataset Info: Known=%d, Packets=%d, IP_Range=%d\n",
-         INITIAL_KNOWN_SIZE, NUM_PACKETS, IP_RANGE);
-
-  // Read known flows
-  for (int i = 0; i < INITIAL_KNOWN_SIZE; i++) {
-    int temp;
-    if (fscanf(f, "%d", &temp) != 1) {
-      fprintf(stderr, "Error reading known flow %d from: %s\n", i, fn);
-      fclose(f);
-      return NULL;
-    }
-    if (i < LARGE_FLOW_AREA_SIZE) {
-      known[i] = temp;
+        // Initialize with good patterns
+        pattern_seed_known(&flow->pattern);
+      }
     }
   }
 
-  // Read packet data
-  int *packets = malloc(NUM_PACKETS * sizeof(int));
-  if (!packets) {
-    fprintf(stderr, "Memory allocation failed for %d packets\n", NUM_PACKETS);
-    fclose(f);
-    return NULL;
+  if (offload_start(options->offload_workers,
+                    options->offload_pass ? OFFLOAD_PASS : OFFLOAD_HOLD,
+                    g_slow_path) != 0) {
+    goto fail;
   }
+  if (verbose && g_inspect.worker_count > 0) {
+    printf("Slow-path offload: %d inspection threads, %d-entry queues, "
+           "pending flows %s\n",
+           g_inspect.worker_count, OFFLOAD_QUEUE_SIZE,
+           g_inspect.policy == OFFLOAD_PASS ? "pass" : "hold");
+  }
+  return 0;
 
-  for (int i = 0; i < NUM_PACKETS; i++) {
-    if (fscanf(f, "%d", &packets[i]) != 1) {
-      fprintf(stderr, "Error reading packet %d from: %s\n", i, fn);
-      free(packets);
-      fclose(f);
-      return NULL;
-    }
+fail:
+  // Undo the partial open; the shadow belongs to the table once attached
+  if (shadow != g_table->shadow) {
+    engine_free(shadow);
   }
+  engine_release();
+  arena_destroy(&g_arena);
+  return -1;
+}
 
-  fclose(f);
-  printf("Successfully loaded dataset: %s\n", fn);
-  return packets;
+void accelerated_run(const int *packets, const uint64_t *times, int count) {
+  g_pipeline->run(packets, times, count);
+  offload_flush();
+}
+
+void accelerated_counts(AcceleratedCounts *counts) {
+  EngineStats stats;
+  stats_snapshot(&stats);
+  counts->packets = g_table->total_processed;
+  counts->fast_packets =
+      stats.path_counts[FAST_PATH] + stats.path_counts[ULTRA_FAST_PATH];
+  counts->slow_packets =
+      stats.path_counts[SLOW_PATH] + stats.path_counts[DEEP_ANALYSIS_PATH];
+  counts->flows_created = g_table->flows_created;
+  counts->memory_bytes = g_engine_bytes;
+}
+
+void accelerated_close(void) {
+  offload_stop();
+  engine_release();
+  arena_destroy(&g_arena);
 }
 
+// Command-line program, left out of library builds (accelerated_engine.h)
+#ifndef DYNAFLOW_ENGINE_LIBRARY
+
 // Usage function
 void print_usage(const char *program_name) {
   printf("Enhanced ML-Driven Flow Processor v2.0\n");
-  printf("Usage: %s [dataset_file]\n\n", program_name);
+  printf("Usage: %s [options] [dataset_file]\n\n", program_name);
   printf("Arguments:\n");
   printf(
       "  dataset_file    Path to the dataset file (default: dataset.txt)\n\n");
+  printf("Options:\n");
+  printf("  --no-direct-index  Always use the hashed lookup path, even when\n"
+         "                     IP_RANGE <= %d\n",
+         DIRECT_INDEX_MAX_RANGE);
+  printf("  --no-arena         Allocate engine structures with calloc instead\n"
+         "                     of one huge-page-backed arena\n");
+  printf("  --prefault         Touch all arena pages before the timed loop\n");
+  printf("  --perf             Report dTLB misses and page faults for the\n"
+         "                     timed loop (where the kernel exposes them)\n");
+  printf("  --no-online-training  Keep the initial ML weights fixed\n");
+  printf("  --model <file>     Start from a trained model file\n");
+  printf("  --classifier <kind>  linear (default) or stumps; stumps needs a\n"
+         "                     --model file and disables online training\n");
+  printf("  --shadow <model>   Score a sample of packets with a candidate\n"
+         "                     model without routing on it: linear:<file>,\n"
+         "                     stumps:<file> or quantized[:<file>]\n");
+  printf("  --shadow-rate <n>  Shadow-score 1 in n packets (default %d)\n",
+         SHADOW_DEFAULT_INTERVAL);
+  printf("  --train-model <file>  Replay the dataset, fit the model offline\n"
+         "                     and write it to <file> (no timed run)\n");
+  printf("  --param <n>=<v>    Override a tunable parameter (repeatable)\n");
+  printf("  --params <file>    Read name=value parameter lines from <file>\n");
+  printf("  --list-params      List tunable parameters and their defaults\n");
+  printf("  --slow-path <kind[:cycles]>  Slow-path workload, calibrated to\n"
+         "                     the given cost: legacy (default), dfa, hash\n"
+         "                     or rules (default %d cycles)\n",
+         SLOW_PATH_DEFAULT_CYCLES);
+  printf("  --offload <n>      Run slow-path inspections on n worker threads\n"
+         "                     (at most %d, default 0: inline)\n",
+         OFFLOAD_MAX_WORKERS);
+  printf("  --offload-policy <p>  Packets of a flow awaiting its verdict:\n"
+         "                     hold (default) or pass provisionally\n");
+  printf("  --pipeline <name>  Packet pipeline variant:\n");
+  for (int i = 0; i < NUM_PIPELINE_VARIANTS; i++) {
+    printf("                       %-10s %s\n", pipeline_variants[i].name,
+           pipeline_variants[i].description);
+  }
+  printf("\n");
   printf("Examples:\n");
   printf("  %s                           # Use default dataset.txt\n",
          program_name);
@@ -1143,86 +3822,230 @@ void print_usage(const char *program_name) {
 int main(int argc, char *argv[]) {
   // Handle command line arguments
   const char *dataset_file = "dataset.txt"; // Default
-
-  if (argc > 2) {
-    printf("Error: Too many arguments\n\n");
-    print_usage(argv[0]);
-    return 1;
-  }
-
-  if (argc == 2) {
-    if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+  int use_direct_index = 1;
+  int use_arena = 1;
+  int prefault = 0;
+  int use_perf = 0;
+  const PipelineVariant *pipeline = &pipeline_variants[0];
+  int online_training = 1;
+  const char *model_file = NULL;
+  const char *train_model_file = NULL;
+  ClassifierKind classifier = CLASSIFIER_LINEAR;
+  const char *shadow_spec = NULL;
+  uint32_t shadow_interval = SHADOW_DEFAULT_INTERVAL;
+  SlowPathKind slow_path = SLOW_PATH_LEGACY;
+  uint32_t slow_path_cycles = SLOW_PATH_DEFAULT_CYCLES;
+  int offload_workers = 0;
+  int offload_pass = 0;
+  int have_dataset_arg = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
       print_usage(argv[0]);
       return 0;
+    } else if (strcmp(argv[i], "--no-direct-index") == 0) {
+      use_direct_index = 0;
+    } else if (strcmp(argv[i], "--no-arena") == 0) {
+      use_arena = 0;
+    } else if (strcmp(argv[i], "--prefault") == 0) {
+      prefault = 1;
+    } else if (strcmp(argv[i], "--perf") == 0) {
+      use_perf = 1;
+    } else if (strcmp(argv[i], "--no-online-training") == 0) {
+      online_training = 0;
+    } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+      model_file = argv[++i];
+    } else if (strcmp(argv[i], "--classifier") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "linear") == 0) {
+        classifier = CLASSIFIER_LINEAR;
+      } else if (strcmp(argv[i], "stumps") == 0) {
+        classifier = CLASSIFIER_STUMPS;
+      } else {
+        printf("Error: Unknown classifier %s\n\n", argv[i]);
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--shadow") == 0 && i + 1 < argc) {
+      shadow_spec = argv[++i];
+    } else if (strcmp(argv[i], "--shadow-rate") == 0 && i + 1 < argc) {
+      shadow_interval = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--train-model") == 0 && i + 1 < argc) {
+      train_model_file = argv[++i];
+    } else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc) {
+      if (set_engine_param(argv[++i]) != 0) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--params") == 0 && i + 1 < argc) {
+      if (load_params_file(argv[++i]) != 0) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--slow-path") == 0 && i + 1 < argc) {
+      if (parse_slow_path(argv[++i], &slow_path, &slow_path_cycles) != 0) {
+        printf("Error: Invalid slow-path workload %s\n\n", argv[i]);
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--offload") == 0 && i + 1 < argc) {
+      offload_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--offload-policy") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "hold") == 0) {
+        offload_pass = 0;
+      } else if (strcmp(argv[i], "pass") == 0) {
+        offload_pass = 1;
+      } else {
+        printf("Error: Unknown offload policy %s\n\n", argv[i]);
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--list-params") == 0) {
+      list_engine_params();
+      return 0;
+    } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+      pipeline = find_pipeline_variant(argv[++i]);
+      if (!pipeline) {
+        printf("Error: Unknown pipeline variant %s\n\n", argv[i]);
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (argv[i][0] == '-') {
+      printf("Error: Unknown option %s\n\n", argv[i]);
+      print_usage(argv[0]);
+      return 1;
+    } else if (have_dataset_arg) {
+      printf("Error: Too many arguments\n\n");
+      print_usage(argv[0]);
+      return 1;
+    } else {
+      dataset_file = argv[i];
+      have_dataset_arg = 1;
     }
-    dataset_file = argv[1];
   }
 
   printf("=== Enhanced ML-Driven Flow Processor v2.0 ===\n");
   printf("Dataset: %s\n", dataset_file);
-  printf("Initializing optimized data structures...\n\n");
-
-  g_table = init_optimized_table();
-  if (!g_table) {
-    fprintf(stderr, "Failed to initialize table\n");
-    return 1;
-  }
 
   int known[LARGE_FLOW_AREA_SIZE] = {0};
-  int np, ir;
-  int *packets = read_dataset_fast(dataset_file, known, &np, &ir);
-  if (!packets) {
+  Trace trace;
+  if (read_dataset_fast(dataset_file, known, &trace) != 0) {
     fprintf(stderr, "Failed to read dataset: %s\n", dataset_file);
     fprintf(stderr, "Make sure the file exists and is in the correct format\n");
     return 1;
   }
 
-  // Pre-populate known flows with enhanced initialization
-  printf("Pre-populating %d known flows...\n", INITIAL_KNOWN_SIZE);
-  for (int i = 0; i < INITIAL_KNOWN_SIZE && i < LARGE_FLOW_AREA_SIZE; i++) {
-    if (known[i] > 0) {
-      FlowEntry *flow = create_flow_fast((uint32_t)known[i]);
-      if (flow) {
-        flow->confidence = 75; // Higher starting confidence for known flows
-        flow->hits = 12;
-        flow->packet_count = 15;
-        flow->flow_type = LARGE_FLOW;
-        flow->aging.aging_strategy = AGING_ADAPTIVE;
-        flow->promotion_score = 800; // High promotion potential
+  if (classifier == CLASSIFIER_STUMPS && (!model_file || train_model_file)) {
+    fprintf(stderr, "--classifier stumps needs a --model file and cannot be "
+                    "combined with --train-model\n");
+    return 1;
+  }
 
-        // Initialize with good patterns
-        flow->pattern.path_consistency = 0.85;
-        flow->pattern.burst_score = 0.15;
-        flow->pattern.consecutive_fast_paths = 5;
-      }
+  SlowPathWorkload workload;
+  if (slow_path_init(&workload, slow_path, slow_path_cycles) != 0) {
+    return 1;
+  }
+
+  // Offline training replays with fixed weights
+  AcceleratedOptions options;
+  accelerated_default_options(&options);
+  options.pipeline = pipeline->name;
+  options.model_file = model_file;
+  options.stumps = classifier == CLASSIFIER_STUMPS;
+  options.shadow_spec = shadow_spec;
+  options.shadow_interval = shadow_interval;
+  options.online_training = online_training && !train_model_file;
+  options.direct_index = use_direct_index;
+  options.arena = use_arena;
+  options.prefault = prefault;
+  options.slow_path = &workload;
+  options.offload_workers = offload_workers;
+  options.offload_pass = offload_pass;
+  options.verbose = 1;
+  int known_count = INITIAL_KNOWN_SIZE < LARGE_FLOW_AREA_SIZE
+                        ? INITIAL_KNOWN_SIZE
+                        : LARGE_FLOW_AREA_SIZE;
+  if (accelerated_open(&options, known, known_count, trace.packet_count,
+                       trace.ip_range) != 0) {
+    trace_free(&trace);
+    slow_path_free(&workload);
+    return 1;
+  }
+  size_t engine_bytes = g_engine_bytes;
+
+  if (train_model_file) {
+    ModelFile trained;
+    int status =
+        train_offline_model(trace.packets, trace.times, NUM_PACKETS, &trained);
+    if (status == 0) {
+      status = model_file_save(train_model_file, &trained);
     }
+    if (status == 0) {
+      printf("Model written to %s\n", train_model_file);
+    }
+    trace_free(&trace);
+    accelerated_close();
+    slow_path_free(&workload);
+    return status == 0 ? 0 : 1;
   }
 
   printf("Processing %d packets with enhanced ML and aging...\n", NUM_PACKETS);
-  printf("Configuration: BURST_THRESHOLD=%d, ML_FEATURES=%d, CACHE_SIZE=%d\n\n",
-         BURST_THRESHOLD, ML_FEATURE_COUNT, CACHE_SIZE);
+  printf("Configuration: BURST_THRESHOLD=%d, ML_FEATURES=%d, CACHE_SIZE=%d, "
+         "STATS=%s, PIPELINE=%s\n",
+         g_params.burst_threshold, ML_FEATURE_COUNT, g_params.cache_size,
+         stats_level_name(), pipeline->name);
+  printf("Tables: prediction cache %d, sketch %dx%d, aging every %d "
+         "packets\n",
+         g_params.prediction_cache_size, g_params.sketch_depth,
+         g_params.sketch_width, g_params.aging_interval);
+  printf("Thresholds: confidence %d/%d, cached prediction %.2f/%.2f/%.2f\n",
+         g_params.confidence_fast_track, g_params.confidence_ultra_fast,
+         g_params.cached_ultra_fast, g_params.cached_fast,
+         g_params.cached_accelerated);
+  print_slow_path_workload(stdout, &workload);
+  printf("\n");
+
+  PerfCounters perf;
+  if (use_perf) {
+    perf_counters_open(&perf);
+    perf_counters_start(&perf);
+  }
 
   clock_t start_time = clock();
-
-  for (int i = 0; i < NUM_PACKETS; i++) {
-    process_packet_optimized((uint32_t)packets[i]);
-
-    // Periodic lifecycle management (less frequent)
-    if (i % 100000 == 0 && i > 0) {
-      manage_flow_lifecycle();
+  double start_wall = monotonic_seconds();
+
+  // Run the selected variant in chunks between progress lines, so the
+  // per-packet loop carries no indirect call or checkpoint test. Lifecycle
+  // passes run incrementally inside the pipeline's maintenance slices.
+  for (int done = 0; done < NUM_PACKETS;) {
+    int i = (done / PROGRESS_INTERVAL + 1) * PROGRESS_INTERVAL;
+    int end = (i + 1 < NUM_PACKETS) ? i + 1 : NUM_PACKETS;
+    pipeline->run(trace.packets + done, trace.times ? trace.times + done : NULL,
+                  end - done);
+    done = end;
+    if (done != i + 1) {
+      break; // Trace ended before the next checkpoint
     }
 
-    if (i % 200000 == 0 && i > 0) {
-      printf("Processed %d packets (%.1f%%) | Flows: %d | Cache hit: %.1f%%\n",
-             i, 100.0 * i / NUM_PACKETS, g_table->pool_index,
-             100.0 * g_table->cache_hits /
-                 (g_table->cache_hits + g_table->cache_misses));
-    }
+#if STATS_LEVEL >= STATS_BASIC
+    printf("Processed %d packets (%.1f%%) | Flows: %d | Cache hit: %.1f%%\n",
+           i, 100.0 * i / NUM_PACKETS, g_table->live_flows,
+           100.0 * g_stats.cache_hits /
+               (g_stats.cache_hits + g_stats.cache_misses));
+#else
+    printf("Processed %d packets (%.1f%%) | Flows: %d\n", i,
+           100.0 * i / NUM_PACKETS, g_table->live_flows);
+#endif
   }
+  offload_flush();
 
   clock_t end_time = clock();
+  double wall_seconds = monotonic_seconds() - start_wall;
   double total_seconds = (double)(end_time - start_time) / CLOCKS_PER_SEC;
 
+  if (use_perf) {
+    perf_counters_stop(&perf);
+  }
+
   // Final lifecycle management
   manage_flow_lifecycle();
 
@@ -1234,42 +4057,69 @@ int main(int argc, char *argv[]) {
   printf("Throughput: %.2f Mpps (%.0f packets/sec)\n",
          NUM_PACKETS / total_seconds / 1e6, NUM_PACKETS / total_seconds);
   printf("Average Packet Time: %.2f ns\n", total_seconds * 1e9 / NUM_PACKETS);
-  printf("Total Flows Created: %d (%.2f%% of pool)\n", g_table->pool_index,
-         100.0 * g_table->pool_index / g_table->pool_size);
+  printf("Total Flows Created: %llu (%d live, %.2f%% of pool)\n",
+         (unsigned long long)g_table->flows_created, g_table->live_flows,
+         100.0 * g_table->live_flows / g_table->pool_size);
+  printf("Engine Memory: %zu bytes (%.2f MB)\n", engine_bytes,
+         engine_bytes / 1048576.0);
 
+  EngineStats stats;
+  stats_snapshot(&stats);
+
+#if STATS_LEVEL >= STATS_BASIC
   // Processing path distribution
   const char *path_names[] = {"Fast", "Accelerated", "Ultra-Fast",
                               "Slow", "Adaptive",    "Deep"};
   printf("\nProcessing Path Distribution:\n");
   for (int i = 0; i < 6; i++) {
-    printf("  %-12s: %8llu (%5.2f%%)\n", path_names[i], g_table->path_counts[i],
-           100.0 * g_table->path_counts[i] / NUM_PACKETS);
+    printf("  %-12s: %8llu (%5.2f%%)\n", path_names[i],
+           (unsigned long long)stats.path_counts[i],
+           100.0 * stats.path_counts[i] / NUM_PACKETS);
   }
 
   // Cache and hash performance
-  uint64_t total_cache_ops = g_table->cache_hits + g_table->cache_misses;
+  uint64_t total_cache_ops = stats.cache_hits + stats.cache_misses;
   printf("\nCache & Hash Performance:\n");
   printf("  Cache Hit Rate: %.2f%% (%llu / %llu)\n",
-         100.0 * g_table->cache_hits / total_cache_ops, g_table->cache_hits,
-         total_cache_ops);
-  printf("  Hash Collision Rate: %.2f%% (%llu / %llu)\n",
-         100.0 * g_table->hash_table->collision_count /
-             g_table->hash_table->total_lookups,
-         g_table->hash_table->collision_count,
-         g_table->hash_table->total_lookups);
+         100.0 * stats.cache_hits / total_cache_ops,
+         (unsigned long long)stats.cache_hits,
+         (unsigned long long)total_cache_ops);
+#else
+  printf("\nPath and cache statistics compiled out (STATS_LEVEL=%d)\n",
+         STATS_LEVEL);
+  printf("\nCache & Hash Performance:\n");
+#endif
+  if (stats.total_lookups > 0) {
+    printf("  Hash Collision Rate: %.2f%% (%llu / %llu)\n",
+           100.0 * stats.collision_count / stats.total_lookups,
+           (unsigned long long)stats.collision_count,
+           (unsigned long long)stats.total_lookups);
+  }
+  if (g_table->direct_range > 0) {
+    printf("  Direct-Indexed Range: %u keys\n", g_table->direct_range);
+  }
+
+  if (use_perf) {
+    printf("\nHardware Counters (timed loop, %s arena):\n",
+           g_arena.base ? "with" : "without");
+    perf_counters_print(&perf);
+    perf_counters_close(&perf);
+  }
 
   // Print detailed statistics
   print_enhanced_statistics();
+  print_inspection_report(total_seconds, wall_seconds);
+  if (g_table->shadow) {
+    print_shadow_report(total_seconds);
+  }
 
   // Cleanup
-  free(g_table->hash_table);
-  free(g_table->sketch);
-  free(g_table->ml_model);
-  free(g_table->aging_manager);
-  free(g_table->flow_pool);
-  free(g_table);
-  free(packets);
+  accelerated_close();
+  slow_path_free(&workload);
+  trace_free(&trace);
 
   printf("\n=== Processing Complete ===\n");
   return 0;
 }
+
+#endif // DYNAFLOW_ENGINE_LIBRARY
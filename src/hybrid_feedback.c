@@ -1,116 +1,119 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-// Configuration
-#define NUM_PACKETS 1000000
-#define INITIAL_KNOWN_SIZE 1000 
-#define IP_RANGE 20000
-#define FEEDBACK_INTERVAL 50000 // Packets processed per feedback window 
-#define SLOW_PATH_THRESHOLD 0.05 // Slow path trigger threshold in a window 
-
-// Simulated "expensive" operation (slowpath)
-
-void deep_inspection(int ip) {
-    int count = 0;
-    for (int i = 1; i <= ip; i++) {
-        if (ip % i == 0)
-            count++;
-    }
+#include "baseline_engines.h"
+#include "trace.h"
+
+// We'll read these from dataset.txt
+static int INITIAL_KNOWN_SIZE;
+static int NUM_PACKETS;
+static int IP_RANGE;
+
+void print_usage(const char *program_name) {
+    printf("Usage: %s [--lookup <backend>] [--slow-path <kind[:cycles]>]\n"
+           "       [--window <packets>] [--threshold <share>] [dataset_file]\n\n",
+           program_name);
+    printf("  dataset_file    Path to the dataset file (default: dataset.txt)\n");
+    printf("  --lookup        Known-flow lookup backend (default: hash)\n");
+    printf("  --slow-path     Slow-path workload (default: legacy)\n");
+    printf("  --window        Packets per feedback window (default: %d)\n",
+           FEEDBACK_INTERVAL);
+    printf("  --threshold     Slow-path share of a window above which its\n");
+    printf("                  missed flows are learned (default: %.2f)\n\n",
+           SLOW_PATH_THRESHOLD);
+    print_lookup_backends(stdout);
+    printf("\n");
+    print_slow_path_workloads(stdout);
 }
 
-// Simulated "fast" operation
-void fast_path_action(int ip) {
-    volatile int result = ip * 2;
-    (void)result;
-}
-
-// Linear search to check if IP is in known flows
-int is_known_flow(int ip, int *known_flows, int known_count) {
-    for (int i = 0; i < known_count; i++) {
-        if (known_flows[i] == ip) {
-            return 1;
+int main(int argc, char *argv[]) {
+    const char *dataset_file = "dataset.txt";
+    LookupBackend backend = LOOKUP_HASH;
+    SlowPathKind slow_path = SLOW_PATH_LEGACY;
+    uint32_t slow_path_cycles = SLOW_PATH_DEFAULT_CYCLES;
+    int window = FEEDBACK_INTERVAL;
+    double threshold = SLOW_PATH_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--lookup") == 0 && i + 1 < argc) {
+            if (parse_lookup_backend(argv[++i], &backend) != 0) {
+                fprintf(stderr, "Unknown lookup backend: %s\n\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--slow-path") == 0 && i + 1 < argc) {
+            if (parse_slow_path(argv[++i], &slow_path, &slow_path_cycles) != 0) {
+                fprintf(stderr, "Invalid slow-path workload: %s\n\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else {
+            dataset_file = argv[i];
         }
     }
-    return 0;
-}
-
-// Simple (can be modified) Add a new IP to the known flows table (if not already present)
 
-void add_known_flow(int ip, int** known_flows_ptr, int *known_count, int *capacity) {
-    if(is_known_flow(ip, *known_flows_ptr, *known_count)) {
-        return;
+    FeedbackState feedback;
+    if (feedback_init(&feedback, window, threshold) != 0) {
+        return 1;
     }
 
-
-    // Resize the array if needed 
-    if(*known_count >= *capacity) {
-        *capacity *= 2;
-        *known_flows_ptr = (int*)realloc(*known_flows_ptr, (*capacity)*sizeof(int));
+    // Read from the dataset file
+    Trace trace;
+    if (trace_load(dataset_file, &trace) != 0) {
+        feedback_free(&feedback);
+        return 1;
     }
-    (*known_flows_ptr)[(*known_count)++] = ip; 
-}
-
-int main() {
-    srand((unsigned) time(NULL));
+    INITIAL_KNOWN_SIZE = trace.known_count;
+    NUM_PACKETS = trace.packet_count;
+    IP_RANGE = trace.ip_range;
 
-    // Initialize known flows with extra capacity for feedback
-    int capacity = INITIAL_KNOWN_SIZE * 2;
+    // Known flows with extra capacity for feedback
     int known_count = INITIAL_KNOWN_SIZE;
-    int *known_flows = (int *)malloc(capacity * sizeof(int));
-
-    for (int i = 0; i < known_count; i++) {
-        known_flows[i] = rand() % IP_RANGE;
+    FlowSet known_flows;
+    flowset_init(&known_flows, backend, INITIAL_KNOWN_SIZE * 2, IP_RANGE);
+    for (int i = 0; i < INITIAL_KNOWN_SIZE; i++) {
+        flowset_insert(&known_flows, trace.known[i]);
     }
 
-    // Generate random packets
-    int *packets = (int *)malloc(NUM_PACKETS * sizeof(int));
-    for (int i = 0; i < NUM_PACKETS; i++) {
-        packets[i] = rand() % IP_RANGE;
+    // Build and calibrate the slow-path workload before timing
+    SlowPathWorkload workload;
+    if (slow_path_init(&workload, slow_path, slow_path_cycles) != 0) {
+        return 1;
     }
 
-    long long slow_path_count = 0;
-    clock_t start = clock();
-    long long window_slow_count = 0;  // Slow path count for current window
-
     // Process packets with feedback loop
-    for (int i = 0; i < NUM_PACKETS; i++) {
-        int ip = packets[i];
-        if (is_known_flow(ip, known_flows, known_count)) {
-            fast_path_action(ip);
-        } else {
-            deep_inspection(ip);
-            slow_path_count++;
-            window_slow_count++;
-        }
-
-        // Feedback check every FEEDBACK_INTERVAL packets
-        if ((i + 1) % FEEDBACK_INTERVAL == 0) {
-            double slow_ratio = (double)window_slow_count / FEEDBACK_INTERVAL;
-            if (slow_ratio > SLOW_PATH_THRESHOLD) {
-                int window_start = i + 1 - FEEDBACK_INTERVAL;
-                for (int j = window_start; j <= i; j++) {
-                    int wip = packets[j];
-                    if (!is_known_flow(wip, known_flows, known_count)) {
-                        add_known_flow(wip, &known_flows, &known_count, &capacity);
-                    }
-                }
-            }
-            window_slow_count = 0; // Reset for next interval
-        }
-    }
+    clock_t start = clock();
+    long long slow_path_count =
+        feedback_process(&known_flows, &known_count, &feedback, &workload,
+                         trace.packets, NUM_PACKETS);
 
     clock_t end = clock();
     double total_time = (double)(end - start) / CLOCKS_PER_SEC;
 
     printf("=== Proposed Hybrid with Feedback ===\n");
-    printf("Total packets processed: %d\n", NUM_PACKETS);
-    printf("Initial known flows: %d\n", INITIAL_KNOWN_SIZE);
+    printf("Dataset: INITIAL_KNOWN_SIZE=%d, NUM_PACKETS=%d, IP_RANGE=%d\n",
+           INITIAL_KNOWN_SIZE, NUM_PACKETS, IP_RANGE);
+    print_flowset(stdout, &known_flows);
+    print_slow_path_workload(stdout, &workload);
+    printf("Feedback: %d-packet windows, threshold %.2f, learned in %lld of "
+           "%lld windows\n",
+           window, threshold, feedback.learned_windows, feedback.windows);
     printf("Final known flows: %d\n", known_count);
     printf("Slow path triggered: %lld times\n", slow_path_count);
     printf("Total time taken: %.3f seconds\n", total_time);
 
-    free(known_flows);
-    free(packets);
+    flowset_free(&known_flows);
+    slow_path_free(&workload);
+    feedback_free(&feedback);
+    trace_free(&trace);
     return 0;
 }
@@ -0,0 +1,78 @@
+#ifndef DYNAFLOW_LATENCY_HISTOGRAM_H
+#define DYNAFLOW_LATENCY_HISTOGRAM_H
+
+// Log-linear latency histogram: each power-of-2 range of values is split
+// into LATENCY_HISTOGRAM_SUB_BUCKETS linear buckets, so any recorded value is
+// reported within 1/8 of itself. Recording is a few integer operations and
+// one increment; percentiles walk the fixed bucket array.
+
+#include <stdint.h>
+#include <string.h>
+
+#define LATENCY_HISTOGRAM_SUB_BITS 3
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS (64 * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+  uint64_t counts[LATENCY_HISTOGRAM_BUCKETS];
+  uint64_t samples;
+  uint64_t total; // Sum of recorded values
+  uint64_t max;
+} LatencyHistogram;
+
+static inline void latency_histogram_init(LatencyHistogram *hist) {
+  memset(hist, 0, sizeof(*hist));
+}
+
+static inline int latency_histogram_bucket(uint64_t value) {
+  if (value < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return (int)value;
+  }
+  int shift = 63 - __builtin_clzll(value) - LATENCY_HISTOGRAM_SUB_BITS;
+  return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS +
+         (int)((value >> shift) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+// Largest value that lands in bucket
+static inline uint64_t latency_histogram_bucket_max(int bucket) {
+  if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return (uint64_t)bucket;
+  }
+  int shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKETS - 1;
+  uint64_t mantissa = LATENCY_HISTOGRAM_SUB_BUCKETS +
+                      (uint64_t)(bucket % LATENCY_HISTOGRAM_SUB_BUCKETS);
+  return ((mantissa + 1) << shift) - 1;
+}
+
+static inline void latency_histogram_record(LatencyHistogram *hist,
+                                            uint64_t value) {
+  hist->counts[latency_histogram_bucket(value)]++;
+  hist->samples++;
+  hist->total += value;
+  if (value > hist->max) {
+    hist->max = value;
+  }
+}
+
+// Value at or below which a fraction p of the samples fall (0 < p <= 1)
+static inline uint64_t latency_histogram_percentile(const LatencyHistogram *hist,
+                                                    double p) {
+  if (hist->samples == 0) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)(p * (double)hist->samples + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+    seen += hist->counts[i];
+    if (seen >= rank) {
+      uint64_t value = latency_histogram_bucket_max(i);
+      return value < hist->max ? value : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+#endif // DYNAFLOW_LATENCY_HISTOGRAM_H
@@ -0,0 +1,161 @@
+#ifndef DYNAFLOW_MODEL_FILE_H
+#define DYNAFLOW_MODEL_FILE_H
+
+// Versioned text file holding a trained flow model: the linear weights,
+// bias and the feature normalization bounds, and (from version 2) a boosted
+// stump ensemble over the raw features. Written by
+// `hybrid_accelerated --train-model` and loaded with `--model`.
+//
+//   dynaflow-model 2
+//   features 8
+//   horizon 65536
+//   samples 59325
+//   accuracy 0.9312
+//   weights w0 ... w7
+//   bias b
+//   mins m0 ... m7
+//   maxs M0 ... M7
+//   base s0
+//   stumps K
+//   feature threshold below above     (K lines)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MODEL_FILE_MAGIC "dynaflow-model"
+#define MODEL_FILE_VERSION 2
+#define MODEL_FILE_MIN_VERSION 1 // Linear model only
+#define MODEL_FILE_FEATURES 8
+#define MODEL_FILE_MAX_STUMPS 64
+
+// One boosting round: adds value[x[feature] > threshold] to the score
+typedef struct {
+  int feature;
+  double threshold;
+  double value[2];
+} ModelStump;
+
+typedef struct {
+  int version;
+  int feature_count;
+  uint32_t label_horizon; // Packets a flow had to recur within
+  uint32_t samples;       // Training samples the fit used
+  double accuracy;        // Hold-out accuracy at training time
+  double weights[MODEL_FILE_FEATURES];
+  double bias;
+  double feature_mins[MODEL_FILE_FEATURES];
+  double feature_maxs[MODEL_FILE_FEATURES];
+
+  double stump_base; // Score before the first stump
+  int stump_count;   // 0 when the file has no ensemble
+  ModelStump stumps[MODEL_FILE_MAX_STUMPS];
+} ModelFile;
+
+static inline void model_file_write_row(FILE *f, const char *key,
+                                        const double *values, int count) {
+  fprintf(f, "%s", key);
+  for (int i = 0; i < count; i++) {
+    fprintf(f, " %.17g", values[i]);
+  }
+  fprintf(f, "\n");
+}
+
+// Returns 0 on success, -1 on I/O failure
+static inline int model_file_save(const char *path, const ModelFile *model) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "%s %d\n", MODEL_FILE_MAGIC, MODEL_FILE_VERSION);
+  fprintf(f, "features %d\n", MODEL_FILE_FEATURES);
+  fprintf(f, "horizon %u\n", model->label_horizon);
+  fprintf(f, "samples %u\n", model->samples);
+  fprintf(f, "accuracy %.4f\n", model->accuracy);
+  model_file_write_row(f, "weights", model->weights, MODEL_FILE_FEATURES);
+  fprintf(f, "bias %.17g\n", model->bias);
+  model_file_write_row(f, "mins", model->feature_mins, MODEL_FILE_FEATURES);
+  model_file_write_row(f, "maxs", model->feature_maxs, MODEL_FILE_FEATURES);
+  fprintf(f, "base %.17g\n", model->stump_base);
+  fprintf(f, "stumps %d\n", model->stump_count);
+  for (int k = 0; k < model->stump_count; k++) {
+    const ModelStump *stump = &model->stumps[k];
+    fprintf(f, "%d %.17g %.17g %.17g\n", stump->feature, stump->threshold,
+            stump->value[0], stump->value[1]);
+  }
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+static inline int model_file_read_row(FILE *f, const char *key,
+                                      double *values, int count) {
+  char name[32];
+  if (fscanf(f, "%31s", name) != 1 || strcmp(name, key) != 0) {
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    if (fscanf(f, "%lf", &values[i]) != 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Returns 0 on success, -1 (with a message on stderr) if the file is missing,
+// malformed, or from an incompatible version
+static inline int model_file_load(const char *path, ModelFile *model) {
+  memset(model, 0, sizeof(ModelFile));
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+
+  char magic[32];
+  int ok = fscanf(f, "%31s %d", magic, &model->version) == 2 &&
+           strcmp(magic, MODEL_FILE_MAGIC) == 0;
+  if (ok && (model->version < MODEL_FILE_MIN_VERSION ||
+             model->version > MODEL_FILE_VERSION)) {
+    fprintf(stderr, "%s: model version %d, expected %d to %d\n", path,
+            model->version, MODEL_FILE_MIN_VERSION, MODEL_FILE_VERSION);
+    fclose(f);
+    return -1;
+  }
+  ok = ok && fscanf(f, " features %d", &model->feature_count) == 1;
+  if (ok && model->feature_count != MODEL_FILE_FEATURES) {
+    fprintf(stderr, "%s: model has %d features, expected %d\n", path,
+            model->feature_count, MODEL_FILE_FEATURES);
+    fclose(f);
+    return -1;
+  }
+  ok = ok && fscanf(f, " horizon %u", &model->label_horizon) == 1 &&
+       fscanf(f, " samples %u", &model->samples) == 1 &&
+       fscanf(f, " accuracy %lf", &model->accuracy) == 1 &&
+       model_file_read_row(f, "weights", model->weights,
+                           MODEL_FILE_FEATURES) == 0 &&
+       model_file_read_row(f, "bias", &model->bias, 1) == 0 &&
+       model_file_read_row(f, "mins", model->feature_mins,
+                           MODEL_FILE_FEATURES) == 0 &&
+       model_file_read_row(f, "maxs", model->feature_maxs,
+                           MODEL_FILE_FEATURES) == 0;
+  if (ok && model->version >= 2) {
+    ok = model_file_read_row(f, "base", &model->stump_base, 1) == 0 &&
+         fscanf(f, " stumps %d", &model->stump_count) == 1 &&
+         model->stump_count >= 0 &&
+         model->stump_count <= MODEL_FILE_MAX_STUMPS;
+    for (int k = 0; ok && k < model->stump_count; k++) {
+      ModelStump *stump = &model->stumps[k];
+      ok = fscanf(f, "%d %lf %lf %lf", &stump->feature, &stump->threshold,
+                  &stump->value[0], &stump->value[1]) == 4 &&
+           stump->feature >= 0 && stump->feature < MODEL_FILE_FEATURES;
+    }
+  }
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "%s: not a valid %s file\n", path, MODEL_FILE_MAGIC);
+    return -1;
+  }
+  return 0;
+}
+
+#endif // DYNAFLOW_MODEL_FILE_H
@@ -0,0 +1,123 @@
+#ifndef DYNAFLOW_PERF_COUNTERS_H
+#define DYNAFLOW_PERF_COUNTERS_H
+
+// Minimal perf_event_open wrapper for measuring the timed processing loop.
+// Counters the kernel or hypervisor does not expose are reported as
+// unavailable instead of failing the run.
+//
+// Requires _GNU_SOURCE (or _DEFAULT_SOURCE) before the first system include.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+typedef enum {
+  PERF_DTLB_LOAD_MISSES = 0,
+  PERF_DTLB_STORE_MISSES = 1,
+  PERF_PAGE_FAULTS = 2,
+  PERF_COUNTER_COUNT = 3
+} PerfCounterId;
+
+typedef struct {
+  int fds[PERF_COUNTER_COUNT];
+  uint64_t values[PERF_COUNTER_COUNT];
+} PerfCounters;
+
+static const char *perf_counter_names[PERF_COUNTER_COUNT] = {
+    "dTLB load misses", "dTLB store misses", "Page faults"};
+
+static inline int perf_open_counter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  (void)type;
+  (void)config;
+  return -1;
+#endif
+}
+
+static inline void perf_counters_open(PerfCounters *pc) {
+  memset(pc, 0, sizeof(PerfCounters));
+#ifdef __linux__
+  uint64_t miss = (uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+  pc->fds[PERF_DTLB_LOAD_MISSES] = perf_open_counter(
+      PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                              ((uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              miss);
+  pc->fds[PERF_DTLB_STORE_MISSES] = perf_open_counter(
+      PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                              ((uint64_t)PERF_COUNT_HW_CACHE_OP_WRITE << 8) |
+                              miss);
+  // Page faults count user-space faults taken in the timed region, so
+  // exclude_kernel does not hide them
+  pc->fds[PERF_PAGE_FAULTS] =
+      perf_open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#else
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+    pc->fds[i] = -1;
+#endif
+}
+
+static inline void perf_counters_start(PerfCounters *pc) {
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (pc->fds[i] >= 0) {
+      ioctl(pc->fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(pc->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#else
+  (void)pc;
+#endif
+}
+
+static inline void perf_counters_stop(PerfCounters *pc) {
+#ifdef __linux__
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (pc->fds[i] >= 0) {
+      ioctl(pc->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(pc->fds[i], &pc->values[i], sizeof(uint64_t)) !=
+          sizeof(uint64_t))
+        pc->values[i] = 0;
+    }
+  }
+#else
+  (void)pc;
+#endif
+}
+
+static inline void perf_counters_print(const PerfCounters *pc) {
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (pc->fds[i] >= 0) {
+      printf("  %-18s: %llu\n", perf_counter_names[i],
+             (unsigned long long)pc->values[i]);
+    } else {
+      printf("  %-18s: unavailable\n", perf_counter_names[i]);
+    }
+  }
+}
+
+static inline void perf_counters_close(PerfCounters *pc) {
+  for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+    if (pc->fds[i] >= 0)
+      close(pc->fds[i]);
+    pc->fds[i] = -1;
+  }
+}
+
+#endif // DYNAFLOW_PERF_COUNTERS_H
@@ -0,0 +1,154 @@
+#ifndef DYNAFLOW_S3FIFO_H
+#define DYNAFLOW_S3FIFO_H
+
+// S3-FIFO eviction over a fixed set of ids [0, capacity).
+//
+// New ids enter a small FIFO that holds about a tenth of the entries. When
+// the small FIFO is over its share, its head is either promoted to the main
+// FIFO (it was used again while queued) or evicted, and its key is kept in a
+// ghost filter. An id whose key is in the ghost filter skips the small FIFO.
+// The ghost filter is direct-mapped, so it forgets keys as others collide.
+// The main FIFO is a CLOCK: a head that should stay is reinserted at the
+// tail, the rest are evicted. One-hit entries therefore leave after a short
+// probation without disturbing the main working set.
+//
+// The caller decides who stays through a keep() callback that is called at
+// each visit. It typically reads and decays a small per-entry access
+// counter. Every operation is O(1) amortised and never allocates. A visit
+// limit bounds the work per eviction: if every head visited wants to stay,
+// eviction gives up and the caller should turn the newcomer away instead.
+
+#include <stdint.h>
+
+#define S3FIFO_SMALL_PERCENT 10
+#define S3FIFO_MAX_VISITS 64 // Visits per eviction before giving up
+
+typedef struct {
+  int32_t *slots; // Power-of-2 ring, at least capacity entries
+  uint32_t mask;
+  uint32_t head;
+  uint32_t tail;
+} S3FifoQueue;
+
+typedef struct {
+  S3FifoQueue small;
+  S3FifoQueue main;
+  uint32_t *ghost; // Direct-mapped keys recently evicted from small (0 = none)
+  uint32_t ghost_mask;
+  int32_t small_target;
+
+  uint64_t promoted; // Small -> main
+  uint64_t reinserted; // Main head kept for another round
+  uint64_t evicted_small;
+  uint64_t evicted_main;
+  uint64_t gave_up; // Evictions that hit the visit limit
+  uint64_t ghost_hits;
+} S3Fifo;
+
+// Ring slots per queue and ghost filter entries for capacity ids
+static inline uint32_t s3fifo_ring_size(int32_t capacity) {
+  uint32_t size = 1;
+  while (size < (uint32_t)capacity) {
+    size <<= 1;
+  }
+  return size;
+}
+
+static inline void s3fifo_init(S3Fifo *cache, int32_t capacity,
+                               int32_t *small_slots, int32_t *main_slots,
+                               uint32_t *ghost) {
+  uint32_t size = s3fifo_ring_size(capacity);
+  cache->small = (S3FifoQueue){small_slots, size - 1, 0, 0};
+  cache->main = (S3FifoQueue){main_slots, size - 1, 0, 0};
+  cache->ghost = ghost;
+  cache->ghost_mask = size - 1;
+  cache->small_target = capacity / (100 / S3FIFO_SMALL_PERCENT);
+  if (cache->small_target < 1) {
+    cache->small_target = 1;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    ghost[i] = 0;
+  }
+}
+
+static inline int32_t s3fifo_queue_size(const S3FifoQueue *queue) {
+  return (int32_t)(queue->tail - queue->head);
+}
+
+static inline void s3fifo_queue_push(S3FifoQueue *queue, int32_t id) {
+  queue->slots[queue->tail++ & queue->mask] = id;
+}
+
+static inline int32_t s3fifo_queue_pop(S3FifoQueue *queue) {
+  return queue->slots[queue->head++ & queue->mask];
+}
+
+static inline uint32_t s3fifo_ghost_slot(const S3Fifo *cache, uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x7feb352d;
+  key ^= key >> 15;
+  return key & cache->ghost_mask;
+}
+
+static inline int s3fifo_ghost_contains(const S3Fifo *cache, uint32_t key) {
+  return key != 0 && cache->ghost[s3fifo_ghost_slot(cache, key)] == key;
+}
+
+// Admit id with its key; a recently evicted key goes straight to main
+static inline void s3fifo_insert(S3Fifo *cache, int32_t id, uint32_t key) {
+  if (s3fifo_ghost_contains(cache, key)) {
+    cache->ghost[s3fifo_ghost_slot(cache, key)] = 0;
+    cache->ghost_hits++;
+    s3fifo_queue_push(&cache->main, id);
+  } else {
+    s3fifo_queue_push(&cache->small, id);
+  }
+}
+
+// Remember a key evicted from the small FIFO
+static inline void s3fifo_ghost_insert(S3Fifo *cache, uint32_t key) {
+  cache->ghost[s3fifo_ghost_slot(cache, key)] = key;
+}
+
+// Evict one id and return it, or -1 when the queues are empty or no visited
+// head would leave. keep(ctx, id, in_main) says whether the id at a queue
+// head stays; *from_small tells the caller to record the victim's key with
+// s3fifo_ghost_insert().
+static inline int32_t s3fifo_evict(S3Fifo *cache,
+                                   int (*keep)(void *ctx, int32_t id,
+                                               int in_main),
+                                   void *ctx, int *from_small) {
+  for (int visits = 0;; visits++) {
+    if (visits >= S3FIFO_MAX_VISITS) {
+      cache->gave_up++;
+      return -1;
+    }
+    if (s3fifo_queue_size(&cache->small) > cache->small_target ||
+        (s3fifo_queue_size(&cache->small) > 0 &&
+         s3fifo_queue_size(&cache->main) == 0)) {
+      int32_t id = s3fifo_queue_pop(&cache->small);
+      if (keep(ctx, id, 0)) {
+        s3fifo_queue_push(&cache->main, id);
+        cache->promoted++;
+        continue;
+      }
+      cache->evicted_small++;
+      *from_small = 1;
+      return id;
+    }
+    if (s3fifo_queue_size(&cache->main) == 0) {
+      return -1;
+    }
+    int32_t id = s3fifo_queue_pop(&cache->main);
+    if (keep(ctx, id, 1)) {
+      s3fifo_queue_push(&cache->main, id);
+      cache->reinserted++;
+      continue;
+    }
+    cache->evicted_main++;
+    *from_small = 0;
+    return id;
+  }
+}
+
+#endif // DYNAFLOW_S3FIFO_H
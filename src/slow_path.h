@@ -0,0 +1,418 @@
+#ifndef DYNAFLOW_SLOW_PATH_H
+#define DYNAFLOW_SLOW_PATH_H
+
+// Slow-path workload models shared by every engine.
+//
+// The engines' original slow paths are trial-division loops over the IP
+// value, so a packet's cost depends on its address rather than on any
+// inspection work. The workloads here model what an inspection engine
+// actually does, at a cost set in cycles:
+//
+//   dfa    Multi-pattern DFA scan (Aho-Corasick over attack signatures) of
+//          a synthetic payload
+//   hash   64-bit hash over a payload of N bytes
+//   rules  Lookups across several tuple tables of classification rules
+//
+// slow_path_init() builds the tables and payload, then calibrates the work
+// per call (payload bytes, or rule lookups) against the time-stamp counter
+// until a call costs the target number of cycles. Each flow scans its own
+// payload window, so the cost does not depend on the key value. "legacy"
+// keeps each engine's original loop for comparison with older results.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef enum {
+  SLOW_PATH_LEGACY = 0, // The engine's original IP-dependent loop
+  SLOW_PATH_DFA = 1,    // Signature DFA scan over a payload
+  SLOW_PATH_HASH = 2,   // Hash over a payload
+  SLOW_PATH_RULES = 3   // Multi-table rule lookup
+} SlowPathKind;
+
+#define SLOW_PATH_KIND_COUNT 4
+#define SLOW_PATH_DEFAULT_CYCLES 2000
+
+#define SLOW_PATH_WINDOW (64 * 1024)      // Payload start offsets (power of 2)
+#define SLOW_PATH_MAX_BYTES (256 * 1024)  // Payload bytes per call, at most
+#define SLOW_PATH_MAX_LOOKUPS (64 * 1024) // Rule lookups per call, at most
+#define SLOW_PATH_DFA_MAX_STATES 512
+#define SLOW_PATH_RULE_TABLES 8 // Power of 2
+#define SLOW_PATH_RULE_SLOTS 4096
+#define SLOW_PATH_RULE_EMPTY UINT32_MAX
+#define SLOW_PATH_CAL_BATCHES 7 // Calibration keeps the cheapest batch
+#define SLOW_PATH_CAL_CALLS 32
+
+typedef struct {
+  SlowPathKind kind;
+  uint32_t target_cycles;
+  uint32_t units;         // Payload bytes or rule lookups per call
+  double measured_cycles; // Cost per call after calibration
+  uint8_t *payload;       // SLOW_PATH_WINDOW + SLOW_PATH_MAX_BYTES bytes
+  uint16_t (*dfa)[256];
+  uint8_t *dfa_accept;
+  int dfa_states;
+  uint32_t *rules; // SLOW_PATH_RULE_TABLES tables of SLOW_PATH_RULE_SLOTS
+  uint64_t matches; // Results land here so the work is not optimised away
+} SlowPathWorkload;
+
+static const char *slow_path_kind_names[SLOW_PATH_KIND_COUNT] = {
+    "legacy", "dfa", "hash", "rules"};
+
+// Signatures compiled into the scan DFA and planted in the payload
+static const char *slow_path_signatures[] = {
+    "GET /admin",     "cmd.exe",     "/etc/passwd",
+    "SELECT * FROM",  "UNION SELECT", "<script>",
+    "../../",         "wget http",   "eval(base64_decode(",
+    "\x90\x90\x90\x90\x90\x90\x90\x90", "Authorization: Basic",
+    "User-Agent: sqlmap"};
+
+#define SLOW_PATH_SIGNATURE_COUNT                                              \
+  (int)(sizeof(slow_path_signatures) / sizeof(slow_path_signatures[0]))
+
+// Fields each rule table matches on: address prefixes, ports and mixes
+static const uint32_t slow_path_rule_masks[SLOW_PATH_RULE_TABLES] = {
+    0xff000000, 0xffff0000, 0xffffff00, 0xffffffff,
+    0x0000ffff, 0x00ffff00, 0xfff00000, 0x0fffffff};
+
+static inline const char *slow_path_kind_name(SlowPathKind kind) {
+  return slow_path_kind_names[kind];
+}
+
+// Parse "kind[:cycles]". Returns 0, or -1 if the spec is invalid.
+static inline int parse_slow_path(const char *spec, SlowPathKind *kind,
+                                  uint32_t *cycles) {
+  const char *colon = strchr(spec, ':');
+  size_t length = colon ? (size_t)(colon - spec) : strlen(spec);
+  *cycles = SLOW_PATH_DEFAULT_CYCLES;
+  if (colon) {
+    char *end;
+    unsigned long value = strtoul(colon + 1, &end, 10);
+    if (*end != '\0' || value == 0 || value > UINT32_MAX) {
+      return -1;
+    }
+    *cycles = (uint32_t)value;
+  }
+  for (int i = 0; i < SLOW_PATH_KIND_COUNT; i++) {
+    if (strlen(slow_path_kind_names[i]) == length &&
+        strncmp(spec, slow_path_kind_names[i], length) == 0) {
+      *kind = (SlowPathKind)i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static inline void print_slow_path_workloads(FILE *out) {
+  fprintf(out, "Slow-path workloads (kind[:cycles], default %d cycles):\n",
+          SLOW_PATH_DEFAULT_CYCLES);
+  fprintf(out, "  legacy  Original IP-dependent loop (default)\n");
+  fprintf(out, "  dfa     Signature DFA scan over a synthetic payload\n");
+  fprintf(out, "  hash    Hash over a payload of calibrated length\n");
+  fprintf(out, "  rules   Lookups across %d tuple tables of rules\n",
+          SLOW_PATH_RULE_TABLES);
+}
+
+// Time-stamp counter cycles (nanoseconds where there is none)
+static inline uint64_t slow_path_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return (uint64_t)clock() * (1000000000ull / CLOCKS_PER_SEC);
+#endif
+}
+
+static inline uint32_t slow_path_mix(uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x7feb352d;
+  key ^= key >> 15;
+  key *= 0x846ca68b;
+  key ^= key >> 16;
+  return key;
+}
+
+static inline uint32_t slow_path_dfa_scan(SlowPathWorkload *w,
+                                          const uint8_t *p) {
+  uint32_t state = 0;
+  uint64_t matches = 0;
+  for (uint32_t i = 0; i < w->units; i++) {
+    state = w->dfa[state][p[i]];
+    matches += w->dfa_accept[state];
+  }
+  w->matches += matches;
+  return (uint32_t)matches;
+}
+
+static inline void slow_path_hash(SlowPathWorkload *w, const uint8_t *p) {
+  uint64_t h = 0xcbf29ce484222325ull ^ w->units;
+  uint32_t words = w->units / 8;
+  for (uint32_t i = 0; i < words; i++) {
+    uint64_t word;
+    memcpy(&word, p + 8 * i, sizeof(word));
+    h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+  }
+  for (uint32_t i = 8 * words; i < w->units; i++) {
+    h = (h ^ p[i]) * 0x100000001b3ull;
+  }
+  w->matches += h & 1;
+}
+
+// Each lookup checks one header field against one table; a call walks the
+// tables in turn for successive headers derived from the key
+static inline void slow_path_rule_lookup(SlowPathWorkload *w, uint32_t key) {
+  uint64_t matches = 0;
+  for (uint32_t u = 0; u < w->units; u++) {
+    uint32_t t = u & (SLOW_PATH_RULE_TABLES - 1);
+    uint32_t header = key + (u / SLOW_PATH_RULE_TABLES) * 0x9e3779b9u;
+    uint32_t field = slow_path_mix(header) & slow_path_rule_masks[t];
+    const uint32_t *table = w->rules + (size_t)t * SLOW_PATH_RULE_SLOTS;
+    uint32_t slot = slow_path_mix(field ^ t) & (SLOW_PATH_RULE_SLOTS - 1);
+    while (table[slot] != SLOW_PATH_RULE_EMPTY) {
+      if (table[slot] == field) {
+        matches++;
+        break;
+      }
+      slot = (slot + 1) & (SLOW_PATH_RULE_SLOTS - 1);
+    }
+  }
+  w->matches += matches;
+}
+
+// One slow-path inspection for key. Returns its alerts: signature matches
+// for the dfa workload, 0 for the others. Not for SLOW_PATH_LEGACY, whose
+// loop lives in each engine.
+static inline uint32_t slow_path_run(SlowPathWorkload *w, uint32_t key) {
+  const uint8_t *p = w->payload + (slow_path_mix(key) & (SLOW_PATH_WINDOW - 1));
+  switch (w->kind) {
+  case SLOW_PATH_DFA:
+    return slow_path_dfa_scan(w, p);
+  case SLOW_PATH_HASH:
+    slow_path_hash(w, p);
+    break;
+  case SLOW_PATH_RULES:
+    slow_path_rule_lookup(w, key);
+    break;
+  case SLOW_PATH_LEGACY:
+    break;
+  }
+  return 0;
+}
+
+// Aho-Corasick automaton over the signatures, as a full transition table
+static inline int slow_path_build_dfa(SlowPathWorkload *w) {
+  w->dfa = malloc(SLOW_PATH_DFA_MAX_STATES * sizeof(*w->dfa));
+  w->dfa_accept = calloc(SLOW_PATH_DFA_MAX_STATES, 1);
+  uint16_t *fail = calloc(SLOW_PATH_DFA_MAX_STATES, sizeof(uint16_t));
+  uint16_t *queue = malloc(SLOW_PATH_DFA_MAX_STATES * sizeof(uint16_t));
+  if (!w->dfa || !w->dfa_accept || !fail || !queue) {
+    free(fail);
+    free(queue);
+    return -1;
+  }
+  memset(w->dfa, 0xff, SLOW_PATH_DFA_MAX_STATES * sizeof(*w->dfa));
+
+  // Trie of the signatures
+  int states = 1;
+  for (int s = 0; s < SLOW_PATH_SIGNATURE_COUNT; s++) {
+    uint16_t state = 0;
+    for (const uint8_t *c = (const uint8_t *)slow_path_signatures[s]; *c;
+         c++) {
+      if (w->dfa[state][*c] == UINT16_MAX) {
+        w->dfa[state][*c] = (uint16_t)states++;
+      }
+      state = w->dfa[state][*c];
+    }
+    w->dfa_accept[state] = 1;
+  }
+  w->dfa_states = states;
+
+  // Breadth-first: missing transitions follow the failure link, whose row
+  // is already complete
+  int head = 0, tail = 0;
+  for (int c = 0; c < 256; c++) {
+    if (w->dfa[0][c] == UINT16_MAX) {
+      w->dfa[0][c] = 0;
+    } else {
+      queue[tail++] = w->dfa[0][c];
+    }
+  }
+  while (head < tail) {
+    uint16_t state = queue[head++];
+    for (int c = 0; c < 256; c++) {
+      uint16_t next = w->dfa[state][c];
+      if (next == UINT16_MAX) {
+        w->dfa[state][c] = w->dfa[fail[state]][c];
+      } else {
+        fail[next] = w->dfa[fail[state]][c];
+        w->dfa_accept[next] |= w->dfa_accept[fail[next]];
+        queue[tail++] = next;
+      }
+    }
+  }
+  free(fail);
+  free(queue);
+  return 0;
+}
+
+// Header-like text with a signature planted about every kilobyte
+static inline int slow_path_build_payload(SlowPathWorkload *w) {
+  static const char alphabet[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 /=:.-";
+  size_t size = SLOW_PATH_WINDOW + SLOW_PATH_MAX_BYTES;
+  w->payload = malloc(size);
+  if (!w->payload) {
+    return -1;
+  }
+  uint32_t seed = 0x2545f491;
+  for (size_t i = 0; i < size; i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    w->payload[i] = (uint8_t)alphabet[seed % (sizeof(alphabet) - 1)];
+  }
+  for (size_t at = 512; at + 64 < size; at += 1024) {
+    const char *sig =
+        slow_path_signatures[slow_path_mix((uint32_t)at) %
+                             SLOW_PATH_SIGNATURE_COUNT];
+    memcpy(w->payload + at, sig, strlen(sig));
+  }
+  return 0;
+}
+
+// Half-full open-addressing tables of synthetic rules
+static inline int slow_path_build_rules(SlowPathWorkload *w) {
+  size_t slots = (size_t)SLOW_PATH_RULE_TABLES * SLOW_PATH_RULE_SLOTS;
+  w->rules = malloc(slots * sizeof(uint32_t));
+  if (!w->rules) {
+    return -1;
+  }
+  memset(w->rules, 0xff, slots * sizeof(uint32_t));
+  for (uint32_t t = 0; t < SLOW_PATH_RULE_TABLES; t++) {
+    uint32_t *table = w->rules + (size_t)t * SLOW_PATH_RULE_SLOTS;
+    for (uint32_t r = 0; r < SLOW_PATH_RULE_SLOTS / 2; r++) {
+      uint32_t field =
+          slow_path_mix(r * 0x9e3779b9u + t) & slow_path_rule_masks[t];
+      if (field == SLOW_PATH_RULE_EMPTY) {
+        continue;
+      }
+      uint32_t slot = slow_path_mix(field ^ t) & (SLOW_PATH_RULE_SLOTS - 1);
+      while (table[slot] != SLOW_PATH_RULE_EMPTY && table[slot] != field) {
+        slot = (slot + 1) & (SLOW_PATH_RULE_SLOTS - 1);
+      }
+      table[slot] = field;
+    }
+  }
+  return 0;
+}
+
+// Cycles per call at the current work size, from the cheapest batch
+static inline double slow_path_measure(SlowPathWorkload *w) {
+  double best = 0.0;
+  for (int batch = 0; batch < SLOW_PATH_CAL_BATCHES; batch++) {
+    uint64_t start = slow_path_cycles();
+    for (int i = 0; i < SLOW_PATH_CAL_CALLS; i++) {
+      slow_path_run(w, (uint32_t)(batch * SLOW_PATH_CAL_CALLS + i));
+    }
+    double per_call =
+        (double)(slow_path_cycles() - start) / SLOW_PATH_CAL_CALLS;
+    if (batch == 0 || per_call < best) {
+      best = per_call;
+    }
+  }
+  return best;
+}
+
+static inline uint32_t slow_path_clamp_units(const SlowPathWorkload *w,
+                                             double units) {
+  double limit = w->kind == SLOW_PATH_RULES ? SLOW_PATH_MAX_LOOKUPS
+                                            : SLOW_PATH_MAX_BYTES;
+  if (units < 1.0) {
+    return 1;
+  }
+  return units > limit ? (uint32_t)limit : (uint32_t)(units + 0.5);
+}
+
+// Fit cost = fixed + per_unit * units from two work sizes, then correct
+// the estimate once against a measurement at the predicted size
+static inline void slow_path_calibrate(SlowPathWorkload *w) {
+  uint32_t small = w->kind == SLOW_PATH_RULES ? 16 : 64;
+  uint32_t large = small * 16;
+  w->units = small;
+  double small_cost = slow_path_measure(w);
+  w->units = large;
+  double large_cost = slow_path_measure(w);
+
+  double per_unit = (large_cost - small_cost) / (large - small);
+  if (per_unit <= 0.0) {
+    per_unit = large_cost / large;
+  }
+  double fixed = small_cost - per_unit * small;
+  if (fixed < 0.0) {
+    fixed = 0.0;
+  }
+  w->units = slow_path_clamp_units(w, (w->target_cycles - fixed) / per_unit);
+  w->measured_cycles = slow_path_measure(w);
+  if (w->measured_cycles > 0.0) {
+    w->units = slow_path_clamp_units(w, w->units * (double)w->target_cycles /
+                                            w->measured_cycles);
+    w->measured_cycles = slow_path_measure(w);
+  }
+}
+
+static inline void slow_path_free(SlowPathWorkload *w) {
+  free(w->payload);
+  free(w->dfa);
+  free(w->dfa_accept);
+  free(w->rules);
+  w->payload = NULL;
+  w->dfa = NULL;
+  w->dfa_accept = NULL;
+  w->rules = NULL;
+}
+
+// Build and calibrate a workload. Returns 0, or -1 with a message on stderr.
+static inline int slow_path_init(SlowPathWorkload *w, SlowPathKind kind,
+                                 uint32_t target_cycles) {
+  memset(w, 0, sizeof(*w));
+  w->kind = kind;
+  w->target_cycles = target_cycles;
+  if (kind == SLOW_PATH_LEGACY) {
+    return 0;
+  }
+  int status = slow_path_build_payload(w);
+  if (status == 0 && kind == SLOW_PATH_DFA) {
+    status = slow_path_build_dfa(w);
+  }
+  if (status == 0 && kind == SLOW_PATH_RULES) {
+    status = slow_path_build_rules(w);
+  }
+  if (status != 0) {
+    fprintf(stderr, "Failed to build the %s slow-path workload\n",
+            slow_path_kind_name(kind));
+    slow_path_free(w);
+    return -1;
+  }
+  slow_path_calibrate(w);
+  return 0;
+}
+
+static inline void print_slow_path_workload(FILE *out,
+                                            const SlowPathWorkload *w) {
+  if (w->kind == SLOW_PATH_LEGACY) {
+    fprintf(out, "Slow-path workload: legacy\n");
+    return;
+  }
+  fprintf(out, "Slow-path workload: %s, %u %s/call, %.0f cycles (target %u)\n",
+          slow_path_kind_name(w->kind), w->units,
+          w->kind == SLOW_PATH_RULES ? "lookups" : "bytes", w->measured_cycles,
+          w->target_cycles);
+}
+
+#endif // DYNAFLOW_SLOW_PATH_H
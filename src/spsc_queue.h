@@ -0,0 +1,80 @@
+#ifndef DYNAFLOW_SPSC_QUEUE_H
+#define DYNAFLOW_SPSC_QUEUE_H
+
+// Bounded lock-free queue between one producer and one consumer thread.
+//
+// The producer only writes tail and the consumer only writes head, each
+// published with a release store and read with an acquire load, so a slot
+// is fully written before the other side can see it. Each side keeps a
+// cached copy of the other's index and rereads the shared one only when the
+// queue looks full (producer) or empty (consumer). The indices live on
+// separate cache lines, so in steady state neither side's line bounces.
+// That makes SpscQueue 64-byte aligned: keep it in static storage, or
+// allocate it with that alignment rather than with malloc().
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+  uint64_t enqueued_ns; // When the message was pushed
+  uint32_t ip;
+  int32_t flow;    // Caller's flow handle
+  uint32_t result; // Filled in by the consumer of a request
+} SpscMessage;
+
+typedef struct {
+  SpscMessage *slots;
+  uint32_t mask;
+
+  // Producer side
+  uint32_t tail __attribute__((aligned(64)));
+  uint32_t head_cache;
+
+  // Consumer side
+  uint32_t head __attribute__((aligned(64)));
+  uint32_t tail_cache;
+} SpscQueue;
+
+// capacity must be a power of 2. Returns 0, or -1 if allocation fails.
+static inline int spsc_init(SpscQueue *queue, uint32_t capacity) {
+  queue->slots = malloc((size_t)capacity * sizeof(SpscMessage));
+  queue->mask = capacity - 1;
+  queue->tail = queue->head_cache = 0;
+  queue->head = queue->tail_cache = 0;
+  return queue->slots ? 0 : -1;
+}
+
+static inline void spsc_free(SpscQueue *queue) {
+  free(queue->slots);
+  queue->slots = NULL;
+}
+
+// Producer: returns 0, or -1 when the queue is full
+static inline int spsc_push(SpscQueue *queue, const SpscMessage *message) {
+  uint32_t tail = queue->tail;
+  if (tail - queue->head_cache > queue->mask) {
+    queue->head_cache = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - queue->head_cache > queue->mask) {
+      return -1;
+    }
+  }
+  queue->slots[tail & queue->mask] = *message;
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+// Consumer: returns 1 with the oldest message, or 0 when the queue is empty
+static inline int spsc_pop(SpscQueue *queue, SpscMessage *message) {
+  uint32_t head = queue->head;
+  if (head == queue->tail_cache) {
+    queue->tail_cache = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == queue->tail_cache) {
+      return 0;
+    }
+  }
+  *message = queue->slots[head & queue->mask];
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+#endif // DYNAFLOW_SPSC_QUEUE_H
@@ -0,0 +1,217 @@
+#ifndef DYNAFLOW_TIMING_WHEEL_H
+#define DYNAFLOW_TIMING_WHEEL_H
+
+// Hierarchical timing wheel over a fixed set of timer ids [0, capacity).
+//
+// TIMING_WHEEL_LEVELS levels of TIMING_WHEEL_SLOTS slots each; a level-L slot
+// spans SLOTS^L ticks. A timer is filed in the finest level that covers its
+// distance from the current tick, and when a coarser slot comes due its
+// timers cascade one level down. Advancing a tick touches one slot per level
+// at most, so expiry costs O(timers that fire + cascades) no matter how many
+// timers are armed. A coarse slot can hold many timers, so cascading is
+// budgeted: a due slot is staged in O(1) and re-filed a bounded number of
+// timers per advance, with the wheel holding its tick until it is drained.
+//
+// Lists are intrusive and doubly linked through a node array the caller
+// provides, with one sentinel node per slot, so arming and cancelling are
+// O(1) and never allocate. Links and due tick share a node, so visiting a
+// timer touches one cache line. Ticks are uint32_t and may wrap; a timer must be
+// due within 2^31 ticks.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMING_WHEEL_BITS 8
+#define TIMING_WHEEL_SLOTS (1u << TIMING_WHEEL_BITS)
+#define TIMING_WHEEL_LEVELS 3 // 2^24 ticks of range
+#define TIMING_WHEEL_MAX_DELAY                                                 \
+  ((1u << (TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS)) - 1)
+
+typedef struct {
+  int32_t next;
+  int32_t prev;
+  uint32_t expires; // Due tick (unused for sentinels)
+} TimingWheelNode;
+
+typedef struct {
+  TimingWheelNode *nodes; // timing_wheel_nodes(capacity) entries
+  int32_t capacity;
+  uint32_t now; // Next tick to process
+
+  uint64_t fired;
+  uint64_t cascaded;
+} TimingWheel;
+
+// Timers, then one sentinel per slot, then the expired and staged list
+// sentinels
+static inline size_t timing_wheel_nodes(int32_t capacity) {
+  return (size_t)capacity + TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS + 2;
+}
+
+static inline int32_t timing_wheel_expired_list(const TimingWheel *wheel) {
+  return wheel->capacity + TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS;
+}
+
+// Timers of due coarse slots waiting to cascade
+static inline int32_t timing_wheel_staged_list(const TimingWheel *wheel) {
+  return wheel->capacity + TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS + 1;
+}
+
+static inline void timing_wheel_init(TimingWheel *wheel, int32_t capacity,
+                                     TimingWheelNode *nodes, uint32_t now) {
+  wheel->nodes = nodes;
+  wheel->capacity = capacity;
+  wheel->now = now;
+  wheel->fired = 0;
+  wheel->cascaded = 0;
+  // Every node, timer or sentinel, starts as a self-loop: unarmed or empty
+  int32_t count = (int32_t)timing_wheel_nodes(capacity);
+  for (int32_t i = 0; i < count; i++) {
+    nodes[i].next = i;
+    nodes[i].prev = i;
+    nodes[i].expires = 0;
+  }
+}
+
+static inline int timing_wheel_armed(const TimingWheel *wheel, int32_t id) {
+  return wheel->nodes[id].next != id;
+}
+
+static inline void timing_wheel_unlink(TimingWheel *wheel, int32_t id) {
+  TimingWheelNode *node = &wheel->nodes[id];
+  wheel->nodes[node->prev].next = node->next;
+  wheel->nodes[node->next].prev = node->prev;
+  node->next = id;
+  node->prev = id;
+}
+
+static inline void timing_wheel_link_tail(TimingWheel *wheel, int32_t list,
+                                          int32_t id) {
+  int32_t tail = wheel->nodes[list].prev;
+  wheel->nodes[tail].next = id;
+  wheel->nodes[id].prev = tail;
+  wheel->nodes[id].next = list;
+  wheel->nodes[list].prev = id;
+}
+
+// Slot sentinel for a timer due at expires, relative to the current tick
+static inline int32_t timing_wheel_slot(const TimingWheel *wheel,
+                                        uint32_t expires) {
+  uint32_t delta = expires - wheel->now;
+  int level = 0;
+  while (level < TIMING_WHEEL_LEVELS - 1 &&
+         delta >= (1u << (TIMING_WHEEL_BITS * (level + 1)))) {
+    level++;
+  }
+  uint32_t slot =
+      (expires >> (TIMING_WHEEL_BITS * level)) & (TIMING_WHEEL_SLOTS - 1);
+  return wheel->capacity + level * (int32_t)TIMING_WHEEL_SLOTS + (int32_t)slot;
+}
+
+// Arm (or re-arm) timer id for tick expires. Ticks already processed fire on
+// the next advance; delays past the wheel's range are clamped to it.
+static inline void timing_wheel_schedule(TimingWheel *wheel, int32_t id,
+                                         uint32_t expires) {
+  if ((int32_t)(expires - wheel->now) < 0) {
+    expires = wheel->now;
+  } else if (expires - wheel->now > TIMING_WHEEL_MAX_DELAY) {
+    expires = wheel->now + TIMING_WHEEL_MAX_DELAY;
+  }
+  if (timing_wheel_armed(wheel, id)) {
+    timing_wheel_unlink(wheel, id);
+  }
+  wheel->nodes[id].expires = expires;
+  timing_wheel_link_tail(wheel, timing_wheel_slot(wheel, expires), id);
+}
+
+static inline void timing_wheel_cancel(TimingWheel *wheel, int32_t id) {
+  if (timing_wheel_armed(wheel, id)) {
+    timing_wheel_unlink(wheel, id);
+  }
+}
+
+// Append every timer of list from to list to, leaving from empty
+static inline void timing_wheel_splice(TimingWheel *wheel, int32_t from,
+                                       int32_t to) {
+  TimingWheelNode *head = &wheel->nodes[from];
+  if (head->next == from) {
+    return;
+  }
+  int32_t tail = wheel->nodes[to].prev;
+  wheel->nodes[tail].next = head->next;
+  wheel->nodes[head->next].prev = tail;
+  wheel->nodes[head->prev].next = to;
+  wheel->nodes[to].prev = head->prev;
+  head->next = from;
+  head->prev = from;
+}
+
+// Re-file up to budget staged timers relative to the current tick
+static inline int timing_wheel_cascade(TimingWheel *wheel, int budget) {
+  int32_t staged = timing_wheel_staged_list(wheel);
+  int moved = 0;
+  while (moved < budget) {
+    int32_t id = wheel->nodes[staged].next;
+    if (id == staged) {
+      break;
+    }
+    timing_wheel_unlink(wheel, id);
+    timing_wheel_link_tail(wheel,
+                           timing_wheel_slot(wheel, wheel->nodes[id].expires),
+                           id);
+    moved++;
+  }
+  wheel->cascaded += (uint64_t)moved;
+  return moved;
+}
+
+// Process ticks up to and including tick, cascading at most budget timers.
+// Due timers move to the expired list; drain it with
+// timing_wheel_pop_expired(). Returns the number of timers cascaded. If the
+// budget runs out mid-cascade the wheel stops short of tick (wheel->now <=
+// tick) and the next call resumes.
+static inline int timing_wheel_advance(TimingWheel *wheel, uint32_t tick,
+                                       int budget) {
+  int32_t expired = timing_wheel_expired_list(wheel);
+  int32_t staged = timing_wheel_staged_list(wheel);
+  int moved = 0;
+  while ((int32_t)(tick - wheel->now) >= 0) {
+    moved += timing_wheel_cascade(wheel, budget - moved);
+    if (wheel->nodes[staged].next != staged) {
+      break; // Budget spent; timers due now may still be staged
+    }
+
+    timing_wheel_splice(
+        wheel, wheel->capacity + (int32_t)(wheel->now & (TIMING_WHEEL_SLOTS - 1)),
+        expired);
+    wheel->now++;
+
+    // Entering a new block of a coarser level stages its timers
+    for (int level = 1; level < TIMING_WHEEL_LEVELS; level++) {
+      if ((wheel->now & ((1u << (TIMING_WHEEL_BITS * level)) - 1)) != 0) {
+        break;
+      }
+      timing_wheel_splice(
+          wheel,
+          wheel->capacity + level * (int32_t)TIMING_WHEEL_SLOTS +
+              (int32_t)((wheel->now >> (TIMING_WHEEL_BITS * level)) &
+                        (TIMING_WHEEL_SLOTS - 1)),
+          staged);
+    }
+  }
+  return moved;
+}
+
+// Next expired timer, now unarmed, or -1 when the list is empty
+static inline int32_t timing_wheel_pop_expired(TimingWheel *wheel) {
+  int32_t expired = timing_wheel_expired_list(wheel);
+  int32_t id = wheel->nodes[expired].next;
+  if (id == expired) {
+    return -1;
+  }
+  timing_wheel_unlink(wheel, id);
+  wheel->fired++;
+  return id;
+}
+
+#endif // DYNAFLOW_TIMING_WHEEL_H
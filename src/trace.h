@@ -0,0 +1,155 @@
+#ifndef DYNAFLOW_TRACE_H
+#define DYNAFLOW_TRACE_H
+
+// Dataset trace loaded into memory in one read:
+//
+//   known_count packet_count ip_range [ticks_per_second]
+//   known flow IPs                       (known_count lines)
+//   packet IPs                           (packet_count lines)
+//
+// With the optional fourth header field every packet line carries a second
+// column, the packet's timestamp in ticks_per_second units. Timestamps are
+// loaded as microseconds since the first packet; a timestamp earlier than
+// its predecessor is clamped to it, so packet time never runs backwards.
+//
+// The whole file is read with a single fread and parsed in place, which is
+// much faster than one fscanf per number on million-packet traces.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  int known_count;
+  int packet_count;
+  int ip_range;
+  int *known;      // known_count IPs
+  int *packets;    // packet_count IPs
+  uint64_t *times; // packet_count microseconds, or NULL without timestamps
+} Trace;
+
+// Parse the next non-negative integer up to max at or after *cursor
+static inline int trace_next_u64(const char **cursor, const char *end,
+                                 uint64_t max, uint64_t *value) {
+  const char *p = *cursor;
+  while (p < end && (*p < '0' || *p > '9')) {
+    if (*p == '-') {
+      return -1; // IPs, counts and timestamps are never negative
+    }
+    p++;
+  }
+  if (p == end) {
+    return -1;
+  }
+  uint64_t v = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    uint64_t digit = (uint64_t)(*p++ - '0');
+    if (v > (max - digit) / 10) {
+      return -1;
+    }
+    v = v * 10 + digit;
+  }
+  *value = v;
+  *cursor = p;
+  return 0;
+}
+
+static inline int trace_next_int(const char **cursor, const char *end,
+                                 int *value) {
+  uint64_t v;
+  if (trace_next_u64(cursor, end, 0x7fffffff, &v) != 0) {
+    return -1;
+  }
+  *value = (int)v;
+  return 0;
+}
+
+// Whether another field follows on the current line
+static inline int trace_line_continues(const char *cursor, const char *end) {
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+    cursor++;
+  }
+  return cursor < end && *cursor >= '0' && *cursor <= '9';
+}
+
+static inline void trace_free(Trace *trace) {
+  free(trace->known);
+  free(trace->packets);
+  free(trace->times);
+  trace->known = trace->packets = NULL;
+  trace->times = NULL;
+}
+
+// Load path into trace. Returns 0, or -1 with a message on stderr.
+static inline int trace_load(const char *path, Trace *trace) {
+  trace->known = trace->packets = NULL;
+  trace->times = NULL;
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  char *text = NULL;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0) {
+    size = ftell(f);
+  }
+  if (size >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+    text = malloc((size_t)size + 1);
+  }
+  int ok = text && fread(text, 1, (size_t)size, f) == (size_t)size;
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "%s: cannot read trace\n", path);
+    free(text);
+    return -1;
+  }
+
+  const char *cursor = text;
+  const char *end = text + size;
+  uint64_t ticks_per_second = 0;
+  ok = trace_next_int(&cursor, end, &trace->known_count) == 0 &&
+       trace_next_int(&cursor, end, &trace->packet_count) == 0 &&
+       trace_next_int(&cursor, end, &trace->ip_range) == 0;
+  if (ok && trace_line_continues(cursor, end)) {
+    ok = trace_next_u64(&cursor, end, UINT64_MAX, &ticks_per_second) == 0 &&
+         ticks_per_second > 0;
+  }
+  if (ok) {
+    trace->known = malloc(((size_t)trace->known_count + 1) * sizeof(int));
+    trace->packets = malloc(((size_t)trace->packet_count + 1) * sizeof(int));
+    ok = trace->known && trace->packets;
+  }
+  if (ok && ticks_per_second) {
+    trace->times =
+        malloc(((size_t)trace->packet_count + 1) * sizeof(uint64_t));
+    ok = trace->times != NULL;
+  }
+  for (int i = 0; ok && i < trace->known_count; i++) {
+    ok = trace_next_int(&cursor, end, &trace->known[i]) == 0;
+  }
+  double us_per_tick = 1e6 / (double)(ticks_per_second ? ticks_per_second : 1);
+  uint64_t first = 0;
+  uint64_t previous = 0;
+  for (int i = 0; ok && i < trace->packet_count; i++) {
+    ok = trace_next_int(&cursor, end, &trace->packets[i]) == 0;
+    if (ok && trace->times) {
+      uint64_t ticks = 0;
+      ok = trace_next_u64(&cursor, end, UINT64_MAX, &ticks) == 0;
+      if (i == 0) {
+        first = previous = ticks;
+      }
+      previous = ticks > previous ? ticks : previous;
+      trace->times[i] = (uint64_t)((double)(previous - first) * us_per_tick);
+    }
+  }
+  free(text);
+  if (!ok) {
+    fprintf(stderr, "%s: truncated or malformed trace\n", path);
+    trace_free(trace);
+    return -1;
+  }
+  return 0;
+}
+
+#endif // DYNAFLOW_TRACE_H
@@ -1,91 +1,81 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "baseline_engines.h"
+#include "trace.h"
+
 // Configuration for certain parameters
 static int NUM_PACKETS; // Total number of packets that's going to be simulated
 static int KNOWN_FLOWS_SIZE; // Total known number of flows in table
 static int IP_RANGE; // IP address range from (0 - IP_RANGE - 1 in this case 0 - 19999)
 
 
-// Simulated "expensive" operation (i.e the slow path)
-void deep_inspection(int ip) {
-    int count = 0;
-    for(int i = 1; i <= ip; i++) {
-        if(ip % i == 0) {
-            count++;
-        }
-    }
-}
-
-
-// Simulated "fast" operation 
-void fast_path_action(int ip) {
-    volatile int result = ip * 2;
-    (void)result;
+void print_usage(const char *program_name) {
+    printf("Usage: %s [--lookup <backend>] [--slow-path <kind[:cycles]>] "
+           "[dataset_file]\n\n", program_name);
+    printf("  dataset_file    Path to the dataset file (default: dataset.txt)\n");
+    printf("  --lookup        Known-flow lookup backend (default: linear)\n");
+    printf("  --slow-path     Slow-path workload (default: legacy)\n\n");
+    print_lookup_backends(stdout);
+    printf("\n");
+    print_slow_path_workloads(stdout);
 }
 
-// Check if ip is in the known flows table (linear search)
-
-int is_known_flow(int ip, int* known_flows) {
-    for(int i = 0; i < KNOWN_FLOWS_SIZE; i++) {
-        if(known_flows[i] == ip) {
-            return 1;
+int main(int argc, char *argv[]) {
+    const char *dataset_file = "dataset.txt";
+    LookupBackend backend = LOOKUP_LINEAR;
+    SlowPathKind slow_path = SLOW_PATH_LEGACY;
+    uint32_t slow_path_cycles = SLOW_PATH_DEFAULT_CYCLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--lookup") == 0 && i + 1 < argc) {
+            if (parse_lookup_backend(argv[++i], &backend) != 0) {
+                fprintf(stderr, "Unknown lookup backend: %s\n\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--slow-path") == 0 && i + 1 < argc) {
+            if (parse_slow_path(argv[++i], &slow_path, &slow_path_cycles) != 0) {
+                fprintf(stderr, "Invalid slow-path workload: %s\n\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            dataset_file = argv[i];
         }
     }
-    return 0;
-}
 
-int main() {
-      // Read from dataset.txt
-    FILE *fp = fopen("dataset.txt", "r");
-    if (!fp) {
-        perror("Error opening dataset.txt");
+    // Read from the dataset file
+    Trace trace;
+    if (trace_load(dataset_file, &trace) != 0) {
         return 1;
     }
+    KNOWN_FLOWS_SIZE = trace.known_count;
+    NUM_PACKETS = trace.packet_count;
+    IP_RANGE = trace.ip_range;
 
-    // 1) Read basic info
-    if (fscanf(fp, "%d %d %d", &KNOWN_FLOWS_SIZE, &NUM_PACKETS, &IP_RANGE) != 3) {
-        fprintf(stderr, "Error reading dataset header\n");
-        fclose(fp);
-        return 1;
-    }
-
-    // 2) Read known flows
-    int *known_flows = (int *)malloc(KNOWN_FLOWS_SIZE * sizeof(int));
+    // Known flows
+    FlowSet known_flows;
+    flowset_init(&known_flows, backend, KNOWN_FLOWS_SIZE, IP_RANGE);
     for (int i = 0; i < KNOWN_FLOWS_SIZE; i++) {
-        if (fscanf(fp, "%d", &known_flows[i]) != 1) {
-            fprintf(stderr, "Error reading known_flows\n");
-            fclose(fp);
-            return 1;
-        }
+        flowset_insert(&known_flows, trace.known[i]);
     }
 
-    // 3) Read packets
-    int *packets = (int *)malloc(NUM_PACKETS * sizeof(int));
-    for (int i = 0; i < NUM_PACKETS; i++) {
-        if (fscanf(fp, "%d", &packets[i]) != 1) {
-            fprintf(stderr, "Error reading packets\n");
-            fclose(fp);
-            return 1;
-        }
+    // Build and calibrate the slow-path workload before timing
+    SlowPathWorkload workload;
+    if (slow_path_init(&workload, slow_path, slow_path_cycles) != 0) {
+        return 1;
     }
-    fclose(fp);
-
-    // Metrics
-    long long slow_path_count = 0;
-    clock_t start = clock();
 
     // Process packets
-    for (int i = 0; i < NUM_PACKETS; i++) {
-        int ip = packets[i];
-        if (is_known_flow(ip, known_flows)) {
-            fast_path_action(ip);
-        } else {
-            deep_inspection(ip);
-            slow_path_count++;
-        }
-    }
+    clock_t start = clock();
+    long long slow_path_count = traditional_process(
+        &known_flows, &workload, trace.packets, NUM_PACKETS);
 
     clock_t end = clock();
     double total_time = (double)(end - start) / CLOCKS_PER_SEC;
@@ -93,10 +83,13 @@ int main() {
     printf("=== Traditional Approach ===\n");
     printf("Dataset: KNOWN_FLOWS_SIZE=%d, NUM_PACKETS=%d, IP_RANGE=%d\n",
            KNOWN_FLOWS_SIZE, NUM_PACKETS, IP_RANGE);
+    print_flowset(stdout, &known_flows);
+    print_slow_path_workload(stdout, &workload);
     printf("Slow path triggered: %lld times\n", slow_path_count);
     printf("Total time taken: %.3f seconds\n", total_time);
 
-    free(known_flows);
-    free(packets);
+    flowset_free(&known_flows);
+    slow_path_free(&workload);
+    trace_free(&trace);
     return 0;  
 }